@@ -28,6 +28,7 @@
 #endif
 
 #include <QtCore/QDebug>
+#include <QtCore/QSet>
 #include <ctime>
 
 Boomerang *Boomerang::boomerang = nullptr;
@@ -639,6 +640,12 @@ bool Boomerang::setOutputDirectory(const QString &path) {
 void Boomerang::objcDecode(const std::map<QString, ObjcModule> &modules, Prog *prog) {
     LOG_VERBOSE(1) << "Adding Objective-C information to Prog.\n";
     Module *root = prog->getRootCluster();
+    // There can be tens of thousands of methods, so the names in use are collected once (Prog::findProc(name)
+    // searches the whole program). The new procs are decoded later, together with all the other undecoded procs.
+    QSet<QString> procNames;
+    for (Module *m : *prog)
+        for (Function *f : *m)
+            procNames.insert(f->getName());
     for (auto &modules_it : modules) {
         const ObjcModule &mod = (modules_it).second;
         Module *module = prog->getOrInsertModule(mod.name);
@@ -654,11 +661,11 @@ void Boomerang::objcDecode(const std::map<QString, ObjcModule> &modules, Prog *p
                 const ObjcMethod &m = (_it2).second;
                 // TODO: parse :'s in names
                 QString method_name = m.name+"_"+m.types;
-                Function *existing = prog->findProc(method_name);
-                if(existing) {
+                if(procNames.contains(method_name)) {
                     assert(!"Name clash in objc processor ?");
                     continue;
                 }
+                procNames.insert(method_name);
                 Function *p = cl->getOrInsertFunction(method_name, m.addr);
                 p->setSignature(Signature::instantiate(prog->getFrontEndId(),CONV_C,method_name));
                 // TODO: decode types in m.types
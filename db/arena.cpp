@@ -0,0 +1,98 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/***************************************************************************/ /**
+  * \file arena.cpp
+  * \brief Implementation of the MemoryArena region allocator
+  ******************************************************************************/
+#include "arena.h"
+
+#include <cassert>
+#include <new>
+
+namespace {
+const size_t ARENA_ALIGN = alignof(std::max_align_t);
+const size_t ARENA_CHUNK_SIZE = 64 * 1024;
+
+size_t alignUp(size_t size) { return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1); }
+}
+
+thread_local MemoryArena *MemoryArena::Current = nullptr;
+bool MemoryArena::Placement = false;
+std::map<const char *, const char *> MemoryArena::ChunkRanges;
+
+MemoryArena::MemoryArena(const QString &name) : Name(name) {}
+
+MemoryArena::~MemoryArena() {
+    assert(Current != this);
+    release();
+}
+
+/***************************************************************************/ /**
+  * \brief Free all the chunks of this arena. Every object placed in the arena becomes invalid, so this must only
+  * be called when nothing refers to them any more. The counters are kept.
+  ******************************************************************************/
+void MemoryArena::release() {
+    for (char *chunk : Chunks) {
+        ChunkRanges.erase(chunk);
+        ::operator delete(chunk);
+    }
+    Chunks.clear();
+    Next = Limit = nullptr;
+    BytesReserved = 0;
+}
+
+void *MemoryArena::allocateHere(size_t size) {
+    size = alignUp(size);
+    if ((size_t)(Limit - Next) < size) {
+        // Objects larger than a chunk get a chunk of their own
+        size_t chunkSize = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        char *chunk = (char *)::operator new(chunkSize);
+        Chunks.push_back(chunk);
+        ChunkRanges[chunk] = chunk + chunkSize;
+        BytesReserved += chunkSize;
+        Next = chunk;
+        Limit = chunk + chunkSize;
+    }
+    void *res = Next;
+    Next += size;
+    return res;
+}
+
+/***************************************************************************/ /**
+  * \brief Allocation function for the class level operator new of Exp and Instruction
+  * \param size - size of the object
+  * \returns memory from the current arena if there is one and placement is enabled, else from the heap
+  ******************************************************************************/
+void *MemoryArena::allocate(size_t size) {
+    MemoryArena *arena = Current;
+    if (arena == nullptr)
+        return ::operator new(size);
+    arena->NumAllocs++;
+    arena->BytesAllocated += size;
+    if (!Placement)
+        return ::operator new(size);
+    return arena->allocateHere(size);
+}
+
+/***************************************************************************/ /**
+  * \brief Deallocation function for the class level operator delete of Exp and Instruction. Objects placed in an
+  * arena are left alone; their memory is freed when the arena is released.
+  ******************************************************************************/
+void MemoryArena::deallocate(void *p) {
+    if (p == nullptr)
+        return;
+    if (!ChunkRanges.empty()) {
+        auto it = ChunkRanges.upper_bound((const char *)p);
+        if (it != ChunkRanges.begin()) {
+            --it;
+            if ((const char *)p < it->second)
+                return;
+        }
+    }
+    ::operator delete(p);
+}
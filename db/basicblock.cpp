@@ -602,7 +602,7 @@ Function *BasicBlock::getCallDestProc() {
 //
 // Get First/Next Statement in a BB
 //
-Instruction *BasicBlock::getFirstStmt(rtlit &rit, StatementList::iterator &sit) {
+Instruction *BasicBlock::getFirstStmt(rtlit &rit, stmtit &sit) {
     if (ListOfRTLs == nullptr || ListOfRTLs->empty())
         return nullptr;
     rit = ListOfRTLs->begin();
@@ -616,7 +616,7 @@ Instruction *BasicBlock::getFirstStmt(rtlit &rit, StatementList::iterator &sit)
     return nullptr;
 }
 
-Instruction *BasicBlock::getNextStmt(rtlit &rit, StatementList::iterator &sit) {
+Instruction *BasicBlock::getNextStmt(rtlit &rit, stmtit &sit) {
     if (++sit != (*rit)->end())
         return *sit; // End of current RTL not reached, so return next
                      // Else, find next non-empty RTL & return its first statement
@@ -628,7 +628,7 @@ Instruction *BasicBlock::getNextStmt(rtlit &rit, StatementList::iterator &sit) {
     return *sit;               // Return first statement
 }
 
-Instruction *BasicBlock::getPrevStmt(rtlrit &rit, StatementList::reverse_iterator &sit) {
+Instruction *BasicBlock::getPrevStmt(rtlrit &rit, stmtrit &sit) {
     if (++sit != (*rit)->rend())
         return *sit; // Beginning of current RTL not reached, so return next
                      // Else, find prev non-empty RTL & return its last statement
@@ -640,7 +640,7 @@ Instruction *BasicBlock::getPrevStmt(rtlrit &rit, StatementList::reverse_iterato
     return *sit;               // Return last statement
 }
 
-Instruction *BasicBlock::getLastStmt(rtlrit &rit, StatementList::reverse_iterator &sit) {
+Instruction *BasicBlock::getLastStmt(rtlrit &rit, stmtrit &sit) {
     if (ListOfRTLs == nullptr)
         return nullptr;
     rit = ListOfRTLs->rbegin();
@@ -1539,7 +1539,7 @@ bool BasicBlock::calcLiveness(ConnectionGraph &ig, UserProc *myProc) {
     std::list<RTL *>::reverse_iterator rit;
     if (ListOfRTLs) // this can be nullptr
         for (rit = ListOfRTLs->rbegin(); rit != ListOfRTLs->rend(); ++rit) {
-            std::list<Instruction *>::reverse_iterator sit;
+            RTL::reverse_iterator sit;
             // For each statement this RTL
             for (sit = (*rit)->rbegin(); sit != (*rit)->rend(); ++sit) {
                 Instruction *s = *sit;
@@ -1593,9 +1593,18 @@ bool BasicBlock::calcLiveness(ConnectionGraph &ig, UserProc *myProc) {
 // successors
 void BasicBlock::getLiveOut(LocationSet &liveout, LocationSet &phiLocs) {
     liveout.clear();
-    for (BasicBlock *currBB : OutEdges) {
-        // First add the non-phi liveness
+    // First add the non-phi liveness
+    for (BasicBlock *currBB : OutEdges)
         liveout.makeUnion(currBB->LiveIn); // add successor liveIn to this liveout set.
+    getPhiLiveOut(phiLocs);
+    liveout.makeUnion(phiLocs);
+}
+
+// The locations live at the end of this BB because of phi statements at the top of its successors: for each phi, its
+// base variable subscripted with the definition that reaches it from this BB. These do not depend on liveness, so the
+// bit vector version of Cfg::findInterferences() finds them only once for each BB
+void BasicBlock::getPhiLiveOut(LocationSet &phiLocs) {
+    for (BasicBlock *currBB : OutEdges) {
         // The first RTL will have the phi functions, if any
         if (currBB->ListOfRTLs == nullptr || currBB->ListOfRTLs->size() == 0)
             continue;
@@ -1636,7 +1645,6 @@ void BasicBlock::getLiveOut(LocationSet &liveout, LocationSet &phiLocs) {
                 }
             }
             Exp *r = RefExp::get(pa->getLeft()->clone(), def);
-            liveout.insert(r);
             phiLocs.insert(r);
             if (DEBUG_LIVENESS)
                 LOG << " ## Liveness: adding " << r << " due to ref to phi " << st << " in BB at " << getLowAddr()
@@ -1891,7 +1899,7 @@ bool BasicBlock::decodeIndirectJmp(UserProc *proc) {
 #define CHECK_REAL_PHI_LOOPS 0
 #if CHECK_REAL_PHI_LOOPS
     rtlit rit;
-    StatementList::iterator sit;
+    stmtit sit;
     Statement *s = getFirstStmt(rit, sit);
     for (s = getFirstStmt(rit, sit); s; s = getNextStmt(rit, sit)) {
         if (!s->isPhi())
@@ -2303,11 +2311,11 @@ bool BasicBlock::undoComputedBB(Instruction *stmt) {
   * in reverse nesting order. The search is optionally type sensitive.
   * \note out of date doc, unless type senistivity is a part of \a search_for ?
   * \param search_for - a location to search for
-  * \param results - a list which will have any matching exprs
+  * \param results - will have any matching exprs
   *                 appended to it
   * \returns true if there were any matches
   ******************************************************************************/
-bool BasicBlock::searchAll(const Exp &search_for, std::list<Exp *> &results) {
+bool BasicBlock::searchAll(const Exp &search_for, ExpMatches &results) {
     bool ch = false;
     for (RTL *rtl_it : *ListOfRTLs) {
         for (Instruction *e : *rtl_it) {
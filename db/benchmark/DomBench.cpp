@@ -0,0 +1,170 @@
+/***************************************************************************/ /**
+  * \file       DomBench.cpp
+  * OVERVIEW:   Dominator benchmark. A fixed, pseudo random CFG (a chain of BBs with branches back to earlier BBs, so
+  *             there are nested loops, and forward to later ones) is given to DataFlow::dominators(), which finds the
+  *             immediate dominators and the dominance frontiers. The time taken per BB is reported, and the
+  *             immediate dominators are checked against the simple iterative algorithm of Cooper, Harvey and Kennedy.
+  *
+  *             usage: DomBench [-n count] [-s seed] [-r repeat_count]
+  ******************************************************************************/
+#include "types.h"
+#include "rtl.h"
+#include "cfg.h"
+#include "basicblock.h"
+#include "dataflow.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <list>
+#include <utility>
+#include <vector>
+
+//! Small deterministic generator, so every run uses the same CFG
+class Generator {
+  public:
+    explicit Generator(uint32_t seed) : State(seed ? seed : 1) {}
+    uint32_t next() {
+        State ^= State << 13;
+        State ^= State >> 17;
+        State ^= State << 5;
+        return State;
+    }
+
+  private:
+    uint32_t State;
+};
+
+static void makeCfg(Cfg &cfg, int count, uint32_t seed) {
+    Generator gen(seed);
+    std::vector<BasicBlock *> bbs;
+    for (int i = 0; i < count; i++) {
+        std::list<RTL *> *rtls = new std::list<RTL *>;
+        rtls->push_back(new RTL(ADDRESS::g(0x10000 + 4 * i)));
+        if (i == count - 1)
+            bbs.push_back(cfg.newBB(rtls, BBTYPE::RET, 0));
+        else if (gen.next() % 2)
+            bbs.push_back(cfg.newBB(rtls, BBTYPE::TWOWAY, 2));
+        else
+            bbs.push_back(cfg.newBB(rtls, BBTYPE::FALL, 1));
+    }
+    for (int i = 0; i < count - 1; i++) {
+        if (bbs[i]->getType() == BBTYPE::TWOWAY) {
+            // Mostly short loops, sometimes a jump forward
+            int dist = 1 + gen.next() % 16;
+            int dest = gen.next() % 4 ? std::max(0, i - dist) : std::min(count - 1, i + dist);
+            cfg.addOutEdge(bbs[i], bbs[dest]);
+        }
+        cfg.addOutEdge(bbs[i], bbs[i + 1]);
+    }
+    cfg.setEntryBB(bbs[0]);
+}
+
+//! The immediate dominators by iterating to a fixed point (Cooper, Harvey and Kennedy 2001)
+static std::vector<int> iterativeIdoms(DataFlow &df, int numBB) {
+    // Reverse postorder from node 0
+    std::vector<int> order, rpoNum(numBB, -1);
+    std::vector<bool> seen(numBB, false);
+    std::vector<std::pair<int, size_t>> stack;
+    stack.emplace_back(0, 0);
+    seen[0] = true;
+    while (!stack.empty()) {
+        int n = stack.back().first;
+        const std::vector<BasicBlock *> &outEdges = df.nodeToBB(n)->getOutEdges();
+        if (stack.back().second == outEdges.size()) {
+            order.push_back(n);
+            stack.pop_back();
+            continue;
+        }
+        int w = df.pbbToNode(outEdges[stack.back().second++]);
+        if (!seen[w]) {
+            seen[w] = true;
+            stack.emplace_back(w, 0);
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    for (size_t i = 0; i < order.size(); i++)
+        rpoNum[order[i]] = i;
+
+    std::vector<int> idom(numBB, -1);
+    idom[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < order.size(); i++) {
+            int b = order[i];
+            int newIdom = -1;
+            for (BasicBlock *pred : df.nodeToBB(b)->getInEdges()) {
+                int p = df.pbbToNode(pred);
+                if (idom[p] == -1)
+                    continue;
+                if (newIdom == -1) {
+                    newIdom = p;
+                    continue;
+                }
+                int f1 = p, f2 = newIdom; // Intersect
+                while (f1 != f2) {
+                    while (rpoNum[f1] > rpoNum[f2])
+                        f1 = idom[f1];
+                    while (rpoNum[f2] > rpoNum[f1])
+                        f2 = idom[f2];
+                }
+                newIdom = f1;
+            }
+            if (idom[b] != newIdom) {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+    idom[0] = -1;
+    return idom;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    int count = 100000;
+    int repeat = 5;
+    uint32_t seed = 1;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        if (args[i] == "-n" && i + 1 < args.size())
+            count = std::max(2, args[++i].toInt());
+        else if (args[i] == "-s" && i + 1 < args.size())
+            seed = args[++i].toUInt();
+        else if (args[i] == "-r" && i + 1 < args.size())
+            repeat = std::max(1, args[++i].toInt());
+        else {
+            out << "usage: " << args[0] << " [-n count] [-s seed] [-r repeat_count]\n";
+            return 1;
+        }
+    }
+
+    Cfg cfg;
+    makeCfg(cfg, count, seed);
+    DataFlow df;
+    qint64 nsecs = 0;
+    QElapsedTimer timer;
+    for (int i = 0; i < repeat; i++) {
+        timer.start();
+        df.dominators(&cfg);
+        nsecs += timer.nsecsElapsed();
+    }
+    size_t dfSize = 0;
+    for (int n = 0; n < count; n++)
+        dfSize += df.getDF(n).size();
+    out << "dominators and frontiers: " << nsecs / (qint64(count) * repeat) << " ns/BB, ";
+    out << dfSize << " frontier entries\n";
+
+    std::vector<int> expected = iterativeIdoms(df, count);
+    for (int n = 0; n < count; n++) {
+        if (df.getIdom(n) != expected[n]) {
+            out << "error: wrong immediate dominator for node " << n << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
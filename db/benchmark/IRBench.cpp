@@ -0,0 +1,145 @@
+/***************************************************************************/ /**
+  * \file       IRBench.cpp
+  * OVERVIEW:   Binary IR encoding benchmark. A fixed, pseudo random set of RTLs is written with BinaryIRWriter and
+  *             read back with BinaryIRReader, and written as XML by XMLProgParser for comparison. The size of each
+  *             encoding and the number of RTLs per second are reported. Every RTL read back is checked against the
+  *             original.
+  *
+  *             usage: IRBench [-n count] [-s seed] [-r repeat_count]
+  ******************************************************************************/
+#include "types.h"
+#include "exp.h"
+#include "statement.h"
+#include "rtl.h"
+#include "binaryir.h"
+#include "xmlprogparser.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <QXmlStreamWriter>
+#include <algorithm>
+#include <vector>
+
+//! Small deterministic generator, so every run encodes the same RTLs
+class ExpGenerator {
+  public:
+    explicit ExpGenerator(uint32_t seed) : State(seed ? seed : 1) {}
+    Exp *generate(int depth);
+    uint32_t next() {
+        State ^= State << 13;
+        State ^= State >> 17;
+        State ^= State << 5;
+        return State;
+    }
+
+  private:
+    uint32_t State;
+};
+
+//! Expressions like m[r28 + 4] + r24, as decoded instructions have
+Exp *ExpGenerator::generate(int depth) {
+    if (depth == 0 || next() % 4 == 0) {
+        switch (next() % 3) {
+        case 0:
+            return Location::regOf(24 + next() % 8);
+        case 1:
+            return Location::memOf(Binary::get(opPlus, Location::regOf(28), new Const(int(next() % 16) * 4)));
+        default:
+            return new Const(int(next() % 256));
+        }
+    }
+    static const OPER binOps[] = {opPlus, opMinus, opMult, opBitAnd, opBitOr};
+    if (next() % 4 == 0)
+        return Location::memOf(generate(depth - 1));
+    return Binary::get(binOps[next() % (sizeof(binOps) / sizeof(binOps[0]))], generate(depth - 1),
+                       generate(depth - 1));
+}
+
+static void report(QTextStream &out, const QString &name, int count, int repeat, qint64 nsecs, int size) {
+    double secs = nsecs / 1e9;
+    out << qSetFieldWidth(16) << left << name << qSetFieldWidth(0) << right;
+    out << " RTLs/s " << (secs > 0 ? qint64(double(count) * repeat / secs) : 0);
+    if (size >= 0)
+        out << " bytes/RTL " << double(size) / count;
+    out << "\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    int count = 20000;
+    int repeat = 5;
+    uint32_t seed = 1;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        if (args[i] == "-n" && i + 1 < args.size())
+            count = std::max(1, args[++i].toInt());
+        else if (args[i] == "-s" && i + 1 < args.size())
+            seed = args[++i].toUInt();
+        else if (args[i] == "-r" && i + 1 < args.size())
+            repeat = std::max(1, args[++i].toInt());
+        else {
+            out << "usage: " << args[0] << " [-n count] [-s seed] [-r repeat_count]\n";
+            return 1;
+        }
+    }
+
+    ExpGenerator gen(seed);
+    std::vector<RTL *> rtls;
+    for (int i = 0; i < count; i++) {
+        RTL *rtl = new RTL(ADDRESS::g(0x8048000 + 4 * i));
+        unsigned n = 1 + gen.next() % 3;
+        for (unsigned j = 0; j < n; j++)
+            rtl->push_back(new Assign(IntegerType::get(32), Location::regOf(24 + gen.next() % 8), gen.generate(4)));
+        rtls.push_back(rtl);
+    }
+
+    BinaryIRWriter writer;
+    qint64 writeNsecs = 0, readNsecs = 0, xmlNsecs = 0;
+    int xmlSize = 0;
+    QElapsedTimer timer;
+    for (int i = 0; i < repeat; i++) {
+        writer.clear();
+        timer.start();
+        for (RTL *rtl : rtls)
+            writer.write(rtl);
+        writeNsecs += timer.nsecsElapsed();
+
+        std::vector<RTL *> read;
+        read.reserve(count);
+        timer.start();
+        BinaryIRReader reader(writer.data().constData(), writer.data().size());
+        while (!reader.atEnd() && reader.isOk())
+            read.push_back(reader.readRTL());
+        readNsecs += timer.nsecsElapsed();
+        if (!reader.isOk() || read.size() != rtls.size()) {
+            out << "error: the binary encoding could not be read back\n";
+            return 1;
+        }
+        if (i == 0) {
+            for (int j = 0; j < count; j++) {
+                QString readBack(read[j]->prints());
+                if (readBack != rtls[j]->prints()) {
+                    out << "error: RTL " << j << " differs after a round trip\n";
+                    return 1;
+                }
+            }
+        }
+
+        QByteArray xml;
+        XMLProgParser parser;
+        timer.start();
+        QXmlStreamWriter xmlOut(&xml);
+        for (RTL *rtl : rtls)
+            parser.persistToXML(xmlOut, rtl);
+        xmlNsecs += timer.nsecsElapsed();
+        xmlSize = xml.size();
+    }
+    report(out, "binary write", count, repeat, writeNsecs, writer.data().size());
+    report(out, "binary read", count, repeat, readNsecs, -1);
+    report(out, "XML write", count, repeat, xmlNsecs, xmlSize);
+    return 0;
+}
@@ -0,0 +1,117 @@
+/***************************************************************************/ /**
+  * \file       RtlIterBench.cpp
+  * OVERVIEW:   RTL statement iteration benchmark. A fixed, pseudo random set of basic blocks' worth of RTLs is swept
+  *             the way liveness and propagation sweep them: every statement of every RTL, collecting the locations
+  *             it uses. The same statements are also swept from per-RTL std::lists (how RTLs used to store them), so
+  *             the cost of the storage alone can be compared.
+  *
+  *             usage: RtlIterBench [-n count] [-s seed] [-r repeat_count]
+  ******************************************************************************/
+#include "types.h"
+#include "exp.h"
+#include "statement.h"
+#include "rtl.h"
+#include "managed.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <list>
+#include <vector>
+
+//! Small deterministic generator, so every run sweeps the same statements
+class ExpGenerator {
+  public:
+    explicit ExpGenerator(uint32_t seed) : State(seed ? seed : 1) {}
+    Exp *generate(int depth);
+    uint32_t next() {
+        State ^= State << 13;
+        State ^= State >> 17;
+        State ^= State << 5;
+        return State;
+    }
+
+  private:
+    uint32_t State;
+};
+
+Exp *ExpGenerator::generate(int depth) {
+    if (depth == 0 || next() % 3 == 0) {
+        if (next() % 2)
+            return Location::regOf(24 + next() % 8);
+        return new Const(int(next() % 256));
+    }
+    if (next() % 4 == 0)
+        return Location::memOf(generate(depth - 1));
+    return Binary::get(next() % 2 ? opPlus : opMinus, generate(depth - 1), generate(depth - 1));
+}
+
+//! One sweep over the statements; returns the number of used locations found, so the work is not optimised away
+template <class Rtls> static size_t sweep(const Rtls &rtls) {
+    size_t found = 0;
+    for (const auto &rtl : rtls) {
+        for (Instruction *s : rtl) {
+            LocationSet used;
+            s->addUsedLocs(used);
+            found += used.size();
+        }
+    }
+    return found;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    int count = 50000;
+    int repeat = 5;
+    uint32_t seed = 1;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        if (args[i] == "-n" && i + 1 < args.size())
+            count = std::max(1, args[++i].toInt());
+        else if (args[i] == "-s" && i + 1 < args.size())
+            seed = args[++i].toUInt();
+        else if (args[i] == "-r" && i + 1 < args.size())
+            repeat = std::max(1, args[++i].toInt());
+        else {
+            out << "usage: " << args[0] << " [-n count] [-s seed] [-r repeat_count]\n";
+            return 1;
+        }
+    }
+
+    // Most RTLs hold one to three statements
+    ExpGenerator gen(seed);
+    std::vector<RTL> rtls(count);
+    std::vector<std::list<Instruction *>> lists(count);
+    for (int i = 0; i < count; i++) {
+        unsigned n = 1 + gen.next() % 3;
+        for (unsigned j = 0; j < n; j++) {
+            Instruction *s = new Assign(Location::regOf(24 + gen.next() % 8), gen.generate(3));
+            rtls[i].push_back(s);
+            lists[i].push_back(s);
+        }
+    }
+
+    qint64 rtlNsecs = 0, listNsecs = 0;
+    size_t rtlFound = 0, listFound = 0;
+    QElapsedTimer timer;
+    for (int i = 0; i < repeat; i++) {
+        timer.start();
+        rtlFound += sweep(rtls);
+        rtlNsecs += timer.nsecsElapsed();
+        timer.start();
+        listFound += sweep(lists);
+        listNsecs += timer.nsecsElapsed();
+    }
+    out << "RTL (vector) sweep: " << rtlNsecs / (qint64(count) * repeat) << " ns/RTL\n";
+    out << "std::list sweep:    " << listNsecs / (qint64(count) * repeat) << " ns/RTL\n";
+    for (std::list<Instruction *> &l : lists)
+        l.clear(); // The statements belong to the RTLs
+    if (rtlFound != listFound) {
+        out << "error: the two sweeps give different results\n";
+        return 1;
+    }
+    return 0;
+}
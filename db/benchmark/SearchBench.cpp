@@ -0,0 +1,152 @@
+/***************************************************************************/ /**
+  * \file       SearchBench.cpp
+  * OVERVIEW:   Expression search benchmark. A fixed, pseudo random set of assignments is searched for a register
+  *             pattern, collecting the matches in a std::list (the old searchAll), in an ExpMatches, and stopping
+  *             at the first match with searchEach. The time taken, the number of matches, and the number of heap
+  *             allocations made during each search are reported.
+  *
+  *             usage: SearchBench [-n count] [-s seed] [-r repeat_count]
+  ******************************************************************************/
+#include "types.h"
+#include "exp.h"
+#include "statement.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static uint64_t numAllocs = 0; //!< Calls of operator new since the start of the program
+
+void *operator new(size_t size) {
+    numAllocs++;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+
+//! Small deterministic generator, so every run searches the same statements
+class ExpGenerator {
+  public:
+    explicit ExpGenerator(uint32_t seed) : State(seed ? seed : 1) {}
+    Exp *generate(int depth);
+
+  private:
+    uint32_t next() {
+        State ^= State << 13;
+        State ^= State >> 17;
+        State ^= State << 5;
+        return State;
+    }
+    uint32_t State;
+};
+
+//! Expressions like m[r28 + 4] + r24, so there are a few register matches in most of them
+Exp *ExpGenerator::generate(int depth) {
+    if (depth == 0 || next() % 4 == 0) {
+        switch (next() % 3) {
+        case 0:
+            return Location::regOf(24 + next() % 8);
+        case 1:
+            return Location::memOf(Binary::get(opPlus, Location::regOf(28), new Const(int(next() % 16) * 4)));
+        default:
+            return new Const(int(next() % 256));
+        }
+    }
+    static const OPER binOps[] = {opPlus, opMinus, opMult, opBitAnd, opBitOr};
+    if (next() % 4 == 0)
+        return Location::memOf(generate(depth - 1));
+    return Binary::get(binOps[next() % (sizeof(binOps) / sizeof(binOps[0]))], generate(depth - 1),
+                       generate(depth - 1));
+}
+
+struct BenchStats {
+    uint64_t numMatches = 0;
+    uint64_t numAllocs = 0;
+    qint64 nsecs = 0;
+};
+
+static void report(QTextStream &out, const QString &name, int count, int repeat, const BenchStats &stats) {
+    double secs = stats.nsecs / 1e9;
+    out << qSetFieldWidth(24) << left << name << qSetFieldWidth(0) << right;
+    out << " stmts/s " << (secs > 0 ? qint64(double(count) * repeat / secs) : 0);
+    out << " matches " << stats.numMatches;
+    out << " allocs/stmt " << double(stats.numAllocs) / (double(count) * repeat) << "\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    int count = 100000;
+    int repeat = 5;
+    uint32_t seed = 1;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        if (args[i] == "-n" && i + 1 < args.size())
+            count = std::max(1, args[++i].toInt());
+        else if (args[i] == "-s" && i + 1 < args.size())
+            seed = args[++i].toUInt();
+        else if (args[i] == "-r" && i + 1 < args.size())
+            repeat = std::max(1, args[++i].toInt());
+        else {
+            out << "usage: " << args[0] << " [-n count] [-s seed] [-r repeat_count]\n";
+            return 1;
+        }
+    }
+
+    ExpGenerator gen(seed);
+    std::vector<Instruction *> stmts;
+    for (int i = 0; i < count; i++)
+        stmts.push_back(new Assign(Location::regOf(24 + i % 8), gen.generate(4)));
+    Location pattern(opRegOf, Terminal::get(opWild), nullptr);
+
+    BenchStats list, matches, first;
+    QElapsedTimer timer;
+    for (int i = 0; i < repeat; i++) {
+        uint64_t allocs = numAllocs;
+        timer.start();
+        for (Instruction *s : stmts) {
+            std::list<Exp *> result;
+            s->searchAll(pattern, result);
+            list.numMatches += result.size();
+        }
+        list.nsecs += timer.nsecsElapsed();
+        list.numAllocs += numAllocs - allocs;
+
+        allocs = numAllocs;
+        timer.start();
+        for (Instruction *s : stmts) {
+            ExpMatches result;
+            s->searchAll(pattern, result);
+            matches.numMatches += result.size();
+        }
+        matches.nsecs += timer.nsecsElapsed();
+        matches.numAllocs += numAllocs - allocs;
+
+        allocs = numAllocs;
+        timer.start();
+        for (Instruction *s : stmts) {
+            auto stop = searchWith([&first](Exp *) {
+                first.numMatches++;
+                return false;
+            });
+            s->searchEach(pattern, stop);
+        }
+        first.nsecs += timer.nsecsElapsed();
+        first.numAllocs += numAllocs - allocs;
+    }
+    report(out, "searchAll, std::list", count, repeat, list);
+    report(out, "searchAll, ExpMatches", count, repeat, matches);
+    report(out, "searchEach, first match", count, repeat, first);
+    if (list.numMatches != matches.numMatches) {
+        out << "error: the two searchAll overloads give different results\n";
+        return 1;
+    }
+    return 0;
+}
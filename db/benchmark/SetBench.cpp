@@ -0,0 +1,136 @@
+/***************************************************************************/ /**
+  * \file       SetBench.cpp
+  * OVERVIEW:   Set representation benchmark. Fixed, pseudo random sets of statements and of locations are combined
+  *             the way liveness combines them (union, difference, subset test), once as InstructionSets and
+  *             LocationSets and once as BitSets, and the time per set operation is reported for each.
+  *
+  *             usage: SetBench [-n statement_count] [-k sets] [-s seed] [-r repeat_count]
+  ******************************************************************************/
+#include "types.h"
+#include "exp.h"
+#include "statement.h"
+#include "managed.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <vector>
+
+//! Small deterministic generator, so every run uses the same sets
+class Generator {
+  public:
+    explicit Generator(uint32_t seed) : State(seed ? seed : 1) {}
+    uint32_t next() {
+        State ^= State << 13;
+        State ^= State >> 17;
+        State ^= State << 5;
+        return State;
+    }
+
+  private:
+    uint32_t State;
+};
+
+//! One pass: each set is unioned into an accumulator, the next set is subtracted, and the subset relation tested.
+//! Returns a checksum so the two representations can be compared.
+template <class Set> static size_t combine(std::vector<Set> &sets) {
+    size_t check = 0;
+    for (size_t i = 0; i + 1 < sets.size(); i++) {
+        Set acc = sets[i];
+        acc.makeUnion(sets[i + 1]);
+        check += sets[i].isSubSetOf(acc);
+        acc.makeDiff(sets[i + 1]);
+        check += acc.size();
+    }
+    return check;
+}
+
+static void report(QTextStream &out, const QString &name, size_t ops, qint64 nsecs) {
+    out << qSetFieldWidth(16) << left << name << qSetFieldWidth(0) << right;
+    out << " ns/set operation " << (ops ? nsecs / qint64(ops) : 0) << "\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    int numStmts = 5000;
+    int numSets = 500;
+    int repeat = 5;
+    uint32_t seed = 1;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        if (args[i] == "-n" && i + 1 < args.size())
+            numStmts = std::max(1, args[++i].toInt());
+        else if (args[i] == "-k" && i + 1 < args.size())
+            numSets = std::max(2, args[++i].toInt());
+        else if (args[i] == "-s" && i + 1 < args.size())
+            seed = args[++i].toUInt();
+        else if (args[i] == "-r" && i + 1 < args.size())
+            repeat = std::max(1, args[++i].toInt());
+        else {
+            out << "usage: " << args[0] << " [-n statement_count] [-k sets] [-s seed] [-r repeat_count]\n";
+            return 1;
+        }
+    }
+
+    Generator gen(seed);
+    std::vector<Instruction *> byNumber(numStmts + 1, nullptr);
+    for (int n = 1; n <= numStmts; n++) {
+        byNumber[n] = new Assign(Location::regOf(24 + n % 8), new Const(n));
+        byNumber[n]->setNumber(n);
+    }
+    // Statement sets of a few percent of the statements, like the reaching definitions at a block
+    std::vector<InstructionSet> stmtSets(numSets);
+    std::vector<BitSet> stmtBits(numSets);
+    for (int i = 0; i < numSets; i++) {
+        for (int j = numStmts / 20; j > 0; j--)
+            stmtSets[i].insert(byNumber[1 + gen.next() % numStmts]);
+        stmtSets[i].toBits(stmtBits[i]);
+    }
+    // Location sets of registers and stack locations, like the live locations at a block
+    LocationNumbering numbering;
+    std::vector<LocationSet> locSets(numSets);
+    std::vector<BitSet> locBits(numSets);
+    for (int i = 0; i < numSets; i++) {
+        for (int j = 0; j < 40; j++) {
+            uint32_t r = gen.next() % 96;
+            if (r < 32)
+                locSets[i].insert(Location::regOf(r));
+            else
+                locSets[i].insert(
+                    Location::memOf(Binary::get(opMinus, Location::regOf(28), new Const(int(r - 32) * 4))));
+        }
+        numbering.toBits(locSets[i], locBits[i]);
+    }
+
+    qint64 times[4] = {0, 0, 0, 0};
+    size_t checks[4] = {0, 0, 0, 0};
+    QElapsedTimer timer;
+    for (int i = 0; i < repeat; i++) {
+        timer.start();
+        checks[0] += combine(stmtSets);
+        times[0] += timer.nsecsElapsed();
+        timer.start();
+        checks[1] += combine(stmtBits);
+        times[1] += timer.nsecsElapsed();
+        timer.start();
+        checks[2] += combine(locSets);
+        times[2] += timer.nsecsElapsed();
+        timer.start();
+        checks[3] += combine(locBits);
+        times[3] += timer.nsecsElapsed();
+    }
+    size_t ops = size_t(numSets - 1) * 4 * repeat;
+    report(out, "InstructionSet", ops, times[0]);
+    report(out, "statement BitSet", ops, times[1]);
+    report(out, "LocationSet", ops, times[2]);
+    report(out, "location BitSet", ops, times[3]);
+    if (checks[0] != checks[1] || checks[2] != checks[3]) {
+        out << "error: the set representations give different results\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,899 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/***************************************************************************/ /**
+  * \file       binaryir.cpp
+  * OVERVIEW:   Implementation of the BinaryIRWriter and BinaryIRReader classes.
+  ******************************************************************************/
+
+#include "binaryir.h"
+
+#include "exp.h"
+#include "statement.h"
+#include "rtl.h"
+#include "type.h"
+#include "proc.h"
+#include "prog.h"
+#include "cfg.h"
+#include "basicblock.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace {
+//! Tag byte of an expression node
+enum ExpTag : uint8_t {
+    E_NULL = 0,
+    E_BACKREF,  // Number of a node already written
+    E_INT,      // Zigzag value, conscript and type
+    E_LONG,     // Value, conscript and type
+    E_FLT,      // 8 byte IEEE value, conscript and type
+    E_STR,      // String, conscript and type
+    E_FUNC,     // Name of the function, conscript and type
+    E_TERMINAL, // Operator
+    E_UNARY,    // Operator, subexpression
+    E_BINARY,   // Operator, 2 subexpressions
+    E_TERNARY,  // Operator, 3 subexpressions
+    E_LOCATION, // Operator, procedure name, subexpression
+    E_REF,      // Definition, subexpression
+    E_TYPED,    // Type, subexpression
+    E_FLAGDEF,  // RTL, parameter list
+    E_TYPEVAL   // Type
+};
+
+//! Tag byte of a type
+enum TypeTag : uint8_t {
+    T_NULL = 0,
+    T_VOID,
+    T_BOOLEAN,
+    T_CHAR,
+    T_INTEGER,  // Size, signedness
+    T_FLOAT,    // Size
+    T_POINTER,  // Pointed to type
+    T_ARRAY,    // Base type, length
+    T_NAMED,    // Name
+    T_COMPOUND, // Generic flag, number of members, then type and name of each
+    T_UNION,    // Number of members, then type and name of each
+    T_SIZE,     // Size
+    T_UPPER,    // Base type
+    T_LOWER     // Base type
+};
+} // namespace
+
+//    //    //    //    //    //
+//     BinaryIRWriter    //
+//    //    //    //    //    //
+
+//! Forget everything written so far
+void BinaryIRWriter::clear() {
+    Buf.clear();
+    ExpIds.clear();
+    Ok = true;
+}
+
+void BinaryIRWriter::writeVarint(uint64_t v) {
+    while (v >= 0x80) {
+        writeByte(uint8_t(v) | 0x80);
+        v >>= 7;
+    }
+    writeByte(uint8_t(v));
+}
+
+void BinaryIRWriter::writeString(const QString &s) {
+    QByteArray utf8 = s.toUtf8();
+    writeVarint(utf8.size());
+    Buf.append(utf8);
+}
+
+//! A definition is written as its statement number plus one, or 0 for none
+void BinaryIRWriter::writeDef(const Instruction *def) {
+    writeVarint(def ? (uint64_t(uint32_t(def->getNumber())) + 1) : 0);
+}
+
+void BinaryIRWriter::writeStatements(const std::list<Instruction *> &stmts) {
+    writeVarint(stmts.size());
+    for (Instruction *s : stmts)
+        write(s);
+}
+
+/***************************************************************************/ /**
+  * \brief Append the encoding of an expression (which may be null)
+  ******************************************************************************/
+void BinaryIRWriter::write(const Exp *e) {
+    if (e == nullptr) {
+        writeByte(E_NULL);
+        return;
+    }
+    auto found = ExpIds.find(e);
+    if (found != ExpIds.end()) {
+        writeByte(E_BACKREF);
+        writeVarint(found->second);
+        return;
+    }
+    uint32_t id = ExpIds.size();
+    ExpIds[e] = id; // Numbered before the subexpressions, as the reader does
+    OPER op = e->getOper();
+    if (const Const *c = dynamic_cast<const Const *>(e)) {
+        switch (op) {
+        case opIntConst:
+            writeByte(E_INT);
+            writeSigned(c->getInt());
+            break;
+        case opLongConst:
+            writeByte(E_LONG);
+            writeVarint(c->getLong());
+            break;
+        case opFltConst: {
+            writeByte(E_FLT);
+            double d = c->getFlt();
+            char bytes[sizeof(d)];
+            memcpy(bytes, &d, sizeof(d));
+            Buf.append(bytes, sizeof(d));
+            break;
+        }
+        case opFuncConst:
+            writeByte(E_FUNC);
+            writeString(c->getFuncName());
+            break;
+        default:
+            writeByte(E_STR);
+            writeVarint(op);
+            writeString(c->getStr());
+            break;
+        }
+        // The type is usually void; only write it if not
+        SharedType ty = c->getType();
+        bool hasType = ty && !ty->isVoid();
+        writeVarint((uint64_t(uint32_t(c->getConscript())) << 1) | (hasType ? 1 : 0));
+        if (hasType)
+            write(ty);
+        return;
+    }
+    if (const TypeVal *tv = dynamic_cast<const TypeVal *>(e)) {
+        writeByte(E_TYPEVAL);
+        write(const_cast<TypeVal *>(tv)->getType());
+        return;
+    }
+    switch (e->getArity()) {
+    case 0:
+        writeByte(E_TERMINAL);
+        writeVarint(op);
+        return;
+    case 3:
+        writeByte(E_TERNARY);
+        writeVarint(op);
+        write(e->getSubExp1());
+        write(e->getSubExp2());
+        write(e->getSubExp3());
+        return;
+    case 2:
+        writeByte(E_BINARY);
+        writeVarint(op);
+        write(e->getSubExp1());
+        write(e->getSubExp2());
+        return;
+    default:
+        break;
+    }
+    if (const Location *l = dynamic_cast<const Location *>(e)) {
+        writeByte(E_LOCATION);
+        writeVarint(op);
+        UserProc *p = const_cast<Location *>(l)->getProc();
+        writeString(p ? p->getName() : QString());
+    } else if (const RefExp *r = dynamic_cast<const RefExp *>(e)) {
+        writeByte(E_REF);
+        writeDef(const_cast<RefExp *>(r)->getDef());
+    } else if (const TypedExp *t = dynamic_cast<const TypedExp *>(e)) {
+        writeByte(E_TYPED);
+        write(t->getType());
+    } else if (const FlagDef *f = dynamic_cast<const FlagDef *>(e)) {
+        writeByte(E_FLAGDEF);
+        write(f->getRtl().get());
+    } else {
+        writeByte(E_UNARY);
+        writeVarint(op);
+    }
+    write(e->getSubExp1());
+}
+
+/***************************************************************************/ /**
+  * \brief Append the encoding of a type (which may be null). Types are written in full each time
+  ******************************************************************************/
+void BinaryIRWriter::write(const SharedType &ty) {
+    if (!ty) {
+        writeByte(T_NULL);
+        return;
+    }
+    // Note: LowerType has the id of an UpperType, so test isLower() first
+    if (ty->isLower()) {
+        writeByte(T_LOWER);
+        write(ty->as<LowerType>()->getBaseType());
+    } else if (ty->isUpper()) {
+        writeByte(T_UPPER);
+        write(ty->as<UpperType>()->getBaseType());
+    } else if (ty->isVoid())
+        writeByte(T_VOID);
+    else if (ty->isBoolean())
+        writeByte(T_BOOLEAN);
+    else if (ty->isChar())
+        writeByte(T_CHAR);
+    else if (ty->isInteger()) {
+        writeByte(T_INTEGER);
+        writeVarint(ty->getSize());
+        writeSigned(ty->as<IntegerType>()->getSignedness());
+    } else if (ty->isFloat()) {
+        writeByte(T_FLOAT);
+        writeVarint(ty->getSize());
+    } else if (ty->isPointer()) {
+        writeByte(T_POINTER);
+        write(ty->as<PointerType>()->getPointsTo());
+    } else if (ty->isArray()) {
+        std::shared_ptr<ArrayType> a = ty->as<ArrayType>();
+        writeByte(T_ARRAY);
+        write(a->getBaseType());
+        writeVarint(a->getLength());
+    } else if (ty->isNamed()) {
+        writeByte(T_NAMED);
+        writeString(ty->as<NamedType>()->getName());
+    } else if (ty->isCompound()) {
+        std::shared_ptr<CompoundType> c = ty->as<CompoundType>();
+        writeByte(T_COMPOUND);
+        writeByte(c->isGeneric() ? 1 : 0);
+        writeVarint(c->getNumTypes());
+        for (unsigned i = 0; i < c->getNumTypes(); i++) {
+            write(c->getType(i));
+            writeString(c->getName(i));
+        }
+    } else if (ty->isUnion()) {
+        std::shared_ptr<UnionType> u = ty->as<UnionType>();
+        writeByte(T_UNION);
+        writeVarint(u->getNumTypes());
+        for (const UnionElement &elem : *u) {
+            write(elem.type);
+            writeString(elem.name);
+        }
+    } else if (ty->isSize()) {
+        writeByte(T_SIZE);
+        writeVarint(ty->getSize());
+    } else {
+        // A function type would need its whole signature
+        writeByte(T_VOID);
+        Ok = false;
+    }
+}
+
+/***************************************************************************/ /**
+  * \brief Append the encoding of a statement (which may be null): its kind, number, and the fields of the kind.
+  * The enclosing proc and basic block, the collectors and the signature of a call are not written.
+  ******************************************************************************/
+void BinaryIRWriter::write(Instruction *s) {
+    if (s == nullptr) {
+        writeByte(0xFF);
+        return;
+    }
+    writeByte(s->getKind());
+    writeSigned(s->getNumber());
+    switch (s->getKind()) {
+    case STMT_ASSIGN: {
+        Assign *a = (Assign *)s;
+        write(a->getType());
+        write(a->getLeft());
+        write(a->getRight());
+        write(a->getGuard());
+        break;
+    }
+    case STMT_PHIASSIGN: {
+        PhiAssign *pa = (PhiAssign *)s;
+        write(pa->getType());
+        write(pa->getLeft());
+        writeVarint(std::distance(pa->begin(), pa->end()));
+        for (const auto &v : *pa) {
+            // The in-edge is written as the address of its basic block
+            writeVarint(v.first ? v.first->getLowAddr().m_value + 1 : 0);
+            writeDef(v.second.def());
+            write(v.second.e);
+        }
+        break;
+    }
+    case STMT_IMPASSIGN: {
+        ImplicitAssign *ia = (ImplicitAssign *)s;
+        write(ia->getType());
+        write(ia->getLeft());
+        break;
+    }
+    case STMT_BOOLASSIGN: {
+        BoolAssign *b = (BoolAssign *)s;
+        writeVarint(b->getSize());
+        writeVarint(b->getCond());
+        writeByte(b->isFloat() ? 1 : 0);
+        write(b->getLeft());
+        write(b->getCondExpr());
+        break;
+    }
+    case STMT_GOTO: {
+        GotoStatement *g = (GotoStatement *)s;
+        writeByte(g->isComputed() ? 1 : 0);
+        write(g->getDest());
+        break;
+    }
+    case STMT_BRANCH: {
+        BranchStatement *b = (BranchStatement *)s;
+        writeByte(b->isComputed() ? 1 : 0);
+        writeVarint(b->getCond());
+        writeByte(b->isFloat() ? 1 : 0);
+        write(b->getDest());
+        write(b->getCondExpr());
+        break;
+    }
+    case STMT_CASE: {
+        CaseStatement *c = (CaseStatement *)s;
+        writeByte(c->isComputed() ? 1 : 0);
+        write(c->getDest());
+        SWITCH_INFO *si = c->getSwitchInfo();
+        writeByte(si ? 1 : 0);
+        if (si) {
+            write(si->pSwitchVar);
+            writeByte(uint8_t(si->chForm));
+            writeSigned(si->iLower);
+            writeSigned(si->iUpper);
+            writeVarint(si->uTable.m_value);
+            writeSigned(si->iNumTable);
+            writeSigned(si->iOffset);
+        }
+        break;
+    }
+    case STMT_CALL: {
+        CallStatement *c = (CallStatement *)s;
+        writeByte((c->isComputed() ? 1 : 0) | (c->isReturnAfterCall() ? 2 : 0));
+        write(c->getDest());
+        Function *dest = c->getDestProc();
+        writeString(dest ? dest->getName() : QString());
+        writeStatements(c->getArguments());
+        writeStatements(c->getDefines());
+        break;
+    }
+    case STMT_RET: {
+        ReturnStatement *r = (ReturnStatement *)s;
+        writeVarint(r->getRetAddr().m_value);
+        writeStatements(r->getModifieds());
+        writeStatements(r->getReturns());
+        break;
+    }
+    case STMT_IMPREF: {
+        ImpRefStatement *ir = (ImpRefStatement *)s;
+        write(ir->getType());
+        write(ir->getAddressExp());
+        break;
+    }
+    case STMT_JUNCTION:
+        break;
+    }
+}
+
+/***************************************************************************/ /**
+  * \brief Append the encoding of an RTL: its address and its statements
+  ******************************************************************************/
+void BinaryIRWriter::write(RTL *rtl) {
+    if (rtl == nullptr) {
+        writeByte(0);
+        return;
+    }
+    writeByte(1);
+    writeVarint(rtl->getAddress().m_value);
+    writeVarint(rtl->size());
+    for (Instruction *s : *rtl)
+        write(s);
+}
+
+//    //    //    //    //    //
+//     BinaryIRReader    //
+//    //    //    //    //    //
+
+/***************************************************************************/ /**
+  * \param data, size - the encoding; not copied, so it must outlive the reader
+  * \param prog - used to find the procedures named by locations, function constants and calls
+  * \param proc - the procedure the statements belong to; used to find definitions that were not read
+  ******************************************************************************/
+BinaryIRReader::BinaryIRReader(const char *data, size_t size, Prog *prog, UserProc *proc)
+    : Pos((const uint8_t *)data), End((const uint8_t *)data + size), Prg(prog), Proc(proc) {}
+
+uint8_t BinaryIRReader::readByte() {
+    if (Pos == End) {
+        fail();
+        return 0;
+    }
+    return *Pos++;
+}
+
+uint64_t BinaryIRReader::readVarint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (Pos == End) {
+            fail();
+            return 0;
+        }
+        uint8_t b = *Pos++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+            return v;
+    }
+    fail();
+    return 0;
+}
+
+//! Read an OPER; a value outside the enum is bad input
+int BinaryIRReader::readOper() {
+    uint64_t op = readVarint();
+    if (op >= opNumOf) {
+        fail();
+        return opWild;
+    }
+    return int(op);
+}
+
+//! Read a BRANCH_TYPE; a value outside the enum is bad input
+int BinaryIRReader::readBranchType() {
+    uint64_t cond = readVarint();
+    if (cond > BRANCH_JPAR) {
+        fail();
+        return BRANCH_JE;
+    }
+    return int(cond);
+}
+
+QString BinaryIRReader::readString() {
+    uint64_t len = readVarint();
+    if (len > uint64_t(End - Pos)) {
+        fail();
+        return QString();
+    }
+    QString s = QString::fromUtf8((const char *)Pos, int(len));
+    Pos += len;
+    return s;
+}
+
+Instruction *BinaryIRReader::findDef(int number) {
+    auto found = Numbered.find(number);
+    if (found != Numbered.end())
+        return found->second;
+    if (Proc == nullptr)
+        return nullptr;
+    if (!ProcScanned) {
+        StatementList stmts;
+        Proc->getStatements(stmts);
+        for (Instruction *s : stmts)
+            ProcNumbered[s->getNumber()] = s;
+        ProcScanned = true;
+    }
+    found = ProcNumbered.find(number);
+    return found != ProcNumbered.end() ? found->second : nullptr;
+}
+
+//! Read a definition. Returns it if already known; otherwise number is set for resolveDefs() (-1 for no definition)
+Instruction *BinaryIRReader::readDef(int &number) {
+    uint64_t v = readVarint();
+    number = -1;
+    if (v == 0)
+        return nullptr;
+    number = int(uint32_t(v - 1));
+    Instruction *def = findDef(number);
+    if (def)
+        number = -1;
+    return def;
+}
+
+/***************************************************************************/ /**
+  * \brief Read an expression
+  * \returns the expression, or nullptr if a null expression was written or the input is bad (see isOk())
+  ******************************************************************************/
+Exp *BinaryIRReader::readExp() {
+    if (!Ok)
+        return nullptr;
+    uint8_t tag = readByte();
+    if (tag == E_NULL)
+        return nullptr;
+    if (tag == E_BACKREF) {
+        uint64_t id = readVarint();
+        if (id >= Exps.size() || Exps[id] == nullptr) {
+            fail();
+            return nullptr;
+        }
+        return Exps[id];
+    }
+    // Reserve the number of this node; it is only known after the subexpressions have been read
+    size_t id = Exps.size();
+    Exps.push_back(nullptr);
+    Exp *res = nullptr;
+    switch (tag) {
+    case E_INT:
+    case E_LONG:
+    case E_FLT:
+    case E_STR:
+    case E_FUNC: {
+        Const *c = nullptr;
+        if (tag == E_INT)
+            c = new Const(int(readSigned()));
+        else if (tag == E_LONG)
+            c = new Const(QWord(readVarint()));
+        else if (tag == E_FLT) {
+            double d;
+            if (End - Pos < (ptrdiff_t)sizeof(d)) {
+                fail();
+                return nullptr;
+            }
+            memcpy(&d, Pos, sizeof(d));
+            Pos += sizeof(d);
+            c = new Const(d);
+        } else if (tag == E_STR) {
+            OPER op = (OPER)readOper();
+            c = new Const(readString());
+            if (op != opStrConst)
+                c->setOper(op);
+        } else {
+            QString name = readString();
+            Function *f = Prg ? Prg->findProc(name) : nullptr;
+            if (f == nullptr) {
+                fail();
+                return nullptr;
+            }
+            c = new Const(f);
+        }
+        uint64_t v = readVarint();
+        c->setConscript(int(uint32_t(v >> 1)));
+        if (v & 1)
+            c->setType(readType());
+        res = c;
+        break;
+    }
+    case E_TYPEVAL:
+        res = new TypeVal(readType());
+        break;
+    case E_TERMINAL:
+        res = new Terminal((OPER)readOper());
+        break;
+    case E_UNARY: {
+        OPER op = (OPER)readOper();
+        Exp *e1 = readExp();
+        if (e1)
+            res = new Unary(op, e1);
+        break;
+    }
+    case E_BINARY: {
+        OPER op = (OPER)readOper();
+        Exp *e1 = readExp();
+        Exp *e2 = readExp();
+        if (e1 && e2)
+            res = Binary::get(op, e1, e2);
+        break;
+    }
+    case E_TERNARY: {
+        OPER op = (OPER)readOper();
+        Exp *e1 = readExp();
+        Exp *e2 = readExp();
+        Exp *e3 = readExp();
+        if (e1 && e2 && e3)
+            res = new Ternary(op, e1, e2, e3);
+        break;
+    }
+    case E_LOCATION: {
+        OPER op = (OPER)readOper();
+        QString procName = readString();
+        UserProc *p = nullptr;
+        if (Prg && !procName.isEmpty())
+            p = dynamic_cast<UserProc *>(Prg->findProc(procName));
+        Exp *e1 = readExp();
+        if (e1 && (op == opRegOf || op == opMemOf || op == opLocal || op == opGlobal || op == opParam ||
+                   op == opTemp))
+            res = new Location(op, e1, p);
+        break;
+    }
+    case E_REF: {
+        int number;
+        Instruction *def = readDef(number);
+        Exp *e1 = readExp();
+        if (e1) {
+            RefExp *r = new RefExp(e1, def);
+            if (number >= 0)
+                Pending.push_back({r, nullptr, nullptr, number});
+            res = r;
+        }
+        break;
+    }
+    case E_TYPED: {
+        SharedType ty = readType();
+        Exp *e1 = readExp();
+        if (e1)
+            res = new TypedExp(ty, e1);
+        break;
+    }
+    case E_FLAGDEF: {
+        SharedRTL rtl(readRTL());
+        Exp *e1 = readExp();
+        if (e1)
+            res = new FlagDef(e1, rtl);
+        break;
+    }
+    default:
+        break;
+    }
+    if (res == nullptr) {
+        fail();
+        return nullptr;
+    }
+    Exps[id] = res;
+    return res;
+}
+
+/***************************************************************************/ /**
+  * \brief Read a type
+  * \returns the type, or nullptr if a null type was written or the input is bad
+  ******************************************************************************/
+SharedType BinaryIRReader::readType() {
+    if (!Ok)
+        return nullptr;
+    switch (readByte()) {
+    case T_NULL:
+        return nullptr;
+    case T_VOID:
+        return VoidType::get();
+    case T_BOOLEAN:
+        return BooleanType::get();
+    case T_CHAR:
+        return CharType::get();
+    case T_INTEGER: {
+        unsigned size = unsigned(readVarint());
+        return IntegerType::get(size, int(readSigned()));
+    }
+    case T_FLOAT:
+        return FloatType::get(int(readVarint()));
+    case T_POINTER: {
+        SharedType to = readType();
+        return to ? PointerType::get(to) : nullptr;
+    }
+    case T_ARRAY: {
+        SharedType base = readType();
+        unsigned length = unsigned(readVarint());
+        return base ? ArrayType::get(base, length) : nullptr;
+    }
+    case T_NAMED:
+        return NamedType::get(readString());
+    case T_COMPOUND: {
+        std::shared_ptr<CompoundType> c = std::make_shared<CompoundType>(readByte() != 0);
+        uint64_t n = readVarint();
+        for (uint64_t i = 0; i < n && Ok; i++) {
+            SharedType member = readType();
+            c->addType(member, readString());
+        }
+        return Ok ? c : nullptr;
+    }
+    case T_UNION: {
+        std::shared_ptr<UnionType> u = UnionType::get();
+        uint64_t n = readVarint();
+        for (uint64_t i = 0; i < n && Ok; i++) {
+            SharedType member = readType();
+            u->addType(member, readString());
+        }
+        return Ok ? u : nullptr;
+    }
+    case T_SIZE:
+        return SizeType::get(unsigned(readVarint()));
+    case T_UPPER: {
+        SharedType base = readType();
+        return base ? std::make_shared<UpperType>(base) : nullptr;
+    }
+    case T_LOWER: {
+        SharedType base = readType();
+        return base ? std::make_shared<LowerType>(base) : nullptr;
+    }
+    }
+    fail();
+    return nullptr;
+}
+
+bool BinaryIRReader::readStatements(std::list<Instruction *> &stmts) {
+    uint64_t n = readVarint();
+    for (uint64_t i = 0; i < n && Ok; i++) {
+        Instruction *s = readStatement();
+        if (s)
+            stmts.push_back(s);
+    }
+    return Ok;
+}
+
+/***************************************************************************/ /**
+  * \brief Read a statement. If the reader has a UserProc, the statement is put in it
+  * \returns the statement, or nullptr if a null statement was written or the input is bad
+  ******************************************************************************/
+Instruction *BinaryIRReader::readStatement() {
+    if (!Ok)
+        return nullptr;
+    uint8_t kind = readByte();
+    if (kind == 0xFF)
+        return nullptr;
+    int number = int(readSigned());
+    Instruction *res = nullptr;
+    switch (kind) {
+    case STMT_ASSIGN: {
+        SharedType ty = readType();
+        Exp *lhs = readExp();
+        Exp *rhs = readExp();
+        Exp *guard = readExp();
+        if (lhs && rhs)
+            res = new Assign(ty, lhs, rhs, guard);
+        break;
+    }
+    case STMT_PHIASSIGN: {
+        SharedType ty = readType();
+        Exp *lhs = readExp();
+        if (lhs == nullptr)
+            break;
+        PhiAssign *pa = new PhiAssign(ty, lhs);
+        uint64_t n = readVarint();
+        for (uint64_t i = 0; i < n && Ok; i++) {
+            uint64_t addr = readVarint();
+            BasicBlock *bb = nullptr;
+            if (addr != 0 && Proc && Proc->getCFG() && Proc->getCFG()->existsBB(ADDRESS::g(addr - 1)))
+                bb = Proc->getCFG()->bbForAddr(ADDRESS::g(addr - 1));
+            int defNumber;
+            Instruction *def = readDef(defNumber);
+            Exp *e = readExp();
+            pa->putAt(bb, def, e);
+            if (defNumber >= 0)
+                Pending.push_back({nullptr, pa, bb, defNumber});
+        }
+        res = pa;
+        break;
+    }
+    case STMT_IMPASSIGN: {
+        SharedType ty = readType();
+        Exp *lhs = readExp();
+        if (lhs)
+            res = new ImplicitAssign(ty, lhs);
+        break;
+    }
+    case STMT_BOOLASSIGN: {
+        int size = int(readVarint());
+        BRANCH_TYPE cond = (BRANCH_TYPE)readBranchType();
+        bool isFloat = readByte() != 0;
+        Exp *lhs = readExp();
+        Exp *condExp = readExp();
+        BoolAssign *b = new BoolAssign(size);
+        b->setCondType(cond, isFloat);
+        b->setLeft(lhs);
+        b->setCondExpr(condExp);
+        res = b;
+        break;
+    }
+    case STMT_GOTO: {
+        GotoStatement *g = new GotoStatement;
+        g->setIsComputed(readByte() != 0);
+        g->setDest(readExp());
+        res = g;
+        break;
+    }
+    case STMT_BRANCH: {
+        BranchStatement *b = new BranchStatement;
+        b->setIsComputed(readByte() != 0);
+        BRANCH_TYPE cond = (BRANCH_TYPE)readBranchType();
+        b->setCondType(cond, readByte() != 0);
+        b->setDest(readExp());
+        b->setCondExpr(readExp());
+        res = b;
+        break;
+    }
+    case STMT_CASE: {
+        CaseStatement *c = new CaseStatement;
+        c->setIsComputed(readByte() != 0);
+        c->setDest(readExp());
+        if (readByte()) {
+            SWITCH_INFO *si = new SWITCH_INFO;
+            si->pSwitchVar = readExp();
+            si->chForm = char(readByte());
+            si->iLower = int(readSigned());
+            si->iUpper = int(readSigned());
+            si->uTable = ADDRESS::g(readVarint());
+            si->iNumTable = int(readSigned());
+            si->iOffset = int(readSigned());
+            c->setSwitchInfo(si);
+        }
+        res = c;
+        break;
+    }
+    case STMT_CALL: {
+        CallStatement *c = new CallStatement;
+        uint8_t flags = readByte();
+        c->setIsComputed((flags & 1) != 0);
+        c->setReturnAfterCall((flags & 2) != 0);
+        c->setDest(readExp());
+        QString destName = readString();
+        if (Prg && !destName.isEmpty()) {
+            Function *dest = Prg->findProc(destName);
+            if (dest)
+                c->setDestProc(dest);
+        }
+        readStatements(c->getArguments());
+        readStatements(c->getDefines());
+        res = c;
+        break;
+    }
+    case STMT_RET: {
+        ReturnStatement *r = new ReturnStatement;
+        r->setRetAddr(ADDRESS::g(readVarint()));
+        readStatements(r->getModifieds());
+        readStatements(r->getReturns());
+        res = r;
+        break;
+    }
+    case STMT_IMPREF: {
+        SharedType ty = readType();
+        Exp *addr = readExp();
+        if (addr)
+            res = new ImpRefStatement(ty, addr);
+        break;
+    }
+    case STMT_JUNCTION:
+        res = new JunctionStatement;
+        break;
+    default:
+        break;
+    }
+    if (!Ok || res == nullptr) {
+        fail();
+        return nullptr;
+    }
+    res->setNumber(number);
+    if (Proc)
+        res->setProc(Proc);
+    if (number > 0)
+        Numbered[number] = res;
+    return res;
+}
+
+/***************************************************************************/ /**
+  * \brief Read an RTL and its statements
+  * \returns the RTL, or nullptr if a null RTL was written or the input is bad
+  ******************************************************************************/
+RTL *BinaryIRReader::readRTL() {
+    if (!Ok || readByte() == 0)
+        return nullptr;
+    RTL *rtl = new RTL(ADDRESS::g(readVarint()));
+    uint64_t n = readVarint();
+    rtl->reserve(std::min<uint64_t>(n, End - Pos)); // Each statement takes at least a byte
+    for (uint64_t i = 0; i < n && Ok; i++) {
+        Instruction *s = readStatement();
+        if (s)
+            rtl->push_back(s);
+    }
+    if (!Ok) {
+        delete rtl;
+        return nullptr;
+    }
+    return rtl;
+}
+
+/***************************************************************************/ /**
+  * \brief Set the definitions that referred to statements that had not been read yet
+  ******************************************************************************/
+void BinaryIRReader::resolveDefs() {
+    Unresolved = 0;
+    for (const PendingDef &p : Pending) {
+        Instruction *def = findDef(p.Number);
+        if (def == nullptr) {
+            Unresolved++;
+            continue;
+        }
+        if (p.Ref)
+            p.Ref->setDef(def);
+        else {
+            for (auto &v : *p.Phi)
+                if (v.first == p.PhiBB)
+                    v.second.def(def);
+        }
+    }
+    Pending.clear();
+}
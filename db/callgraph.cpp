@@ -0,0 +1,136 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/***************************************************************************/ /**
+  * \file       callgraph.cpp
+  * OVERVIEW:   Implementation of the CallGraphSCCs class.
+  ******************************************************************************/
+
+#include "callgraph.h"
+
+#include "proc.h"
+#include "cfg.h"
+#include "basicblock.h"
+#include "rtl.h"
+#include "statement.h"
+
+#include <algorithm>
+#include <cassert>
+
+//! Append the user procedures called from proc to callees, in the order of proc's BBs, without duplicates
+void CallGraphSCCs::findCallees(UserProc *proc, std::vector<UserProc *> &callees) {
+    Cfg *cfg = proc->getCFG();
+    if (cfg == nullptr)
+        return;
+    BB_IT it;
+    for (BasicBlock *bb = cfg->getFirstBB(it); bb; bb = cfg->getNextBB(it)) {
+        if (bb->getType() != BBTYPE::CALL || bb->getRTLs() == nullptr || bb->getRTLs()->empty())
+            continue;
+        Instruction *last = bb->getRTLs()->back()->getHlStmt();
+        if (last == nullptr || !last->isCall())
+            continue;
+        UserProc *c = dynamic_cast<UserProc *>(((CallStatement *)last)->getDestProc());
+        if (c && std::find(callees.begin(), callees.end(), c) == callees.end())
+            callees.push_back(c);
+    }
+}
+
+const std::vector<UserProc *> &CallGraphSCCs::getCallees(UserProc *proc) {
+    auto found = Callees.find(proc);
+    if (found != Callees.end())
+        return found->second;
+    std::vector<UserProc *> &callees = Callees[proc];
+    findCallees(proc, callees);
+    return callees;
+}
+
+void CallGraphSCCs::clear() {
+    Components.clear();
+    ComponentOf.clear();
+    Callees.clear();
+    Index.clear();
+    Low.clear();
+    Stack.clear();
+    NextIndex = 0;
+}
+
+/// Find the components reachable from root that are not known yet, appending them after the known ones. The search
+/// keeps its own stack, so a long chain of calls cannot overflow the machine stack.
+void CallGraphSCCs::addRoot(UserProc *root) {
+    if (ComponentOf.count(root))
+        return;
+    struct Frame {
+        UserProc *Proc;
+        const std::vector<UserProc *> *Callees; // Stable: Callees is node based
+        size_t Next;
+    };
+    std::vector<Frame> frames;
+    enter(root);
+    frames.push_back(Frame{root, &getCallees(root), 0});
+    while (!frames.empty()) {
+        Frame &f = frames.back();
+        if (f.Next < f.Callees->size()) {
+            UserProc *c = (*f.Callees)[f.Next++];
+            if (ComponentOf.count(c))
+                continue; // In a component that is already complete
+            if (isOpen(c))
+                reach(f.Proc, c);
+            else {
+                enter(c);
+                frames.push_back(Frame{c, &getCallees(c), 0}); // f is not used after this
+            }
+            continue;
+        }
+        UserProc *p = f.Proc;
+        frames.pop_back();
+        if (!frames.empty())
+            returnFrom(frames.back().Proc, p);
+        leave(p);
+    }
+}
+
+//! Number proc in the order of the search, and push it on the stack
+void CallGraphSCCs::enter(UserProc *proc) {
+    Index[proc] = Low[proc] = NextIndex++;
+    Stack.push_back(proc);
+}
+
+//! from calls to, which is open, so from is in the component of to
+void CallGraphSCCs::reach(UserProc *from, UserProc *to) { Low[from] = std::min(Low[from], Index[to]); }
+
+//! The search of to, a callee of from, is done. If the component of to is not complete, from is in it too
+void CallGraphSCCs::returnFrom(UserProc *from, UserProc *to) {
+    auto found = Low.find(to);
+    if (found != Low.end())
+        Low[from] = std::min(Low[from], found->second);
+}
+
+/// The search of proc is done. If nothing it reaches was entered before it, proc and the open procedures entered after
+/// it are a complete component.
+/// \returns the number of that component, or -1 if proc is in a component that is not complete yet
+int CallGraphSCCs::leave(UserProc *proc) {
+    auto found = Index.find(proc);
+    if (found == Index.end() || Low[proc] != found->second)
+        return -1;
+    addComponent(proc);
+    return (int)Components.size() - 1;
+}
+
+//! Pop the component whose first visited procedure is root off the stack
+void CallGraphSCCs::addComponent(UserProc *root) {
+    int n = (int)Components.size();
+    std::vector<UserProc *>::iterator start = std::find(Stack.begin(), Stack.end(), root);
+    assert(start != Stack.end());
+    std::vector<UserProc *> component(start, Stack.end());
+    Stack.erase(start, Stack.end());
+    for (UserProc *p : component) {
+        ComponentOf[p] = n;
+        Index.erase(p);
+        Low.erase(p);
+    }
+    Components.push_back(std::move(component));
+}
@@ -69,6 +69,8 @@
 #include <cassert>
 #include <algorithm> // For find()
 #include <cstring>
+#include <deque>
+#include <unordered_map>
 
 void delete_lrtls(std::list<RTL *> &pLrtl);
 void erase_lrtls(std::list<RTL *> &pLrtl, std::list<RTL *>::iterator begin, std::list<RTL *>::iterator end);
@@ -135,6 +137,67 @@ Cfg &Cfg::operator=(const Cfg &other) {
     return *this;
 }
 
+/***************************************************************************/ /**
+  *
+  * \brief Replace the contents of this CFG with a deep copy of \a other. The BBs, their edges and their RTLs are
+  * all copied; the BBs of this CFG are cleared, not deleted (see clear()).
+  * \note Meant for CFGs that are still in decoded form; no data flow or structuring information is copied
+  * \param other - the CFG to copy from
+  *
+  ******************************************************************************/
+void Cfg::deepCopyFrom(const Cfg &other) {
+    clear();
+    std::map<const BasicBlock *, BasicBlock *> bbMap;
+    for (BasicBlock *orig : other.m_listBB) {
+        BasicBlock *bb = new BasicBlock(*orig); // Note: shares the RTL list of orig
+        bb->LabelNeeded = orig->LabelNeeded;
+        bb->overlappedRegProcessingDone = orig->overlappedRegProcessingDone;
+        if (orig->ListOfRTLs) {
+            bb->ListOfRTLs = new std::list<RTL *>;
+            for (RTL *origRtl : *orig->ListOfRTLs) {
+                RTL *rtl = origRtl->clone();
+                RTL::iterator ss = rtl->begin();
+                for (Instruction *s : *origRtl) {
+                    (*ss)->setBB(bb);
+                    if (s->isCall()) {
+                        // CallStatement::clone() doesn't copy the destination proc
+                        CallStatement *call = static_cast<CallStatement *>(*ss);
+                        call->setDestProc(static_cast<CallStatement *>(s)->getDestProc());
+                        if (other.CallSites.count(static_cast<CallStatement *>(s)))
+                            CallSites.insert(call);
+                    }
+                    ++ss;
+                }
+                bb->ListOfRTLs->push_back(rtl);
+            }
+        }
+        bbMap[orig] = bb;
+        m_listBB.push_back(bb);
+    }
+    auto remap = [&bbMap](BasicBlock *bb) -> BasicBlock * {
+        auto found = bbMap.find(bb);
+        return found == bbMap.end() ? nullptr : found->second;
+    };
+    for (BasicBlock *bb : m_listBB) {
+        for (BasicBlock *&pred : bb->InEdges)
+            pred = remap(pred);
+        for (BasicBlock *&succ : bb->OutEdges)
+            succ = remap(succ);
+        bb->ImmPDom = remap(bb->ImmPDom);
+        bb->LoopHead = remap(bb->LoopHead);
+        bb->CaseHead = remap(bb->CaseHead);
+        bb->CondFollow = remap(bb->CondFollow);
+        bb->LoopFollow = remap(bb->LoopFollow);
+        bb->LatchNode = remap(bb->LatchNode);
+    }
+    for (const std::pair<const ADDRESS, BasicBlock *> &entry : other.m_mapBB)
+        m_mapBB[entry.first] = remap(entry.second);
+    entryBB = remap(other.entryBB);
+    exitBB = remap(other.exitBB);
+    WellFormed = other.WellFormed;
+    lastLabel = other.lastLabel;
+}
+
 /***************************************************************************/ /**
   *
   * \brief        Set the entry and calculate exit BB pointers
@@ -1108,7 +1171,7 @@ void Cfg::searchAndReplace(const Exp &search, Exp *replace) {
     }
 }
 
-bool Cfg::searchAll(const Exp &search, std::list<Exp *> &result) {
+bool Cfg::searchAll(const Exp &search, ExpMatches &result) {
     bool ch = false;
     for (BasicBlock *bb : m_listBB) {
         ch |= bb->searchAll(search, result);
@@ -1805,6 +1868,143 @@ void Cfg::findInterferences(ConnectionGraph &cg) {
     }
 }
 
+// The bit vector version of the above. The BBs are visited in the same order, and the same names are connected in
+// the same order, but the live names at the start of each BB are a BitSet over the numbers ig gives them, and the
+// names used and defined by each statement (and those live because of phis at the successors) are found only once,
+// instead of each time the BB is visited. As there, only subscripted uses become live, and a BB's predecessors are
+// only revisited when its live names differ from its LiveIn, which starts as the BB has it. So LiveIn is left as the
+// LocationSet version would leave it.
+void Cfg::findInterferences(InterferenceGraph &ig) {
+    if (m_listBB.empty())
+        return;
+
+    // What calcLiveness needs of each statement of a BB, from the bottom up
+    struct StmtNames {
+        std::vector<size_t> Defs;
+        std::vector<size_t> Uses; //!< In the order of a LocationSet of them; empty for a phi
+        bool IsPhi;
+    };
+    std::vector<BasicBlock *> bbs(m_listBB.begin(), m_listBB.end());
+    size_t numBB = bbs.size();
+    std::unordered_map<BasicBlock *, size_t> indices;
+    for (size_t i = 0; i < numBB; i++)
+        indices[bbs[i]] = i;
+    std::vector<std::vector<StmtNames>> stmtNames(numBB);
+    std::vector<std::vector<size_t>> phiNames(numBB);
+    for (size_t i = 0; i < numBB; i++) {
+        BasicBlock *bb = bbs[i];
+        LocationSet phiLocs;
+        bb->getPhiLiveOut(phiLocs);
+        for (Exp *r : phiLocs)
+            phiNames[i].push_back(ig.number(r));
+        if (bb->ListOfRTLs == nullptr)
+            continue;
+        for (auto rit = bb->ListOfRTLs->rbegin(); rit != bb->ListOfRTLs->rend(); ++rit) {
+            for (auto sit = (*rit)->rbegin(); sit != (*rit)->rend(); ++sit) {
+                Instruction *s = *sit;
+                StmtNames names;
+                names.IsPhi = s->isPhi();
+                LocationSet defs;
+                s->getDefinitions(defs);
+                defs.addSubscript(s);
+                for (Exp *d : defs)
+                    names.Defs.push_back(ig.number(d));
+                if (!names.IsPhi) {
+                    LocationSet uses;
+                    s->addUsedLocs(uses);
+                    for (Exp *u : uses)
+                        names.Uses.push_back(ig.number(u));
+                }
+                stmtNames[i].push_back(std::move(names));
+            }
+        }
+    }
+
+    // What the LocationSet version compares its first visit of each BB with
+    std::vector<BitSet> liveIn(numBB);
+    for (size_t i = 0; i < numBB; i++)
+        for (Exp *e : bbs[i]->LiveIn)
+            liveIn[i].insert(ig.number(e));
+
+    // The subscripted names of each base expression, in the order of a LocationSet, so that the first live one that
+    // differs from a use is the one LocationSet::findDifferentRef() would find
+    LocationNumbering bases;
+    std::vector<int> baseOf(ig.size(), -1);
+    std::vector<std::vector<size_t>> byBase;
+    ig.getNames().forEachInOrder([&](size_t n) {
+        Exp *e = ig.name(n);
+        if (!e->isSubscript())
+            return;
+        size_t b = bases.number(((RefExp *)e)->getSubExp1());
+        if (b == byBase.size())
+            byBase.emplace_back();
+        byBase[b].push_back(n);
+        baseOf[n] = int(b);
+    });
+    auto checkForOverlap = [&](const BitSet &live, size_t u) {
+        if (baseOf[u] == -1)
+            return; // Only interested in subscripted vars
+        for (size_t d : byBase[baseOf[u]]) {
+            if (d == u || !live.exists(d) || *ig.name(d) == *ig.name(u))
+                continue;
+            ig.connect(u, d);
+            if (VERBOSE || DEBUG_LIVENESS)
+                LOG << "interference of " << ig.name(d) << " with " << ig.name(u) << "\n";
+            return;
+        }
+    };
+
+    std::deque<size_t> workList; // Taken from the back, as above
+    std::vector<bool> queued(numBB, true);
+    for (size_t i = 0; i < numBB; i++)
+        workList.push_back(i);
+    int count = 0;
+    while (!workList.empty() && count < 100000) {
+        count++; // prevent infinite loop
+        if (++progress > 20) {
+            LOG_STREAM() << "i";
+            LOG_STREAM().flush();
+            progress = 0;
+        }
+        size_t i = workList.back();
+        workList.pop_back();
+        queued[i] = false;
+        BitSet live;
+        for (BasicBlock *succ : bbs[i]->OutEdges)
+            live.makeUnion(liveIn[indices[succ]]);
+        for (size_t u : phiNames[i])
+            live.insert(u);
+        for (size_t u : phiNames[i])
+            checkForOverlap(live, u);
+        for (const StmtNames &names : stmtNames[i]) {
+            // Definitions kill uses; the operands of phis are live only at the predecessors (see calcLiveness)
+            for (size_t d : names.Defs)
+                live.remove(d);
+            for (size_t u : names.Uses) {
+                if (baseOf[u] == -1)
+                    continue; // Only interested in subscripted vars; they are not live either
+                checkForOverlap(live, u);
+                live.insert(u);
+            }
+        }
+        if (live == liveIn[i])
+            continue;
+        liveIn[i] = std::move(live);
+        for (BasicBlock *pred : bbs[i]->InEdges) {
+            size_t p = indices[pred];
+            if (!queued[p]) {
+                queued[p] = true;
+                workList.push_front(p);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < numBB; i++) {
+        bbs[i]->LiveIn.clear();
+        liveIn[i].forEach([&](size_t n) { bbs[i]->LiveIn.insert(ig.name(n)); });
+    }
+}
+
 void Cfg::appendBBs(std::list<BasicBlock *> &worklist, std::set<BasicBlock *> &workset) {
     // Append my list of BBs to the worklist
     worklist.insert(worklist.end(), m_listBB.begin(), m_listBB.end());
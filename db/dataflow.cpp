@@ -25,6 +25,7 @@
 #include "frontend.h"
 
 #include <QtCore/QDebug>
+#include <chrono>
 #include <sstream>
 #include <cstring>
 
@@ -36,172 +37,222 @@ extern char debug_buffer[]; // For prints functions
 
 DataFlow::~DataFlow()
 {
-
+    clearRenamedDefs();
 }
 
-void DataFlow::DFS(int p, size_t n) {
-    if (dfnum[n] == 0) {
-        dfnum[n] = N;
-        vertex[N] = n;
-        parent[n] = p;
-        N++;
-        // For each successor w of n
-        BasicBlock *bb = BBs[n];
-        const std::vector<BasicBlock *> &outEdges = bb->getOutEdges();
-        for (BasicBlock * bb : outEdges) {
-            DFS(n, indices[bb]);
+// Number the nodes reachable from r in depth first preorder, visiting the successors of each node in out-edge order.
+// The stack holds each node on the current path with the index of its next out-edge, so a long chain of BBs cannot
+// overflow the call stack
+void DataFlow::DFS(int r) {
+    std::vector<std::pair<int, size_t>> stack;
+    N = 0;
+    dfnum[r] = N;
+    vertex[N] = r;
+    parent[N++] = -1;
+    stack.emplace_back(r, 0);
+    while (!stack.empty()) {
+        int n = stack.back().first;
+        const std::vector<BasicBlock *> &outEdges = BBs[n]->getOutEdges();
+        if (stack.back().second == outEdges.size()) {
+            stack.pop_back();
+            continue;
         }
+        // For each successor w of n
+        int w = indices[outEdges[stack.back().second++]];
+        if (dfnum[w] != -1)
+            continue;
+        dfnum[w] = N;
+        vertex[N] = w;
+        parent[N++] = dfnum[n];
+        stack.emplace_back(w, 0);
     }
 }
 
-// Essentially Algorithm 19.9 of Appel's "modern compiler implementation in Java" 2nd ed 2002
+// The semi-NCA algorithm (Georgiadis 2005, "Linear-Time Algorithms for Dominators and Related Problems"). The semi
+// dominators are found as in Appel's algorithm 19.9 (Lengauer-Tarjan); then, in depth first order, the immediate
+// dominator of each vertex is the nearest ancestor of its parent in the dominator tree so far that is not deeper than
+// its semi dominator. This needs no buckets or deferred (samedom) cases.
 void DataFlow::dominators(Cfg *cfg) {
     BasicBlock *r = cfg->getEntryBB();
     size_t numBB = cfg->getNumBBs();
-    BBs.resize(numBB, (BasicBlock *)-1);
-    N = 0;
+    BBs.assign(numBB, nullptr);
     BBs[0] = r;
     indices.clear(); // In case restart decompilation due to switch statements
+    indices.reserve(numBB);
+    clearRenamedDefs(); // Renaming depends on the dominator tree
     indices[r] = 0;
-    // Initialise to "none"
-    dfnum.resize(numBB, 0);
-    semi.resize(numBB, -1);
-    ancestor.resize(numBB, -1);
-    idom.resize(numBB, -1);
-    samedom.resize(numBB, -1);
-    vertex.resize(numBB, -1);
-    parent.resize(numBB, -1);
-    best.resize(numBB, -1);
-    bucket.resize(numBB);
-    DF.resize(numBB);
     // Set up the BBs and indices vectors. Do this here because sometimes a BB can be unreachable (so relying on
     // in-edges doesn't work)
-    std::list<BasicBlock *>::iterator ii;
     size_t idx = 1;
-    for (ii = cfg->begin(); ii != cfg->end(); ii++) {
-        BasicBlock *bb = *ii;
+    for (BasicBlock *bb : *cfg) {
         if (bb != r) { // Entry BB r already done
             indices[bb] = idx;
             BBs[idx++] = bb;
         }
     }
-    DFS(-1, 0);
-    assert((N - 1) >= 0);
-    for (int i = N - 1; i >= 1; i--) {
-        int n = vertex[i];
-        int p = parent[n];
-        int s = p;
-        /* These lines calculate the semi-dominator of n, based on the Semidominator Theorem */
-        // for each predecessor v of n
-        BasicBlock *bb = BBs[n];
-        std::vector<BasicBlock *> &inEdges = bb->getInEdges();
-        std::vector<BasicBlock *>::iterator it;
-        for (it = inEdges.begin(); it != inEdges.end(); it++) {
-            if (indices.find(*it) == indices.end()) {
+    // Initialise to "none"
+    dfnum.assign(numBB, -1);
+    vertex.assign(numBB, -1);
+    parent.assign(numBB, -1);
+    DFS(0);
+
+    // Semi dominators, in reverse depth first order. A vertex is linked to its parent in the forest as soon as it is
+    // done, so while w is being worked on the linked vertices are exactly those numbered above w
+    semi.resize(N);
+    label.resize(N);
+    for (int v = 0; v < N; ++v)
+        semi[v] = label[v] = v;
+    ancestor.assign(parent.begin(), parent.begin() + N);
+    for (int w = N - 1; w >= 1; --w) {
+        int s = parent[w];
+        // for each predecessor v of w
+        for (BasicBlock *pred : BBs[vertex[w]]->getInEdges()) {
+            auto found = indices.find(pred);
+            if (found == indices.end()) {
                 QTextStream q_cerr(stderr);
 
                 q_cerr << "BB not in indices: ";
-                (*it)->print(q_cerr);
+                pred->print(q_cerr);
                 assert(false);
             }
-            int v = indices[*it];
-            int sdash = v;
-            if (dfnum[v] > dfnum[n])
-                sdash = semi[ancestorWithLowestSemi(v)];
-            if (dfnum[sdash] < dfnum[s])
+            int v = dfnum[found->second];
+            if (v == -1)
+                continue; // An unreachable predecessor
+            int sdash = semi[ancestorWithLowestSemi(v, w + 1)];
+            if (sdash < s)
                 s = sdash;
         }
-        semi[n] = s;
-        /* Calculation of n's dominator is deferred until the path from s to n has been linked into the forest */
-        bucket[s].insert(n);
-        Link(p, n);
-        // for each v in bucket[p]
-        std::set<int>::iterator jj;
-        for (jj = bucket[p].begin(); jj != bucket[p].end(); jj++) {
-            int v = *jj;
-            /* Now that the path from p to v has been linked into the spanning forest, these lines calculate the
-                                dominator of v, based on the first clause of the Dominator Theorem, or else defer the
-               calculation until
-                                y's dominator is known. */
-            int y = ancestorWithLowestSemi(v);
-            if (semi[y] == semi[v])
-                idom[v] = p; // Success!
-            else
-                samedom[v] = y; // Defer
-        }
-        bucket[p].clear();
-    }
-    for (int i = 1; i < N - 1; i++) {
-        /* Now all the deferred dominator calculations, based on the second clause of the Dominator Theorem, are
-                        performed. */
-        int n = vertex[i];
-        if (samedom[n] != -1) {
-            idom[n] = idom[samedom[n]]; // Deferred success!
-        }
+        semi[w] = s;
+    }
+
+    // Immediate dominators. The dominators of w's parent are already known, and idom(w) is the first of them (going
+    // up the tree) whose number is at most semi(w)
+    std::vector<int> domNum(N, -1); // idom by depth first number
+    for (int w = 1; w < N; ++w) {
+        int d = parent[w];
+        while (d > semi[w])
+            d = domNum[d];
+        domNum[w] = d;
     }
-    computeDF(0); // Finally, compute the dominance frontiers
-}
 
-// Basically algorithm 19.10b of Appel 2002 (uses path compression for O(log N) amortised time per operation
-// (overall O(N log N))
-int DataFlow::ancestorWithLowestSemi(int v) {
-    int a = ancestor[v];
-    if (ancestor[a] != -1) {
-        int b = ancestorWithLowestSemi(a);
-        ancestor[v] = ancestor[a];
-        if (dfnum[semi[b]] < dfnum[semi[best[v]]])
-            best[v] = b;
+    // Translate back from depth first numbers to nodes
+    idom.assign(numBB, -1);
+    std::vector<int> semiByNode(numBB, -1);
+    for (int w = 1; w < N; ++w) {
+        idom[vertex[w]] = vertex[domNum[w]];
+        semiByNode[vertex[w]] = vertex[semi[w]];
     }
-    return best[v];
+    semi.swap(semiByNode);
+    buildDominatorTree();
+    computeDF(); // Finally, compute the dominance frontiers
 }
 
-void DataFlow::Link(int p, int n) {
-    ancestor[n] = p;
-    best[n] = n;
+// Return the vertex with the lowest semi dominator on the path from v up to (but not including) the root of its tree
+// in the forest of linked vertices; vertices numbered lastLinked and above are linked. The path is compressed as it
+// is walked, as in Appel's algorithm 19.10b, but with an explicit stack instead of recursion
+int DataFlow::ancestorWithLowestSemi(int v, int lastLinked) {
+    if (ancestor[v] < lastLinked)
+        return label[v]; // v is a root, or a child of one
+    evalStack.clear();
+    do {
+        evalStack.push_back(v);
+        v = ancestor[v];
+    } while (ancestor[v] >= lastLinked);
+    // v is now the last vertex before the root; compress the path below it, from the top down
+    int p = v;
+    int pLabel = label[p];
+    do {
+        v = evalStack.back();
+        evalStack.pop_back();
+        ancestor[v] = ancestor[p];
+        if (semi[pLabel] < semi[label[v]])
+            label[v] = pLabel;
+        else
+            pLabel = label[v];
+        p = v;
+    } while (!evalStack.empty());
+    return label[v];
 }
 
-// Return true if n dominates w
-bool DataFlow::doesDominate(int n, int w) {
-    while (idom[w] != -1) {
-        if (idom[w] == n)
-            return true;
-        w = idom[w]; // Move up the dominator tree
+// Store the children of each node in the dominator tree, and number the tree in preorder so that doesDominate() is
+// a range check
+void DataFlow::buildDominatorTree() {
+    size_t numBB = BBs.size();
+    domChildStart.assign(numBB + 1, 0);
+    for (size_t n = 0; n < numBB; ++n) {
+        if (idom[n] != -1)
+            domChildStart[idom[n] + 1]++;
+    }
+    for (size_t n = 0; n < numBB; ++n)
+        domChildStart[n + 1] += domChildStart[n];
+    domChildren.resize(domChildStart[numBB]);
+    std::vector<int> next(domChildStart.begin(), domChildStart.end() - 1);
+    for (size_t n = 0; n < numBB; ++n) {
+        if (idom[n] != -1)
+            domChildren[next[idom[n]]++] = n;
+    }
+
+    domPre.assign(numBB, -1);
+    domLast.assign(numBB, -1);
+    domOrder.clear();
+    std::vector<std::pair<int, int>> stack; // Node, and the index of its next child
+    int num = 0;
+    domPre[0] = num++;
+    domOrder.push_back(0);
+    stack.emplace_back(0, domChildStart[0]);
+    while (!stack.empty()) {
+        int n = stack.back().first;
+        if (stack.back().second == domChildStart[n + 1]) {
+            domLast[n] = num - 1;
+            stack.pop_back();
+            continue;
+        }
+        int c = domChildren[stack.back().second++];
+        domPre[c] = num++;
+        domOrder.push_back(c);
+        stack.emplace_back(c, domChildStart[c]);
     }
-    return false;
 }
 
-void DataFlow::computeDF(int n) {
-    std::set<int> S;
-    /* THis loop computes DF_local[n] */
-    // for each node y in succ(n)
-    BasicBlock *bb = BBs[n];
-    const std::vector<BasicBlock *> &outEdges = bb->getOutEdges();
+// Return true if n strictly dominates w
+bool DataFlow::doesDominate(int n, int w) const {
+    if (n == w || domPre[n] == -1 || domPre[w] == -1)
+        return false;
+    return domPre[n] < domPre[w] && domPre[w] <= domLast[n];
+}
 
-    for (BasicBlock *b : outEdges) {
-        int y = indices[b];
-        if (idom[y] != n)
-            S.insert(y);
-    }
-    // for each child c of n in the dominator tree
-    // Note: this is a linear search!
-    int sz = idom.size(); // ? Was ancestor.size()
-    for (int c = 0; c < sz; ++c) {
-        if (idom[c] != n)
+// The dominance frontiers, by the method of Cooper, Harvey and Kennedy ("A Simple, Fast Dominance Algorithm", 2001)
+// rather than Appel's recursive DF_local / DF_up (algorithm 19.10a): y is in the frontier of every node on the path
+// up the dominator tree from each predecessor of y, stopping before idom(y)
+void DataFlow::computeDF() {
+    size_t numBB = BBs.size();
+    std::vector<std::pair<int, int>> members; // Node, and a node in its frontier
+    std::vector<int> lastAdded(numBB, -1);     // Last node added to the frontier of each node
+    for (size_t y = 0; y < numBB; ++y) {
+        if (dfnum[y] == -1)
             continue;
-        computeDF(c);
-        /* This loop computes DF_up[c] */
-        // for each element w of DF[c]
-        std::set<int> &s = DF[c];
-        std::set<int>::iterator ww;
-        for (ww = s.begin(); ww != s.end(); ww++) {
-            int w = *ww;
-            // if n does not dominate w, or if n = w
-            if (n == w || !doesDominate(n, w)) {
-                S.insert(w);
+        for (BasicBlock *pred : BBs[y]->getInEdges()) {
+            int runner = indices[pred];
+            if (dfnum[runner] == -1)
+                continue;
+            // If y is already in runner's frontier, the rest of the path has been done too
+            while (runner != idom[y] && lastAdded[runner] != int(y)) {
+                lastAdded[runner] = y;
+                members.emplace_back(runner, y);
+                runner = idom[runner];
             }
         }
     }
-    DF[n] = S;
+    // Counting sort by node; each row stays in increasing order, since y was increasing
+    DFStart.assign(numBB + 1, 0);
+    for (const std::pair<int, int> &m : members)
+        DFStart[m.first + 1]++;
+    for (size_t n = 0; n < numBB; ++n)
+        DFStart[n + 1] += DFStart[n];
+    DFNodes.resize(members.size());
+    std::vector<int> next(DFStart.begin(), DFStart.end() - 1);
+    for (const std::pair<int, int> &m : members)
+        DFNodes[next[m.first]++] = m.second;
 } // end computeDF
 
 bool DataFlow::canRename(Exp *e, UserProc *proc) {
@@ -248,15 +299,15 @@ void DataFlow::dumpA_phi() {
 }
 
 bool DataFlow::placePhiFunctions(UserProc *proc) {
+    auto start = std::chrono::steady_clock::now();
     // First free some memory no longer needed
     dfnum.resize(0);
     semi.resize(0);
     ancestor.resize(0);
-    samedom.resize(0);
+    label.resize(0);
+    evalStack.resize(0);
     vertex.resize(0);
     parent.resize(0);
-    best.resize(0);
-    bucket.resize(0);
     defsites.clear(); // Clear defsites map,
     defallsites.clear();
     for(std::set<Exp *, lessExpStar> &se : A_orig) {
@@ -271,7 +322,7 @@ bool DataFlow::placePhiFunctions(UserProc *proc) {
     bool change = false;
 
     // Set the sizes of needed vectors
-    size_t numBB = indices.size();
+    size_t numBB = BBs.size();
     assert(numBB == proc->getCFG()->getNumBBs());
     A_orig.resize(numBB);
 
@@ -280,7 +331,7 @@ bool DataFlow::placePhiFunctions(UserProc *proc) {
     unsigned n;
     for (n = 0; n < numBB; n++) {
         BasicBlock::rtlit rit;
-        StatementList::iterator sit;
+        BasicBlock::stmtit sit;
         BasicBlock *bb = BBs[n];
         for (Instruction *s = bb->getFirstStmt(rit, sit); s; s = bb->getNextStmt(rit, sit)) {
             LocationSet ls;
@@ -304,10 +355,19 @@ bool DataFlow::placePhiFunctions(UserProc *proc) {
         }
     }
 
+    // Pruned SSA: only place a phi for a where a is live
+    bool pruned = Boomerang::get()->prunedPhis;
+    LocationNumbering liveNums;
+    std::vector<BitSet> liveIn;
+    if (pruned)
+        findLiveIn(proc, liveNums, liveIn);
+    int numPlaced = 0, numPruned = 0;
+
     // For each variable a (in defsites, i.e. defined anywhere)
     std::map<Exp *, std::set<int>, lessExpStar>::iterator mm;
     for (mm = defsites.begin(); mm != defsites.end(); mm++) {
         Exp *a = (*mm).first; // *mm is pair<Exp*, set<int>>
+        int aNum = pruned ? liveNums.find(a) : -1;
 
         // Special processing for define-alls
         // for each n in defallsites
@@ -323,16 +383,19 @@ bool DataFlow::placePhiFunctions(UserProc *proc) {
             int n = *W.begin(); // Copy first element
             W.erase(W.begin()); // Remove first element
             // for each y in DF[n]
-            std::set<int>::iterator yy;
-            std::set<int> &DFn = DF[n];
-            for (yy = DFn.begin(); yy != DFn.end(); yy++) {
-                int y = *yy;
+            for (int y : getDF(n)) {
                 // if y not element of A_phi[a]
                 std::set<int> &s = A_phi[a];
                 if (s.find(y) != s.end())
                     continue;
+                // A phi for a dead location would only be removed later
+                if (pruned && !liveIn[y].exists(aNum)) {
+                    numPruned++;
+                    continue;
+                }
                 // Insert trivial phi function for a at top of block y: a := phi()
                 change = true;
+                numPlaced++;
                 Instruction *as = new PhiAssign(a->clone());
                 BasicBlock *Ybb = BBs[y];
                 Ybb->prependStmt(as, proc);
@@ -346,9 +409,95 @@ bool DataFlow::placePhiFunctions(UserProc *proc) {
             }
         }
     }
+    uint64_t nsecs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    phiStats.Placed += numPlaced;
+    phiStats.Pruned += numPruned;
+    phiStats.Nsecs += nsecs;
+    LOG_VERBOSE(1) << "placed " << numPlaced << " phi functions in " << proc->getName();
+    if (pruned)
+        LOG_VERBOSE(1) << ", " << numPruned << " not placed since not live";
+    LOG_VERBOSE(1) << ", " << (int)(nsecs / 1000) << " us\n";
     return change;
 } // end placePhiFunctions
 
+// Find the locations in defsites that are live at the start of each BB, for pruned phi placement. A location is live
+// if it may be used before it is defined: by a statement that renaming would subscript, by an existing phi for it, or
+// by any call or return, since their DefCollectors take the reaching definition of every location
+void DataFlow::findLiveIn(UserProc *proc, LocationNumbering &liveNums, std::vector<BitSet> &liveIn) {
+    for (auto &ds : defsites)
+        liveNums.number(ds.first);
+    size_t numLocs = liveNums.size();
+    BitSet all(numLocs);
+    for (size_t i = 0; i < numLocs; i++)
+        all.insert(i);
+
+    // The upward exposed uses and the definitions of each BB
+    size_t numBB = BBs.size();
+    std::vector<BitSet> uses(numBB), defs(numBB);
+    for (size_t n = 0; n < numBB; n++) {
+        BasicBlock::rtlit rit;
+        BasicBlock::stmtit sit;
+        BasicBlock *bb = BBs[n];
+        for (Instruction *S = bb->getFirstStmt(rit, sit); S; S = bb->getNextStmt(rit, sit)) {
+            LocationSet locs;
+            if (S->isPhi()) {
+                Exp *phiLeft = ((PhiAssign *)S)->getLeft();
+                if (phiLeft->isMemOf() || phiLeft->isRegOf())
+                    phiLeft->getSubExp1()->addUsedLocs(locs);
+                locs.insert(phiLeft); // Its operands are uses at the ends of the predecessors
+            } else
+                S->addUsedLocs(locs);
+            for (Exp *x : locs) {
+                int i = x->isSubscript() ? -1 : liveNums.find(x);
+                if (i != -1 && !defs[n].exists(i))
+                    uses[n].insert(i);
+            }
+            if (S->isCall() || S->isReturn()) {
+                BitSet exposed(all);
+                exposed.makeDiff(defs[n]);
+                uses[n].makeUnion(exposed);
+            }
+            LocationSet ls;
+            S->getDefinitions(ls);
+            for (Exp *a : ls) {
+                int i = liveNums.find(a);
+                if (i != -1 && canRename(a, proc))
+                    defs[n].insert(i);
+            }
+            if (S->isCall() && ((CallStatement *)S)->isChildless() && !Boomerang::get()->assumeABI)
+                defs[n].makeUnion(all);
+        }
+    }
+
+    // liveIn(n) = uses(n) U (liveOut(n) - defs(n)), where liveOut(n) is the union of liveIn of the successors
+    liveIn = uses;
+    std::vector<int> work(domOrder.begin(), domOrder.end()); // Taken from the back, so roughly bottom up
+    std::vector<bool> queued(numBB, false);
+    for (int n : work)
+        queued[n] = true;
+    while (!work.empty()) {
+        int n = work.back();
+        work.pop_back();
+        queued[n] = false;
+        BitSet in;
+        for (BasicBlock *succ : BBs[n]->getOutEdges()) {
+            if (succ)
+                in.makeUnion(liveIn[indices[succ]]);
+        }
+        in.makeDiff(defs[n]);
+        if (!liveIn[n].makeUnion(in))
+            continue;
+        for (BasicBlock *pred : BBs[n]->getInEdges()) {
+            int p = indices[pred];
+            if (!queued[p]) {
+                queued[p] = true;
+                work.push_back(p);
+            }
+        }
+    }
+}
+
 static Exp *defineAll = new Terminal(opDefineAll); // An expression representing <all>
 
 // There is an entry in stacks[defineAll] that represents the latest definition from a define-all source. It is needed
@@ -362,7 +511,48 @@ static Exp *defineAll = new Terminal(opDefineAll); // An expression representing
 
 // Subscript dataflow variables
 static int dataflow_progress = 0;
+// Rename the variables of block n and of the blocks it dominates. This walks the dominator tree with an explicit
+// stack, so deep trees cannot overflow the call stack: renameBlock() is done for each block on the way down, and
+// popBlockDefs() on the way back up, once all its children are done.
 bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = false */) {
+    bool changed = false;
+
+    // Need to clear the Stacks of old, renamed locations like m[esp-4] (these will be deleted, and will cause compare
+    // failures in the Stacks, so it can't be correctly ordered and hence balanced etc, and will lead to segfaults)
+    if (clearStacks)
+        Stacks.clear();
+
+    // Only renaming from the entry sees every definition, for updateBlockVars() to compare against later
+    clearRenamedDefs();
+    bool record = n == 0;
+
+    std::vector<std::pair<int, bool>> work; // A node, and whether its children are done
+    work.emplace_back(n, false);
+    while (!work.empty()) {
+        std::pair<int, bool> top = work.back();
+        work.pop_back();
+        if (top.second) {
+            popBlockDefs(proc, top.first);
+            continue;
+        }
+        changed |= renameBlock(proc, top.first, record);
+        work.emplace_back(top.first, true);
+        // For each child X of n; pushed in reverse, so they are done in order
+        NodeRange children = getDomChildren(top.first);
+        for (const int *X = children.end(); X != children.begin();)
+            work.emplace_back(*--X, false);
+    }
+    if (record) {
+        renamedDefsValid = true;
+        renamedWithLocalsParams = renameLocalsAndParams;
+        renamedEscapedVars = proc->getAddressEscapedVars();
+    }
+    return changed;
+}
+
+// Subscript the uses in block n and push its definitions onto the Stacks; set the phi operands of its successors.
+// If record is set, the definitions are also appended to renamedDefs
+bool DataFlow::renameBlock(UserProc *proc, int n, bool record) {
     if (++dataflow_progress > 200) {
         LOG_STREAM() << 'r';
         LOG_STREAM().flush();
@@ -371,85 +561,35 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
     }
     bool changed = false;
 
-    // Need to clear the Stacks of old, renamed locations like m[esp-4] (these will be deleted, and will cause compare
-    // failures in the Stacks, so it can't be correctly ordered and hence balanced etc, and will lead to segfaults)
-    if (clearStacks)
-        Stacks.clear();
-
     // For each statement S in block n
     BasicBlock::rtlit rit;
-    StatementList::iterator sit;
+    BasicBlock::stmtit sit;
     BasicBlock *bb = BBs[n];
     Instruction *S;
     for (S = bb->getFirstStmt(rit, sit); S; S = bb->getNextStmt(rit, sit)) {
-        // if S is not a phi function (per Appel)
-        /* if (!S->isPhi()) */ {
-            // For each use of some variable x in S (not just assignments)
-            LocationSet locs;
-            if (S->isPhi()) {
-                PhiAssign *pa = (PhiAssign *)S;
-                Exp *phiLeft = pa->getLeft();
-                if (phiLeft->isMemOf() || phiLeft->isRegOf())
-                    phiLeft->getSubExp1()->addUsedLocs(locs);
-                // A phi statement may use a location defined in a childless call, in which case its use collector
-                // needs updating
-                for (auto &pp : *pa) {
-                    Instruction *def = pp.second.def();
-                    if (def && def->isCall())
-                        ((CallStatement *)def)->useBeforeDefine(phiLeft->clone());
-                }
-            } else { // Not a phi assignment
-                S->addUsedLocs(locs);
-            }
-            LocationSet::iterator xx;
-            for (xx = locs.begin(); xx != locs.end(); xx++) {
-                Exp *x = *xx;
-                // Don't rename memOfs that are not renamable according to the current policy
-                if (!canRename(x, proc))
-                    continue;
-                Instruction *def = nullptr;
-                if (x->isSubscript()) { // Already subscripted?
-                    // No renaming required, but redo the usage analysis, in case this is a new return, and also because
-                    // we may have just removed all call livenesses
-                    // Update use information in calls, and in the proc (for parameters)
-                    Exp *base = ((RefExp *)x)->getSubExp1();
-                    def = ((RefExp *)x)->getDef();
-                    if (def && def->isCall()) {
-                        // Calls have UseCollectors for locations that are used before definition at the call
-                        ((CallStatement *)def)->useBeforeDefine(base->clone());
-                        continue;
-                    }
-                    // Update use collector in the proc (for parameters)
-                    if (def == nullptr)
-                        proc->useBeforeDefine(base->clone());
-                    continue; // Don't re-rename the renamed variable
-                }
-                // Else x is not subscripted yet
-                if (STACKS_EMPTY(x)) {
-                    if (!Stacks[defineAll].empty())
-                        def = Stacks[defineAll].back();
-                    else {
-                        // If the both stacks are empty, use a nullptr definition. This will be changed into a pointer
-                        // to an implicit definition at the start of type analysis, but not until all the m[...]
-                        // have stopped changing their expressions (complicates implicit assignments considerably).
-                        def = nullptr;
-                        // Update the collector at the start of the UserProc
-                        proc->useBeforeDefine(x->clone());
-                    }
-                } else
-                    def = Stacks[x].back();
-                if (def && def->isCall())
-                    // Calls have UseCollectors for locations that are used before definition at the call
-                    ((CallStatement *)def)->useBeforeDefine(x->clone());
-                // Replace the use of x with x{def} in S
-                changed = true;
-                if (S->isPhi()) {
-                    Exp *phiLeft = ((PhiAssign *)S)->getLeft();
-                    phiLeft->setSubExp1(phiLeft->getSubExp1()->expSubscriptVar(x, def /*, this*/));
-                } else {
-                    S->subscriptVar(x, def /*, this */);
-                }
+        // For each use of some variable x in S (not just assignments)
+        LocationSet locs;
+        getRenamableUses(S, locs);
+        for (Exp *x : locs) {
+            // Don't rename memOfs that are not renamable according to the current policy
+            if (!canRename(x, proc))
+                continue;
+            if (x->isSubscript()) { // Already subscripted?
+                updateUses(proc, (RefExp *)x);
+                continue; // Don't re-rename the renamed variable
             }
+            // Else x is not subscripted yet
+            Instruction *def = nullptr;
+            if (STACKS_EMPTY(x)) {
+                // If the both stacks are empty, use a nullptr definition. This will be changed into a pointer to an
+                // implicit definition at the start of type analysis, but not until all the m[...] have stopped
+                // changing their expressions (complicates implicit assignments considerably).
+                if (!Stacks[defineAll].empty())
+                    def = Stacks[defineAll].back();
+            } else
+                def = Stacks[x].back();
+            subscriptUse(proc, S, x, def);
+            changed = true;
         }
 
         // MVE: Check for Call and Return Statements; these have DefCollector objects that need to be updated
@@ -469,6 +609,8 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
         LocationSet::iterator dd;
         for (dd = defs.begin(); dd != defs.end(); dd++) {
             Exp *a = *dd;
+            if (record)
+                renamedDefs.emplace_back(S, a->clone());
             // Don't consider a if it cannot be renamed
             bool suitable = canRename(a, proc);
             if (suitable) {
@@ -496,6 +638,8 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
         // But note that only everythings at the current memory level are defined!
         if (S->isCall() && ((CallStatement *)S)->isChildless() && !Boomerang::get()->assumeABI) {
             // S is a childless call (and we're not assuming ABI compliance)
+            if (record)
+                renamedDefs.emplace_back(S, nullptr);
             Stacks[defineAll]; // Ensure that there is an entry for defineAll
             for (auto &elem : Stacks) {
                 // if (dd->first->isMemDepth(memDepth))
@@ -533,21 +677,19 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
         }
     }
 
-    // For each child X of n
-    // Note: linear search!
-    size_t numBB = proc->getCFG()->getNumBBs();
-    for (size_t X = 0; X < numBB; X++) {
-        if (idom[X] == n)
-            renameBlockVars(proc, X);
-    }
+    return changed;
+}
 
+// Pop the definitions that renameBlock() pushed for block n
+void DataFlow::popBlockDefs(UserProc *proc, int n) {
     // For each statement S in block n
     // NOTE: Because of the need to pop childless calls from the Stacks, it is important in my algorithm to process the
     // statments in the BB *backwards*. (It is not important in Appel's algorithm, since he always pushes a definition
     // for every variable defined on the Stacks).
+    BasicBlock *bb = BBs[n];
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
-    for (S = bb->getLastStmt(rrit, srit); S; S = bb->getPrevStmt(rrit, srit)) {
+    BasicBlock::stmtrit srit;
+    for (Instruction *S = bb->getLastStmt(rrit, srit); S; S = bb->getPrevStmt(rrit, srit)) {
         // For each definition of some variable a in S
         LocationSet defs;
         S->getDefinitions(defs);
@@ -572,7 +714,172 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
             }
         }
     }
-    return changed;
+}
+
+// The uses of S that renaming considers. For a phi, these are only the locations used in the address of its left
+// hand side; also, a phi may use a location defined in a childless call, in which case the call's use collector
+// needs updating
+void DataFlow::getRenamableUses(Instruction *S, LocationSet &locs) {
+    if (!S->isPhi()) {
+        S->addUsedLocs(locs);
+        return;
+    }
+    PhiAssign *pa = (PhiAssign *)S;
+    Exp *phiLeft = pa->getLeft();
+    if (phiLeft->isMemOf() || phiLeft->isRegOf())
+        phiLeft->getSubExp1()->addUsedLocs(locs);
+    for (auto &pp : *pa) {
+        Instruction *def = pp.second.def();
+        if (def && def->isCall())
+            ((CallStatement *)def)->useBeforeDefine(phiLeft->clone());
+    }
+}
+
+// No renaming is required for an already subscripted use, but redo the usage analysis, in case this is a new return,
+// and also because we may have just removed all call livenesses
+void DataFlow::updateUses(UserProc *proc, RefExp *x) {
+    // Update use information in calls, and in the proc (for parameters)
+    Exp *base = x->getSubExp1();
+    Instruction *def = x->getDef();
+    if (def && def->isCall())
+        // Calls have UseCollectors for locations that are used before definition at the call
+        ((CallStatement *)def)->useBeforeDefine(base->clone());
+    else if (def == nullptr)
+        proc->useBeforeDefine(base->clone()); // Update use collector in the proc (for parameters)
+}
+
+// Replace the use of x with x{def} in S, and update the use collectors
+void DataFlow::subscriptUse(UserProc *proc, Instruction *S, Exp *x, Instruction *def) {
+    if (def == nullptr)
+        proc->useBeforeDefine(x->clone()); // Update the collector at the start of the UserProc
+    else if (def->isCall())
+        // Calls have UseCollectors for locations that are used before definition at the call
+        ((CallStatement *)def)->useBeforeDefine(x->clone());
+    if (S->isPhi()) {
+        Exp *phiLeft = ((PhiAssign *)S)->getLeft();
+        phiLeft->setSubExp1(phiLeft->getSubExp1()->expSubscriptVar(x, def /*, this*/));
+    } else {
+        S->subscriptVar(x, def /*, this */);
+    }
+}
+
+void DataFlow::clearRenamedDefs() {
+    for (std::pair<Instruction *, Exp *> &d : renamedDefs)
+        delete d.second;
+    renamedDefs.clear();
+    renamedDefsValid = false;
+}
+
+// True if the definitions in the procedure are still those that the last renaming from the entry saw (in the same
+// order), and the same of them can be renamed, so that the Stacks it would build are the same. Statements may have
+// been added or removed as long as they define nothing
+bool DataFlow::renamedDefsUnchanged(UserProc *proc) {
+    if (!renamedDefsValid || renamedWithLocalsParams != renameLocalsAndParams)
+        return false;
+    if (!(renamedEscapedVars == proc->getAddressEscapedVars()))
+        return false; // canRename() may give different answers
+    size_t k = 0;
+    for (int n : domOrder) {
+        BasicBlock::rtlit rit;
+        BasicBlock::stmtit sit;
+        BasicBlock *bb = BBs[n];
+        for (Instruction *S = bb->getFirstStmt(rit, sit); S; S = bb->getNextStmt(rit, sit)) {
+            // A new call or return would need its DefCollector filled in
+            if (S->isCall() && !((CallStatement *)S)->getDefCollector()->isInitialised())
+                return false;
+            if (S->isReturn() && !((ReturnStatement *)S)->getCollector()->isInitialised())
+                return false;
+            LocationSet defs;
+            S->getDefinitions(defs);
+            for (Exp *a : defs) {
+                if (k == renamedDefs.size() || renamedDefs[k].first != S || renamedDefs[k].second == nullptr ||
+                    !(*renamedDefs[k].second == *a))
+                    return false;
+                ++k;
+            }
+            if (S->isCall() && ((CallStatement *)S)->isChildless() && !Boomerang::get()->assumeABI) {
+                if (k == renamedDefs.size() || renamedDefs[k].first != S || renamedDefs[k].second != nullptr)
+                    return false;
+                ++k;
+            }
+        }
+    }
+    return k == renamedDefs.size();
+}
+
+// True if S pushes a definition for x onto the Stacks when renaming
+bool DataFlow::definesForRenaming(UserProc *proc, Instruction *S, Exp *x) {
+    if (S->isCall() && ((CallStatement *)S)->isChildless() && !Boomerang::get()->assumeABI)
+        return true; // A define-all
+    LocationSet defs;
+    S->getDefinitions(defs);
+    for (Exp *a : defs) {
+        if (!canRename(a, proc))
+            continue;
+        if (*a == *x)
+            return true;
+        if (a->getOper() == opLocal) {
+            const Exp *a1 = S->getProc()->expFromSymbol(((Const *)a->getSubExp1())->getStr());
+            if (a1 && *a1 == *x)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Subscript the uses that are not subscripted yet (e.g. those that propagation has just made) without renaming the
+// whole procedure again. The definition of each one is found by looking back through its BB, then up the dominator
+// tree; this is the definition that renameBlockVars would have on top of its Stacks, as long as no definition has
+// changed since it last ran from the entry. Returns false, having done nothing, if that is not so: a full
+// renameBlockVars is needed then. Already subscripted uses have their usage analysis redone, as renameBlockVars does.
+// With the same definitions, the collectors of calls and returns and the phi operands would also be the same, so they
+// are left alone. Every statement is still visited, so this is only cheaper than renameBlockVars, not proportional to
+// the number of new uses; middleDecompile still renames everything after propagation.
+bool DataFlow::updateBlockVars(UserProc *proc, bool &changed) {
+    changed = false;
+    if (!renamedDefsUnchanged(proc))
+        return false;
+    std::vector<Instruction *> before; // The statements of the BB before S
+    std::vector<Instruction *> domStmts;
+    for (int n : domOrder) {
+        BasicBlock::rtlit rit;
+        BasicBlock::stmtit sit;
+        BasicBlock *bb = BBs[n];
+        before.clear();
+        for (Instruction *S = bb->getFirstStmt(rit, sit); S; S = bb->getNextStmt(rit, sit)) {
+            LocationSet locs;
+            getRenamableUses(S, locs);
+            for (Exp *x : locs) {
+                if (!canRename(x, proc))
+                    continue;
+                if (x->isSubscript()) {
+                    updateUses(proc, (RefExp *)x);
+                    continue;
+                }
+                Instruction *def = nullptr;
+                const std::vector<Instruction *> *stmts = &before;
+                for (int d = n;;) {
+                    for (auto it = stmts->rbegin(); it != stmts->rend() && !def; ++it) {
+                        if (definesForRenaming(proc, *it, x))
+                            def = *it;
+                    }
+                    d = idom[d];
+                    if (def || d == -1)
+                        break;
+                    domStmts.clear();
+                    BasicBlock::rtlit drit;
+                    BasicBlock::stmtit dsit;
+                    for (Instruction *T = BBs[d]->getFirstStmt(drit, dsit); T; T = BBs[d]->getNextStmt(drit, dsit))
+                        domStmts.push_back(T);
+                    stmts = &domStmts;
+                }
+                subscriptUse(proc, S, x, def);
+                changed = true;
+            }
+            before.push_back(S);
+        }
+    }
+    return true;
 }
 
 void DataFlow::dumpStacks() {
@@ -819,7 +1126,7 @@ void DataFlow::findLiveAtDomPhi(int n, LocationSet &usedByDomPhi, LocationSet &u
                                 std::map<Exp *, PhiAssign *, lessExpStar> &defdByPhi) {
     // For each statement this BB
     BasicBlock::rtlit rit;
-    StatementList::iterator sit;
+    BasicBlock::stmtit sit;
     BasicBlock *bb = BBs[n];
     Instruction *S;
     for (S = bb->getFirstStmt(rit, sit); S; S = bb->getNextStmt(rit, sit)) {
@@ -860,32 +1167,21 @@ void DataFlow::findLiveAtDomPhi(int n, LocationSet &usedByDomPhi, LocationSet &u
     }
 
     // Visit each child in the dominator graph
-    // Note: this is a linear search!
-    // Note also that usedByDomPhi0 may have some irrelevant entries, but this will do no harm, and attempting to erase
+    // Note that usedByDomPhi0 may have some irrelevant entries, but this will do no harm, and attempting to erase
     // the irrelevant ones would probably cost more than leaving them alone
-    int sz = idom.size();
-    for (int c = 0; c < sz; ++c) {
-        if (idom[c] != n)
-            continue;
-        // Recurse to the child
+    for (int c : getDomChildren(n))
         findLiveAtDomPhi(c, usedByDomPhi, usedByDomPhi0, defdByPhi);
-    }
 }
 
 void DataFlow::setDominanceNums(int n, int &currNum) {
 #if USE_DOMINANCE_NUMS
     BasicBlock::rtlit rit;
-    StatementList::iterator sit;
+    BasicBlock::stmtit sit;
     BasicBlock *bb = BBs[n];
     Instruction *S;
     for (S = bb->getFirstStmt(rit, sit); S; S = bb->getNextStmt(rit, sit))
         S->setDomNumber(currNum++);
-    int sz = idom.size();
-    for (int c = 0; c < sz; ++c) {
-        if (idom[c] != n)
-            continue;
-        // Recurse to the child
-        setDominanceNums(c, currNum);
-    }
+    for (int c : getDomChildren(n))
+        setDominanceNums(c, currNum); // Recurse to the child
 #endif
 }
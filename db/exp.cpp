@@ -12,6 +12,7 @@
 #include <map>       // In decideType()
 #include <sstream>   // Need gcc 3.0 or better
 #include <cstring>
+#include <chrono>
 #include "types.h"
 #include "statement.h"
 #include "cfg.h"
@@ -28,6 +29,7 @@
 #include "visitor.h"
 #include "log.h"
 #include <QRegularExpression>
+#include <QHash>
 #include <iomanip> // For std::setw etc
 
 extern char debug_buffer[]; ///< For prints functions
@@ -182,6 +184,7 @@ void Unary::setSubExp1(Exp *e) {
         ; // delete subExp1;
     }
     subExp1 = e;
+    simplified = false;
     assert(subExp1);
 }
 void Binary::setSubExp2(Exp *e) {
@@ -189,6 +192,7 @@ void Binary::setSubExp2(Exp *e) {
         ; // delete subExp2;
     }
     subExp2 = e;
+    simplified = false;
     assert(subExp1 && subExp2);
 }
 void Ternary::setSubExp3(Exp *e) {
@@ -196,6 +200,7 @@ void Ternary::setSubExp3(Exp *e) {
         ; // delete subExp3;
     }
     subExp3 = e;
+    simplified = false;
     assert(subExp1 && subExp2 && subExp3);
 }
 /***************************************************************************/ /**
@@ -213,6 +218,7 @@ const Exp *Unary::getSubExp1() const {
 }
 Exp *&Unary::refSubExp1() {
     assert(subExp1);
+    simplified = false; // The caller may change it
     return subExp1;
 }
 Exp *Binary::getSubExp2() {
@@ -225,6 +231,7 @@ const Exp *Binary::getSubExp2() const {
 }
 Exp *&Binary::refSubExp2() {
     assert(subExp1 && subExp2);
+    simplified = false;
     return subExp2;
 }
 Exp *Ternary::getSubExp3() {
@@ -237,9 +244,15 @@ const Exp *Ternary::getSubExp3() const {
 }
 Exp *&Ternary::refSubExp3() {
     assert(subExp1 && subExp2 && subExp3);
+    simplified = false;
     return subExp3;
 }
 
+thread_local SimplifyStats *SimplifyStats::Current = nullptr;
+//! How many calls of Exp::simplify are in progress; only the outermost one is counted in the SimplifyStats
+static thread_local int simplifyDepth = 0;
+Exp *(*Exp::ruleSimplifier)(Exp *e, bool &bMod) = nullptr;
+
 // This to satisfy the compiler (never gets called!)
 Exp *dummy;
 Exp *&Exp::refSubExp1() { return dummy; }
@@ -311,6 +324,20 @@ Exp *Location::clone() const {
     return c;
 }
 
+/***************************************************************************/ /**
+  *
+  * \brief        Copy only the top node of this expression. The copy points to the same subexpressions as this
+  *                     one, so neither may be changed in place afterwards. Used by substitute().
+  * \returns            Pointer to the new node
+  ******************************************************************************/
+Exp *Unary::shallowCopy() const { return new Unary(op, subExp1); }
+Exp *Binary::shallowCopy() const { return new Binary(op, subExp1, subExp2); }
+Exp *Ternary::shallowCopy() const { return new Ternary(op, subExp1, subExp2, subExp3); }
+Exp *TypedExp::shallowCopy() const { return new TypedExp(type, subExp1); }
+Exp *FlagDef::shallowCopy() const { return new FlagDef(subExp1, rtl); }
+Exp *RefExp::shallowCopy() const { return new RefExp(subExp1, def); }
+Exp *Location::shallowCopy() const { return new Location(op, subExp1, proc); }
+
 /***************************************************************************/ /**
   *
   * \brief        Virtual function to compare myself for equality with
@@ -1870,32 +1897,69 @@ bool Location::match(const QString &pattern, std::map<QString, Exp *> &bindings)
     return false;
 }
 
+namespace {
+//! Appends the location of each match to a container of Exp **; with \a once, stops after the first
+template <class Container> class MatchLocations : public SearchCallback {
+  public:
+    MatchLocations(Container &matches, bool once) : Matches(matches), Once(once) {}
+    bool found(Exp **pp) override {
+        Matches.push_back(pp);
+        return !Once;
+    }
+
+  private:
+    Container &Matches;
+    bool Once;
+};
+
+//! Appends each match to a container of Exp *
+template <class Container> class MatchValues : public SearchCallback {
+  public:
+    explicit MatchValues(Container &matches) : Matches(matches) {}
+    bool found(Exp **pp) override {
+        Matches.push_back(*pp);
+        return true;
+    }
+
+  private:
+    Container &Matches;
+};
+}
+
 /***************************************************************************/ /**
   *
   * \brief   Search for the given subexpression
-  * \note    Caller must free the list li after use, but not the Exp objects that they point to
-  * \note    If the top level expression matches, li will contain search
-  * \note    Now a static function. Searches pSrc, not this
+  * \note    If the top level expression matches, cb is passed &pSrc
+  * \note    A static function. Searches pSrc, not this
   * \param   search ptr to Exp we are searching for
   * \param   pSrc ref to ptr to Exp to search. Reason is that we can then overwrite that pointer
-  *               to effect a replacement. So we need to append &pSrc in the list. Can't append &this!
-  * \param   li   list of Exp** where pointers to the matches are found once: true if not all occurrences to be
-  *                    found, false for all
-  * \param   once if set to true only the first possible replacement will be made
+  *               to effect a replacement. So the callback gets &pSrc. Can't pass &this!
+  * \param   cb   called with a pointer to the pointer to each match; returns false to stop the search
+  * \returns false if the search was stopped by cb
   *
   ******************************************************************************/
-void Exp::doSearch(const Exp &search, Exp *&pSrc, std::list<Exp **> &li, bool once) {
-    bool compare;
-    compare = (search == *pSrc);
-    if (compare) {
-        li.push_back(&pSrc); // Success
-        if (once)
-            return; // No more to do
-    }
+bool Exp::doSearch(const Exp &search, Exp *&pSrc, SearchCallback &cb) {
+    bool compare = (search == *pSrc);
+    if (compare && !cb.found(&pSrc))
+        return false; // No more to do
     // Either want to find all occurrences, or did not match at this level
     // Recurse into children, unless a matching opSubscript
     if (!compare || pSrc->op != opSubscript)
-        pSrc->doSearchChildren(search, li, once);
+        return pSrc->doSearchChildren(search, cb);
+    return true;
+}
+
+/***************************************************************************/ /**
+  *
+  * \brief   As above, appending the matches to a list
+  * \note    Caller must free the list li after use, but not the Exp objects that they point to
+  * \param   li   list of Exp** where pointers to the matches are found
+  * \param   once if set to true only the first match is found
+  *
+  ******************************************************************************/
+void Exp::doSearch(const Exp &search, Exp *&pSrc, std::list<Exp **> &li, bool once) {
+    MatchLocations<std::list<Exp **>> collect(li, once);
+    doSearch(search, pSrc, collect);
 }
 
 /***************************************************************************/ /**
@@ -1904,35 +1968,26 @@ void Exp::doSearch(const Exp &search, Exp *&pSrc, std::list<Exp **> &li, bool on
   * \note        Virtual function; different implementation for each subclass of Exp
   * \note            Will recurse via doSearch
   * \param       search - ptr to Exp we are searching for
-  * \param       li - list of Exp** where pointers to the matches are found
-  * \param       once - true if not all occurrences to be found, false for all
+  * \param       cb - receives the matches
+  * \returns     false if the search was stopped by cb
   *
   ******************************************************************************/
-void Exp::doSearchChildren(const Exp & search, std::list<Exp **> & li, bool once) {
+bool Exp::doSearchChildren(const Exp &search, SearchCallback &cb) {
     Q_UNUSED(search);
-    Q_UNUSED(li);
-    Q_UNUSED(once);
-    return; // Const and Terminal do not override this
+    Q_UNUSED(cb);
+    return true; // Const and Terminal do not override this
 }
-void Unary::doSearchChildren(const Exp &search, std::list<Exp **> &li, bool once) {
-    if (op != opInitValueOf) // don't search child
-        doSearch(search, subExp1, li, once);
+bool Unary::doSearchChildren(const Exp &search, SearchCallback &cb) {
+    if (op == opInitValueOf) // don't search child
+        return true;
+    return doSearch(search, subExp1, cb);
 }
-void Binary::doSearchChildren(const Exp &search, std::list<Exp **> &li, bool once) {
+bool Binary::doSearchChildren(const Exp &search, SearchCallback &cb) {
     assert(subExp1 && subExp2);
-    doSearch(search, subExp1, li, once);
-    if (once && li.size())
-        return;
-    doSearch(search, subExp2, li, once);
+    return doSearch(search, subExp1, cb) && doSearch(search, subExp2, cb);
 }
-void Ternary::doSearchChildren(const Exp &search, std::list<Exp **> &li, bool once) {
-    doSearch(search, subExp1, li, once);
-    if (once && li.size())
-        return;
-    doSearch(search, subExp2, li, once);
-    if (once && li.size())
-        return;
-    doSearch(search, subExp3, li, once);
+bool Ternary::doSearchChildren(const Exp &search, SearchCallback &cb) {
+    return doSearch(search, subExp1, cb) && doSearch(search, subExp2, cb) && doSearch(search, subExp3, cb);
 }
 
 /***************************************************************************/ /**
@@ -1971,23 +2026,78 @@ Exp *Exp::searchReplaceAll(const Exp &search, Exp *replace, bool &change, bool o
         return replace->clone();
     }
     assert(this != &search);
-    std::list<Exp **> li;
+    // Find all the matches before replacing any, else the search would continue into the replacements
+    SmallVector<Exp **, 8> matches;
+    MatchLocations<SmallVector<Exp **, 8>> collect(matches, once);
     Exp *top = this; // top may change; that's why we have to return it
-    doSearch(search, top, li, false);
-    std::list<Exp **>::iterator it;
-    for (it = li.begin(); it != li.end(); it++) {
-        Exp **pp = *it;
+    doSearch(search, top, collect);
+    for (Exp **pp : matches) {
         // if (*pp) //delete *pp;         // Delete any existing
         *pp = replace->clone(); // Do the replacement
-        if (once) {
-            change = true;
-            return top;
-        }
     }
-    change = (li.size() != 0);
+    change = !matches.empty();
     return top;
 }
 
+/***************************************************************************/ /**
+  *
+  * \brief   Persistent search and replace: the result is this expression with every occurrence of search
+  *          replaced by replace, but neither this expression nor replace is changed or cloned. Only the nodes on
+  *          the path from the root to each match are copied; the rest of the result, and every replaced
+  *          occurrence, share their nodes with this and replace. The cost is proportional to the size of the
+  *          change, not of the expression.
+  * \note    Because nodes are shared, the result, this and replace must all be treated as immutable afterwards
+  *          (no simplify(), setSubExp1() etc.). Clone the result to get a private copy that may be changed.
+  * \param   search - reference to Exp we are searching for
+  * \param   replace - the replacement, used as is for every match
+  * \param   change - set true if a change made; cleared otherwise
+  * \returns the result; this if there were no matches
+  ******************************************************************************/
+Exp *Exp::substitute(const Exp &search, Exp *replace, bool &change) {
+    Exp *res = doSubstitute(search, replace);
+    change = res != this;
+    return res;
+}
+
+Exp *Exp::doSubstitute(const Exp &search, Exp *replace) {
+    if (search == *this)
+        return replace; // As with searchReplaceAll, the outermost match wins
+    return substituteChildren(search, replace);
+}
+Exp *Unary::substituteChildren(const Exp &search, Exp *replace) {
+    if (op == opInitValueOf) // don't search child
+        return this;
+    Exp *e1 = subExp1->doSubstitute(search, replace);
+    if (e1 == subExp1)
+        return this;
+    Unary *res = (Unary *)shallowCopy();
+    res->subExp1 = e1;
+    return res;
+}
+Exp *Binary::substituteChildren(const Exp &search, Exp *replace) {
+    assert(subExp1 && subExp2);
+    Exp *e1 = subExp1->doSubstitute(search, replace);
+    Exp *e2 = subExp2->doSubstitute(search, replace);
+    if (e1 == subExp1 && e2 == subExp2)
+        return this;
+    Binary *res = (Binary *)shallowCopy();
+    res->subExp1 = e1;
+    res->subExp2 = e2;
+    return res;
+}
+Exp *Ternary::substituteChildren(const Exp &search, Exp *replace) {
+    Exp *e1 = subExp1->doSubstitute(search, replace);
+    Exp *e2 = subExp2->doSubstitute(search, replace);
+    Exp *e3 = subExp3->doSubstitute(search, replace);
+    if (e1 == subExp1 && e2 == subExp2 && e3 == subExp3)
+        return this;
+    Ternary *res = (Ternary *)shallowCopy();
+    res->subExp1 = e1;
+    res->subExp2 = e2;
+    res->subExp3 = e3;
+    return res;
+}
+
 /***************************************************************************/ /**
   *
   * \brief        Search this expression for the given subexpression, and if found, return true and return a pointer
@@ -1999,17 +2109,13 @@ Exp *Exp::searchReplaceAll(const Exp &search, Exp *replace, bool &change, bool o
   * \returns            True if a match was found
   ******************************************************************************/
 bool Exp::search(const Exp &search, Exp *&result) {
-    std::list<Exp **> li;
     result = nullptr; // In case it fails; don't leave it unassigned
-    // The search requires a reference to a pointer to this object.
-    // This isn't needed for searches, only for replacements, but we want to re-use the same search routine
-    Exp *top = this;
-    doSearch(search, top, li, false);
-    if (li.size()) {
-        result = *li.front();
-        return true;
-    }
-    return false;
+    auto first = searchWith([&result](Exp *e) {
+        result = e;
+        return false; // The first match is all we want
+    });
+    searchEach(search, first);
+    return result != nullptr;
 }
 
 /***************************************************************************/ /**
@@ -2021,19 +2127,35 @@ bool Exp::search(const Exp &search, Exp *&result) {
   * \returns            True if a match was found
   ******************************************************************************/
 bool Exp::searchAll(const Exp &search, std::list<Exp *> &result) {
-    std::list<Exp **> li;
     // result.clear();    // No! Useful when searching for more than one thing
     // (add to the same list)
+    size_t before = result.size();
+    MatchValues<std::list<Exp *>> collect(result);
+    searchEach(search, collect);
+    return result.size() != before;
+}
+
+//! As above, but the first few matches are stored without allocating
+bool Exp::searchAll(const Exp &search, ExpMatches &result) {
+    size_t before = result.size();
+    MatchValues<ExpMatches> collect(result);
+    searchEach(search, collect);
+    return result.size() != before;
+}
+
+/***************************************************************************/ /**
+  *
+  * \brief        Pass each match of the given subexpression in this expression to a callback, without collecting
+  *                      them
+  * \param   search     ptr to Exp we are searching for
+  * \param   cb         receives the matches; returns false to stop the search
+  * \returns            false if the search was stopped by cb
+  ******************************************************************************/
+bool Exp::searchEach(const Exp &search, SearchCallback &cb) {
     // The search requires a reference to a pointer to this object.
     // This isn't needed for searches, only for replacements, but we want to re-use the same search routine
-    Exp *pSrc = this;
-    doSearch(search, pSrc, li, false);
-    std::list<Exp **>::iterator it;
-    for (it = li.begin(); it != li.end(); it++) {
-        // li is list of Exp**; result is list of Exp*
-        result.push_back(**it);
-    }
-    return li.size() != 0;
+    Exp *top = this;
+    return doSearch(search, top, cb);
 }
 
 // These simplifying functions don't really belong in class Exp, but they know too much about how Exps work
@@ -2103,22 +2225,22 @@ void Exp::partitionTerms(std::list<Exp *> &positives, std::list<Exp *> &negative
 Exp *Unary::simplifyArith() {
     if (op == opMemOf || op == opRegOf || op == opAddrOf || op == opSubscript) {
         // assume we want to simplify the subexpression
-        subExp1 = subExp1->simplifyArith();
+        replaceSubExp(subExp1, subExp1->simplifyArith());
     }
     return this; // Else, do nothing
 }
 
 Exp *Ternary::simplifyArith() {
-    subExp1 = subExp1->simplifyArith();
-    subExp2 = subExp2->simplifyArith();
-    subExp3 = subExp3->simplifyArith();
+    replaceSubExp(subExp1, subExp1->simplifyArith());
+    replaceSubExp(subExp2, subExp2->simplifyArith());
+    replaceSubExp(subExp3, subExp3->simplifyArith());
     return this;
 }
 
 Exp *Binary::simplifyArith() {
     assert(subExp1 && subExp2);
-    subExp1 = subExp1->simplifyArith(); // FIXME: does this make sense?
-    subExp2 = subExp2->simplifyArith(); // FIXME: ditto
+    replaceSubExp(subExp1, subExp1->simplifyArith()); // FIXME: does this make sense?
+    replaceSubExp(subExp2, subExp2->simplifyArith()); // FIXME: ditto
     if ((op != opPlus) && (op != opMinus))
         return this;
 
@@ -2230,26 +2352,46 @@ Exp *Exp::Accumulate(std::list<Exp *> exprs) {
       * We're trying to do it with a simple iterative algorithm, but the algorithm keeps getting more and more complex.
       * Eventually I will replace this with a simple theorem prover and we'll have something powerful, but until then,
       * dont rely on this code to do anything critical. - trent 8/7/2002
+      *
+      * All the nodes of the result are marked as simplified, so simplifying them again is just a walk over the tree
+      * as long as none of them is changed.
       ******************************************************************************/
 #define DEBUG_SIMP 0                                                              // Set to 1 to print every change
 Exp *Exp::simplify() {
+    // A nested call (e.g. from polySimplify) is part of the work of the outer one, so it is neither counted nor timed
+    SimplifyStats *stats = simplifyDepth == 0 ? SimplifyStats::Current : nullptr;
+    struct Nesting {
+        Nesting() { simplifyDepth++; }
+        ~Nesting() { simplifyDepth--; }
+    } nesting;
+    if (stats)
+        stats->Calls++;
+    if (isSimplifiedTree()) {
+        if (stats)
+            stats->Skipped++;
+        return this;
+    }
+    auto start = std::chrono::steady_clock::now();
 #if DEBUG_SIMP
     Exp *save = clone();
 #endif
     bool bMod = false; // True if simplified at this or lower level
     Exp *res = this;
-    // res = ExpTransformer::applyAllTo(res, bMod);
-    // return res;
     do {
         bMod = false;
         // Exp *before = res->clone();
-        res = res->polySimplify(bMod); // Call the polymorphic simplify
+        if (ruleSimplifier)
+            res = ruleSimplifier(res, bMod);
+        else
+            res = res->polySimplify(bMod); // Call the polymorphic simplify
                                        /*      if (bMod) {
                                                        LOG << "polySimplify hit: " << before << " to " << res << "\n";
                                                        // polySimplify is now redundant, if you see this in the log you need to update one of the files
                                           in the
                                                        // transformations directory to include a rule for the reported transform.
                                                } */
+        if (bMod && stats)
+            stats->Rewrites++;
     } while (bMod);                    // If modified at this (or a lower) level, redo
 // The below is still important. E.g. want to canonicalise sums, so we know that a + K + b is the same as a + b + K
 // No! This slows everything down, and it's slow enough as it is. Call only where needed:
@@ -2259,9 +2401,30 @@ Exp *Exp::simplify() {
         std::cout << "simplified " << save << "  to  " << res << "\n";
     ; // delete save;
 #endif
+    res->markSimplified();
+    if (stats)
+        stats->Nsecs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                            .count();
     return res;
 }
 
+bool Unary::isSimplifiedTree() const { return simplified && subExp1->isSimplifiedTree(); }
+bool Binary::isSimplifiedTree() const { return Unary::isSimplifiedTree() && subExp2->isSimplifiedTree(); }
+bool Ternary::isSimplifiedTree() const { return Binary::isSimplifiedTree() && subExp3->isSimplifiedTree(); }
+
+void Unary::markSimplified() {
+    simplified = true;
+    subExp1->markSimplified();
+}
+void Binary::markSimplified() {
+    Unary::markSimplified();
+    subExp2->markSimplified();
+}
+void Ternary::markSimplified() {
+    Binary::markSimplified();
+    subExp3->markSimplified();
+}
+
 /***************************************************************************/ /**
   *
   * \brief        Do the work of simplification
@@ -3289,7 +3452,7 @@ Exp *Unary::simplifyAddr() {
     }
     if (op != opAddrOf) {
         // Not a[ anything ]. Recurse
-        subExp1 = subExp1->simplifyAddr();
+        replaceSubExp(subExp1, subExp1->simplifyAddr());
         return this;
     }
     if (subExp1->getOper() == opMemOf) {
@@ -3309,22 +3472,22 @@ Exp *Unary::simplifyAddr() {
     }
 
     // a[ something else ]. Still recurse, just in case
-    subExp1 = subExp1->simplifyAddr();
+    replaceSubExp(subExp1, subExp1->simplifyAddr());
     return this;
 }
 
 Exp *Binary::simplifyAddr() {
     assert(subExp1 && subExp2);
 
-    subExp1 = subExp1->simplifyAddr();
-    subExp2 = subExp2->simplifyAddr();
+    replaceSubExp(subExp1, subExp1->simplifyAddr());
+    replaceSubExp(subExp2, subExp2->simplifyAddr());
     return this;
 }
 
 Exp *Ternary::simplifyAddr() {
-    subExp1 = subExp1->simplifyAddr();
-    subExp2 = subExp2->simplifyAddr();
-    subExp3 = subExp3->simplifyAddr();
+    replaceSubExp(subExp1, subExp1->simplifyAddr());
+    replaceSubExp(subExp2, subExp2->simplifyAddr());
+    replaceSubExp(subExp3, subExp3->simplifyAddr());
     return this;
 }
 
@@ -3441,16 +3604,18 @@ Exp *Exp::fixSuccessor() {
   * \returns            Fixed expression
   ******************************************************************************/
 Exp *Exp::killFill() {
-    static Ternary srch1(opZfill, new Terminal(opWild), new Terminal(opWild), new Terminal(opWild));
-    static Ternary srch2(opSgnEx, new Terminal(opWild), new Terminal(opWild), new Terminal(opWild));
+    static Ternary &srch1 = *onHeap(
+        [] { return new Ternary(opZfill, new Terminal(opWild), new Terminal(opWild), new Terminal(opWild)); });
+    static Ternary &srch2 = *onHeap(
+        [] { return new Ternary(opSgnEx, new Terminal(opWild), new Terminal(opWild), new Terminal(opWild)); });
     Exp *res = this;
-    std::list<Exp **> result;
-    doSearch(srch1, res, result, false);
-    doSearch(srch2, res, result, false);
-    std::list<Exp **>::iterator it;
-    for (it = result.begin(); it != result.end(); it++) {
+    SmallVector<Exp **, 8> result;
+    MatchLocations<SmallVector<Exp **, 8>> collect(result, false);
+    doSearch(srch1, res, collect);
+    doSearch(srch2, res, collect);
+    for (Exp **pp : result) {
         // Kill the sign extend bits
-        **it = ((Ternary *)(**it))->getSubExp3();
+        *pp = ((Ternary *)*pp)->getSubExp3();
     }
     return res;
 }
@@ -3491,11 +3656,14 @@ Exp *Exp::removeSubscripts(bool &allZero) {
 // what is wanted!
 Exp *Exp::fromSSAleft(UserProc *proc, Instruction *d) {
     RefExp *r = new RefExp(this, d); // "Wrap" in a ref
-    return r->accept(new ExpSsaXformer(proc));
+    ExpSsaXformer esx(proc);
+    return r->accept(&esx);
 }
 
 // A helper class for comparing Exp*'s sensibly
 bool lessExpStar::operator()(const Exp *x, const Exp *y) const {
+    if (x == y)
+        return false; // E.g. finding a key with itself, or canonical (interned) expressions
     return (*x < *y); // Compare the actual Exps
 }
 bool lessExpShared::operator()(const std::shared_ptr<Exp> &x, const std::shared_ptr<Exp> &y) const {
@@ -3506,6 +3674,175 @@ bool lessTI::operator()(const Exp *x, const Exp *y) const {
     return (*x << *y); // Compare the actual Exps
 }
 
+//    //    //    //    //    //
+//     ExpInterner      //
+//    //    //    //    //    //
+
+ExpInterner::~ExpInterner() { clear(); }
+
+//! Delete all the canonical nodes; any pointers to them become invalid
+void ExpInterner::clear() {
+    // Note: deleting an Exp does not delete its subexpressions, so each node is deleted exactly once
+    for (const std::pair<const Exp *const, uint32_t> &elem : Hashes)
+        delete elem.first;
+    Hashes.clear();
+    Table.clear();
+}
+
+static bool isLocationOper(OPER op) {
+    return op == opRegOf || op == opMemOf || op == opLocal || op == opGlobal || op == opParam || op == opTemp;
+}
+
+//! True if the top node of e can be interned (the subexpressions are not checked)
+static bool isInternableNode(const Exp *e) {
+    OPER op = e->getOper();
+    switch (op) {
+    case opWild:
+    case opWildIntConst:
+    case opWildStrConst:
+    case opWildMemOf:
+    case opWildRegOf:
+    case opWildAddrOf:
+    case opSubscript:
+    case opTypedExp:
+    case opFlagDef:
+    case opTypeVal:
+    case opLongConst: // Const::operator== can't compare these
+    case opFuncConst:
+        return false;
+    case opIntConst:
+    case opFltConst:
+    case opStrConst:
+        return ((const Const *)e)->getConscript() == 0;
+    default:
+        break;
+    }
+    switch (e->getArity()) {
+    case 0:
+        return dynamic_cast<const Terminal *>(e) != nullptr;
+    case 1:
+        return dynamic_cast<const Unary *>(e) != nullptr;
+    case 2:
+        return dynamic_cast<const Binary *>(e) != nullptr;
+    case 3:
+        return dynamic_cast<const Ternary *>(e) != nullptr;
+    }
+    return false;
+}
+
+//! True if e, including all its subexpressions, can be interned
+bool ExpInterner::isInternable(const Exp *e) {
+    if (!isInternableNode(e))
+        return false;
+    switch (e->getArity()) {
+    case 3:
+        if (!isInternable(e->getSubExp3()))
+            return false;
+    // Fall through
+    case 2:
+        if (!isInternable(e->getSubExp2()))
+            return false;
+    // Fall through
+    case 1:
+        return isInternable(e->getSubExp1());
+    }
+    return true;
+}
+
+static inline uint32_t hashCombine(uint32_t h, uint32_t v) { return (h ^ v) * 16777619u + (h >> 13); }
+
+/***************************************************************************/ /**
+  * \brief Get the canonical node for e
+  * \param e - the expression to intern; not changed or kept
+  * \returns the canonical node, or nullptr if e is not internable
+  ******************************************************************************/
+const Exp *ExpInterner::intern(const Exp *e) {
+    uint32_t hash;
+    return internSub(e, hash);
+}
+
+//! Return the structural hash of a canonical node of this interner
+uint32_t ExpInterner::hashOf(const Exp *canonical) const {
+    auto found = Hashes.find(canonical);
+    assert(found != Hashes.end());
+    return found->second;
+}
+
+const Exp *ExpInterner::internSub(const Exp *e, uint32_t &hash) {
+    if (!isInternableNode(e))
+        return nullptr;
+    OPER op = e->getOper();
+    int arity = e->getArity();
+    const Exp *subs[3] = {nullptr, nullptr, nullptr};
+    hash = hashCombine(2166136261u, op);
+    if (arity == 0) {
+        switch (op) {
+        case opIntConst:
+            hash = hashCombine(hash, ((const Const *)e)->getInt());
+            break;
+        case opFltConst: {
+            double d = ((const Const *)e)->getFlt();
+            if (d == 0)
+                d = 0; // -0.0 == 0.0
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            hash = hashCombine(hashCombine(hash, uint32_t(bits)), uint32_t(bits >> 32));
+            break;
+        }
+        case opStrConst:
+            hash = hashCombine(hash, qHash(((const Const *)e)->getStr()));
+            break;
+        default:
+            break;
+        }
+    } else {
+        const Exp *orig[3] = {e->getSubExp1(), e->getSubExp2(), e->getSubExp3()};
+        for (int i = 0; i < arity; i++) {
+            uint32_t subHash;
+            subs[i] = internSub(orig[i], subHash);
+            if (subs[i] == nullptr)
+                return nullptr;
+            hash = hashCombine(hash, subHash);
+        }
+    }
+    // Look for an existing node. Unary and Location nodes with the same operator compare equal, so they share a node
+    auto range = Table.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const Exp *cand = it->second;
+        if (cand->getOper() != op || cand->getArity() != arity)
+            continue;
+        if (arity == 0) {
+            if (*cand == *e)
+                return cand;
+            continue;
+        }
+        if (cand->getSubExp1() == subs[0] && (arity < 2 || cand->getSubExp2() == subs[1]) &&
+            (arity < 3 || cand->getSubExp3() == subs[2]))
+            return cand;
+    }
+    Exp *res;
+    switch (arity) {
+    case 0:
+        res = e->clone();
+        break;
+    case 1:
+        if (isLocationOper(op))
+            res = new Location(op, const_cast<Exp *>(subs[0]), nullptr);
+        else
+            res = new Unary(op, const_cast<Exp *>(subs[0]));
+        break;
+    case 2:
+        res = new Binary(op, const_cast<Exp *>(subs[0]), const_cast<Exp *>(subs[1]));
+        break;
+    default:
+        res = new Ternary(op, const_cast<Exp *>(subs[0]), const_cast<Exp *>(subs[1]), const_cast<Exp *>(subs[2]));
+        break;
+    }
+    Table.emplace(hash, res);
+    Hashes[res] = hash;
+    return res;
+}
+
 //    //    //    //    //    //
 //    genConstraints    //
 //    //    //    //    //    //
@@ -3871,15 +4208,15 @@ void Location::getDefinitions(LocationSet &defs) {
 QString Const::getFuncName() const { return u.pp->getName(); }
 
 Exp *Unary::simplifyConstraint() {
-    subExp1 = subExp1->simplifyConstraint();
+    replaceSubExp(subExp1, subExp1->simplifyConstraint());
     return this;
 }
 
 Exp *Binary::simplifyConstraint() {
     assert(subExp1 && subExp2);
 
-    subExp1 = subExp1->simplifyConstraint();
-    subExp2 = subExp2->simplifyConstraint();
+    replaceSubExp(subExp1, subExp1->simplifyConstraint());
+    replaceSubExp(subExp2, subExp2->simplifyConstraint());
     switch (op) {
     case opEquals: {
         if (subExp1->isTypeVal() && subExp2->isTypeVal()) {
@@ -4024,7 +4361,7 @@ Exp *Unary::accept(ExpModifier *v) {
     bool recur;
     Unary *ret = (Unary *)v->preVisit(this, recur);
     if (recur)
-        subExp1 = subExp1->accept(v);
+        replaceSubExp(subExp1, subExp1->accept(v));
     return v->postVisit(ret);
 }
 Exp *Binary::accept(ExpModifier *v) {
@@ -4033,9 +4370,9 @@ Exp *Binary::accept(ExpModifier *v) {
     bool recur;
     Exp *ret = v->preVisit(this, recur);
     if (recur)
-        subExp1 = subExp1->accept(v);
+        replaceSubExp(subExp1, subExp1->accept(v));
     if (recur)
-        subExp2 = subExp2->accept(v);
+        replaceSubExp(subExp2, subExp2->accept(v));
     Binary *bret = dynamic_cast<Binary *>(ret);
     Unary *uret = dynamic_cast<Unary *>(ret);
     if(bret)
@@ -4049,11 +4386,11 @@ Exp *Ternary::accept(ExpModifier *v) {
     bool recur;
     Ternary *ret = (Ternary *)v->preVisit(this, recur);
     if (recur)
-        subExp1 = subExp1->accept(v);
+        replaceSubExp(subExp1, subExp1->accept(v));
     if (recur)
-        subExp2 = subExp2->accept(v);
+        replaceSubExp(subExp2, subExp2->accept(v));
     if (recur)
-        subExp3 = subExp3->accept(v);
+        replaceSubExp(subExp3, subExp3->accept(v));
     return v->postVisit(ret);
 }
 
@@ -4063,7 +4400,7 @@ Exp *Location::accept(ExpModifier *v) {
     bool recur;
     Exp *ret = v->preVisit(this, recur);
     if (recur)
-        subExp1 = subExp1->accept(v);
+        replaceSubExp(subExp1, subExp1->accept(v));
     Location * loc_ret = dynamic_cast<Location *>(ret);
     if(loc_ret)
         return v->postVisit(loc_ret);
@@ -4078,7 +4415,7 @@ Exp *RefExp::accept(ExpModifier *v) {
     bool recur;
     RefExp *ret = (RefExp *)v->preVisit(this, recur);
     if (recur)
-        subExp1 = subExp1->accept(v);
+        replaceSubExp(subExp1, subExp1->accept(v));
     return v->postVisit(ret);
 }
 
@@ -4086,7 +4423,7 @@ Exp *FlagDef::accept(ExpModifier *v) {
     bool recur;
     FlagDef *ret = (FlagDef *)v->preVisit(this, recur);
     if (recur)
-        subExp1 = subExp1->accept(v);
+        replaceSubExp(subExp1, subExp1->accept(v));
     return v->postVisit(ret);
 }
 
@@ -4094,7 +4431,7 @@ Exp *TypedExp::accept(ExpModifier *v) {
     bool recur;
     TypedExp *ret = (TypedExp *)v->preVisit(this, recur);
     if (recur)
-        subExp1 = subExp1->accept(v);
+        replaceSubExp(subExp1, subExp1->accept(v));
     return v->postVisit(ret);
 }
 
@@ -12,6 +12,9 @@
   * \brief   Implementation of "managed" classes such as InstructionSet, which feature makeUnion etc
   ******************************************************************************/
 
+#include <algorithm>
+#include <bitset>
+#include <cassert>
 #include <sstream>
 #include <cstring>
 
@@ -389,6 +392,11 @@ void LocationSet::makeDiff(LocationSet &other) {
     }
 }
 
+//! True if every location in this set is in other
+bool LocationSet::isSubSetOf(const LocationSet &other) const {
+    return std::includes(other.lset.begin(), other.lset.end(), lset.begin(), lset.end(), lessExpStar());
+}
+
 bool LocationSet::operator==(const LocationSet &o) const {
     // We want to compare the locations, not the pointers
     if (size() != o.size())
@@ -796,3 +804,277 @@ void ConnectionGraph::dump() const {
     for (auto iter : *this)
         LOG_STREAM() << iter.first << " <-> " << iter.second << "\n";
 }
+
+//
+// InterferenceGraph methods
+//
+
+//! Return the number of name e, numbering it (and remembering e, not a copy, for forEachEdge) if it is new
+size_t InterferenceGraph::number(Exp *e) {
+    size_t n = Names.number(e);
+    if (n == Given.size()) {
+        Given.push_back(e);
+        Adj.emplace_back();
+        Rows.emplace_back();
+    }
+    return n;
+}
+
+void InterferenceGraph::add(size_t a, size_t b) {
+    if (Rows[a].exists(b))
+        return; // Don't add a second entry
+    Rows[a].insert(b);
+    Adj[a].push_back(b);
+}
+
+//! As ConnectionGraph::connect: if a is connected to c,d and e, b should also be connected to c,d and e
+void InterferenceGraph::connect(size_t a, size_t b) {
+    std::vector<size_t> a_connections = Adj[a];
+    std::vector<size_t> b_connections = Adj[b];
+    add(a, b);
+    for (size_t e : b_connections)
+        add(a, e);
+    add(b, a);
+    for (size_t e : a_connections)
+        add(e, b);
+}
+
+bool InterferenceGraph::isConnected(Exp *a, const Exp &b) const {
+    int na = Names.find(a);
+    int nb = Names.find(const_cast<Exp *>(&b));
+    return na != -1 && nb != -1 && isConnected(size_t(na), size_t(nb));
+}
+
+void InterferenceGraph::clear() {
+    Names.clear();
+    Given.clear();
+    Adj.clear();
+    Rows.clear();
+}
+
+//
+// BitSet methods
+//
+
+//! Make this set the union of itself and other; returns true if this set changed
+bool BitSet::makeUnion(const BitSet &other) {
+    if (Words.size() < other.Words.size())
+        Words.resize(other.Words.size());
+    uint64_t changed = 0;
+    for (size_t i = 0; i < other.Words.size(); i++) {
+        uint64_t w = Words[i] | other.Words[i];
+        changed |= w ^ Words[i];
+        Words[i] = w;
+    }
+    return changed != 0;
+}
+
+//! Make this set the difference of itself and other; returns true if this set changed
+bool BitSet::makeDiff(const BitSet &other) {
+    size_t n = std::min(Words.size(), other.Words.size());
+    uint64_t changed = 0;
+    for (size_t i = 0; i < n; i++) {
+        changed |= Words[i] & other.Words[i];
+        Words[i] &= ~other.Words[i];
+    }
+    return changed != 0;
+}
+
+//! Make this set the intersection of itself and other; returns true if this set changed
+bool BitSet::makeIsect(const BitSet &other) {
+    size_t n = std::min(Words.size(), other.Words.size());
+    uint64_t changed = 0;
+    for (size_t i = 0; i < n; i++) {
+        changed |= Words[i] & ~other.Words[i];
+        Words[i] &= other.Words[i];
+    }
+    for (size_t i = n; i < Words.size(); i++)
+        changed |= Words[i];
+    Words.resize(n);
+    return changed != 0;
+}
+
+//! True if every element of this set is in other
+bool BitSet::isSubSetOf(const BitSet &other) const {
+    size_t n = std::min(Words.size(), other.Words.size());
+    uint64_t extra = 0;
+    for (size_t i = 0; i < n; i++)
+        extra |= Words[i] & ~other.Words[i];
+    for (size_t i = n; i < Words.size(); i++)
+        extra |= Words[i];
+    return extra == 0;
+}
+
+size_t BitSet::size() const {
+    size_t res = 0;
+    for (uint64_t w : Words)
+        res += std::bitset<64>(w).count();
+    return res;
+}
+
+bool BitSet::empty() const {
+    for (uint64_t w : Words)
+        if (w)
+            return false;
+    return true;
+}
+
+//! Compare the elements; trailing zero words do not matter
+bool BitSet::operator==(const BitSet &other) const {
+    const std::vector<uint64_t> &shorter = Words.size() < other.Words.size() ? Words : other.Words;
+    const std::vector<uint64_t> &longer = Words.size() < other.Words.size() ? other.Words : Words;
+    if (!std::equal(shorter.begin(), shorter.end(), longer.begin()))
+        return false;
+    for (size_t i = shorter.size(); i < longer.size(); i++)
+        if (longer[i])
+            return false;
+    return true;
+}
+
+//! Set bits to the numbers of the statements in this set. Returns false (and bits is incomplete) if a statement has
+//! no number yet, e.g. an implicit assignment.
+bool InstructionSet::toBits(BitSet &bits) const {
+    bits.clear();
+    for (Instruction *s : *this) {
+        if (s->getNumber() <= 0)
+            return false;
+        bits.insert(s->getNumber());
+    }
+    return true;
+}
+
+//! Insert the statements numbered in bits, where byNumber[n] is the statement numbered n
+void InstructionSet::fromBits(const BitSet &bits, const std::vector<Instruction *> &byNumber) {
+    bits.forEach([&](size_t n) {
+        assert(n < byNumber.size() && byNumber[n]);
+        insert(byNumber[n]);
+    });
+}
+
+//
+// LocationNumbering methods
+//
+
+//! Return the number of loc, giving it the next number (and keeping a copy of loc) if it has none
+size_t LocationNumbering::number(Exp *loc) {
+    auto found = Numbers.find(loc);
+    if (found != Numbers.end())
+        return found->second;
+    Exp *copy = loc->clone();
+    Numbers[copy] = Locations.size();
+    Locations.push_back(copy);
+    return Locations.size() - 1;
+}
+
+int LocationNumbering::find(Exp *loc) const {
+    auto found = Numbers.find(loc);
+    return found != Numbers.end() ? int(found->second) : -1;
+}
+
+void LocationNumbering::clear() {
+    Numbers.clear();
+    for (Exp *e : Locations)
+        delete e;
+    Locations.clear();
+}
+
+//! Set bits to the numbers of the locations in ls, numbering any that are new
+void LocationNumbering::toBits(const LocationSet &ls, BitSet &bits) {
+    bits.clear();
+    for (Exp *loc : ls)
+        bits.insert(number(loc));
+}
+
+void LocationNumbering::toLocationSet(const BitSet &bits, LocationSet &ls) const {
+    bits.forEach([&](size_t n) { ls.insert(Locations[n]); });
+}
+
+//! Index every statement of proc, replacing what was there before
+void DefUseIndex::build(UserProc *proc) {
+    clear();
+    Valid = true;
+    StatementList stmts;
+    proc->getStatements(stmts);
+    for (Instruction *s : stmts)
+        addUses(s);
+}
+
+void DefUseIndex::clear() {
+    Users.clear();
+    Defs.clear();
+    Valid = false;
+}
+
+const std::vector<Instruction *> &DefUseIndex::getUsers(Instruction *def) const {
+    static const std::vector<Instruction *> none;
+    auto found = Users.find(def);
+    return found != Users.end() ? found->second : none;
+}
+
+const std::vector<Instruction *> &DefUseIndex::getDefs(Instruction *s) const {
+    static const std::vector<Instruction *> none;
+    auto found = Defs.find(s);
+    return found != Defs.end() ? found->second : none;
+}
+
+//! Remove one occurrence of x from v, not keeping the order
+static void eraseOne(std::vector<Instruction *> &v, Instruction *x) {
+    auto found = std::find(v.begin(), v.end(), x);
+    if (found != v.end()) {
+        *found = v.back();
+        v.pop_back();
+    }
+}
+
+void DefUseIndex::addUses(Instruction *s) {
+    if (!Valid)
+        return;
+    removeUses(s);
+    LocationSet locs;
+    s->addUsedLocs(locs, false); // Ignore uses in collectors, as countRefs does
+    std::vector<Instruction *> defs;
+    for (Exp *loc : locs) {
+        if (!loc->isSubscript())
+            continue;
+        Instruction *def = ((RefExp *)loc)->getDef();
+        if (def && std::find(defs.begin(), defs.end(), def) == defs.end())
+            defs.push_back(def);
+    }
+    if (defs.empty())
+        return;
+    for (Instruction *def : defs)
+        Users[def].push_back(s);
+    Defs[s] = std::move(defs);
+}
+
+void DefUseIndex::removeUses(Instruction *s) {
+    if (!Valid)
+        return;
+    auto found = Defs.find(s);
+    if (found == Defs.end())
+        return;
+    for (Instruction *def : found->second) {
+        auto uu = Users.find(def);
+        eraseOne(uu->second, s);
+        if (uu->second.empty())
+            Users.erase(uu);
+    }
+    Defs.erase(found);
+}
+
+void DefUseIndex::removeStatement(Instruction *s) {
+    if (!Valid)
+        return;
+    removeUses(s);
+    auto found = Users.find(s);
+    if (found == Users.end())
+        return;
+    // Statements still using s no longer use a definition that is in the proc
+    for (Instruction *user : found->second) {
+        auto dd = Defs.find(user);
+        eraseOne(dd->second, s);
+        if (dd->second.empty())
+            Defs.erase(dd);
+    }
+    Users.erase(found);
+}
@@ -81,6 +81,9 @@
 #include <sstream>
 #include <algorithm> // For find()
 #include <cstring>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
 
 #ifdef _WIN32
 #undef NO_ADDRESS
@@ -318,7 +321,7 @@ void UserProc::renameLocal(const char *oldName, const char *newName) {
     cfg->searchAndReplace(*oldLoc, newLoc);
 }
 
-bool UserProc::searchAll(const Exp &search, std::list<Exp *> &result) { return cfg->searchAll(search, result); }
+bool UserProc::searchAll(const Exp &search, ExpMatches &result) { return cfg->searchAll(search, result); }
 
 void Function::printCallGraphXML(QTextStream &os, int depth, bool /*recurse*/) {
     if (!DUMP_XML)
@@ -521,6 +524,8 @@ bool LibProc::isPreserved(Exp *e) { return signature->isPreserved(e); }
  * UserProc methods.
  *********************/
 
+void (*UserProc::procSimplifier)(UserProc *proc) = nullptr;
+
 UserProc::UserProc()
     : Function(), cfg(nullptr), status(PROC_UNDECODED),
       // decoded(false), analysed(false),
@@ -545,7 +550,10 @@ UserProc::UserProc(Module *mod, const QString &name, ADDRESS uNative)
     localTable.setProc(this);
 }
 
-UserProc::~UserProc() { deleteCFG(); }
+UserProc::~UserProc() {
+    deleteCFG();
+    delete decodedCfg;
+}
 
 /***************************************************************************/ /**
   *
@@ -874,7 +882,7 @@ void UserProc::printDFG() const {
 void UserProc::initStatements() {
     BB_IT it;
     BasicBlock::rtlit rit;
-    StatementList::iterator sit;
+    BasicBlock::stmtit sit;
     for (BasicBlock *bb = cfg->getFirstBB(it); bb; bb = cfg->getNextBB(it)) {
         for (Instruction *s = bb->getFirstStmt(rit, sit); s; s = bb->getNextStmt(rit, sit)) {
             s->setProc(this);
@@ -897,7 +905,7 @@ void UserProc::initStatements() {
 void UserProc::numberStatements() {
     BB_IT it;
     BasicBlock::rtlit rit;
-    StatementList::iterator sit;
+    BasicBlock::stmtit sit;
     for (BasicBlock *bb = cfg->getFirstBB(it); bb; bb = cfg->getNextBB(it)) {
         for (Instruction *s = bb->getFirstStmt(rit, sit); s; s = bb->getNextStmt(rit, sit))
             if (!s->isImplicit() &&  // Don't renumber implicits (remain number 0)
@@ -906,6 +914,19 @@ void UserProc::numberStatements() {
     }
 }
 
+/// Set byNumber[n] to the statement numbered n (see numberStatements), or nullptr if there is none. This is the
+/// inverse of InstructionSet::toBits.
+void UserProc::getStatementsByNumber(std::vector<Instruction *> &byNumber) const {
+    StatementList stmts;
+    getStatements(stmts);
+    byNumber.assign(stmtNumber + 1, nullptr);
+    for (Instruction *s : stmts) {
+        int n = s->getNumber();
+        if (n > 0 && n < (int)byNumber.size())
+            byNumber[n] = s;
+    }
+}
+
 // get all statements
 // Get to a statement list, so they come out in a reasonable and consistent order
 /// get all the statements
@@ -947,6 +968,7 @@ void UserProc::removeStatement(Instruction *stmt) {
                 LOG << "removing proven true exp " << it->first << " = " << it->second
                     << " that uses statement being removed.\n";
             provenTrue.erase(it++);
+            prog->getProofCache().invalidate(this);
             // it = provenTrue.begin();
             continue;
         }
@@ -967,8 +989,8 @@ void UserProc::removeStatement(Instruction *stmt) {
 }
 
 void UserProc::insertAssignAfter(Instruction *s, Exp *left, Exp *right) {
-    std::list<Instruction *>::iterator it;
-    std::list<Instruction *> *stmts;
+    RTL::iterator it;
+    RTL *stmts;
     if (s == nullptr) {
         // This means right is supposed to be a parameter. We can insert the assignment at the start of the entryBB
         BasicBlock *entryBB = cfg->getEntryBB();
@@ -1001,7 +1023,7 @@ void UserProc::insertStatementAfter(Instruction *s, Instruction *a) {
         if (rtls == nullptr)
             continue; // e.g. *bb is (as yet) invalid
         for (RTL *rr : *rtls) {
-            std::list<Instruction *>::iterator ss;
+            RTL::iterator ss;
             for (ss = rr->begin(); ss != rr->end(); ss++) {
                 if (*ss == s) {
                     ss++; // This is the point to insert before
@@ -1016,47 +1038,46 @@ void UserProc::insertStatementAfter(Instruction *s, Instruction *a) {
 
 /** Cycle detection logic:
  * *********************
- * cycleGrp is an initially null pointer to a set of procedures, representing the procedures involved in the current
- * recursion group, if any. These procedures have to be analysed together as a group, after individual pre-group
- * analysis.
- * child is a set of procedures, cleared at the top of decompile(), representing the cycles associated with the
- * current procedure and all of its children. If this is empty, the current procedure is not involved in recursion,
- * and can be decompiled up to and including removing unused statements.
+ * The recursion groups are the strongly connected components of the call graph, found by Tarjan's algorithm (see
+ * CallGraphSCCs; the search is Prog::getRecursionGroups()) as decompile() does its depth first search. A proc is open
+ * while it has been visited, but its group is not complete yet. These procedures have to be analysed together as a
+ * group, after individual pre-group analysis.
+ * child is the set of open procs in the subtree of the search below the current procedure, which is the part of the
+ * stack of Tarjan's algorithm above it. If it is empty and no call leads back to an open proc, the current procedure is
+ * not involved in recursion, and can be decompiled up to and including removing unused statements.
  * path is an initially empty list of procedures, representing the call path from the current entry point to the
  * current procedure, inclusive.
- * If (after all children have been processed: important!) the first element in path and also cycleGrp is the current
- * procedure, we have the maximal set of distinct cycles, so we can do the recursion group analysis and return an empty
- * set. At the end of the recursion group analysis, the whole group is complete, ready for the global analyses.
+ * If (after all children have been processed: important!) nothing below the current procedure reaches an open proc
+ * visited before it, it and the open procs below it are a complete strongly connected component. Each gets cycleGrp
+ * set to the group, the recursion group analysis is done, and the empty set is returned. At the end of the recursion
+ * group analysis, the whole group is complete, ready for the global analyses.
+ * If the recursion group analysis restarts the decompilation of a member (e.g. after analysing a switch), its cycleGrp
+ * is already set. Only the new callees are searched, and the member is analysed up to middleDecompile() again; the
+ * group analysis does the rest.
  cycleSet decompile(ProcList path)        // path initially empty
+        enter this proc in the search
         child = new ProcSet
         append this proc to path
         for each child c called by this proc
                 if c has already been visited but not finished
-                        // have new cycle
-                        if c is in path
-                          // this is a completely new cycle
-                          insert every proc from c to the end of path into child
-                        else
-                          // this is a new branch of an existing cycle
-                          child = c->cycleGrp
-                          find first element f of path that is in cycleGrp
-                          insert every proc after f to the end of path into child
-                        for each element e of child
-              insert e->cycleGrp into child
-                          e->cycleGrp = child
+                        // have new cycle if c is open
+                        reach c
                 else
                         // no new cycle
                         tmp = c->decompile(path)
                         child = union(child, tmp)
+                        return from c
                         set return statement in call to that of c
-        if (child empty)
+        leave this proc in the search
+        if (not involved in recursion)
                 earlyDecompile()
                 child = middleDecompile()
                 removeUnusedStatments()            // Not involved in recursion
         else
                 // Is involved in recursion
-                find first element f in path that is also in cycleGrp
-                if (f == this)          // The big test: have we got the complete strongly connected component?
+                insert this proc into child
+                if (leaving completed a component)  // The big test: have we got the complete strongly connected component?
+                        set cycleGrp of each proc in the component to it
                         recursionGroupAnalysis()        // Yes, we have
                         child = new ProcSet            // Don't add these processed cycles to the parent
         remove last element (= this) from path
@@ -1072,6 +1093,8 @@ void UserProc::insertStatementAfter(Instruction *s, Instruction *a) {
   *
   ******************************************************************************/
 std::shared_ptr<ProcSet> UserProc::decompile(ProcList *path, int &indent) {
+    ArenaScope arenaScope(getArena());
+    SimplifyStats::Scope simplifyScope(&simplifyStats);
     Boomerang::get()->alertConsidering(path->empty() ? nullptr : path->back(), this);
     alignStream(LOG_STREAM(),++indent) << (status >= PROC_VISITED ? "re" : "") << "considering "
               << getName() << "\n";
@@ -1086,8 +1109,16 @@ std::shared_ptr<ProcSet> UserProc::decompile(ProcList *path, int &indent) {
         // Can happen e.g. if a callee is visible only after analysing a switch statement
         prog->reDecode(this); // Actually decoding for the first time, not REdecoding
 
-    if (status < PROC_VISITED)
+    if (status < PROC_VISITED) {
+        saveDecodedCfg();
         setStatus(PROC_VISITED); // We have at least visited this proc "on the way down"
+    }
+    // A restart by the analysis of this proc's recursion group is not part of the search for recursion groups
+    bool groupRestart = cycleGrp != nullptr;
+    CallGraphSCCs &groups = prog->getRecursionGroups();
+    if (!groupRestart)
+        groups.enter(this);
+    bool inCycle = false;
     std::shared_ptr<ProcSet> child = std::make_shared<ProcSet>();
     path->push_back(this); // Append this proc to path
 
@@ -1120,51 +1151,14 @@ std::shared_ptr<ProcSet> UserProc::decompile(ProcList *path, int &indent) {
             }
             // if c has already been visited but not done (apart from global analyses, i.e. we have a new cycle)
             if (c->status >= PROC_VISITED && c->status <= PROC_EARLYDONE) {
-                // if c is in path
-                ProcList::iterator pi;
-                bool inPath = false;
-                for (pi = path->begin(); pi != path->end(); ++pi) {
-                    if (*pi == c) {
-                        inPath = true;
-                        break;
-                    }
-                }
-                if (inPath) {
-                    // This is a completely new cycle
-                    // Insert every proc from c to the end of path into child
-                    do {
-                        child->insert(*pi);
-                        ++pi;
-                    } while (pi != path->end());
-                } else {
-                    // This is new branch of an existing cycle
-                    child = c->cycleGrp;
-                    // Find first element f of path that is in c->cycleGrp
-                    ProcList::iterator pi;
-                    Function *f = nullptr;
-                    for (pi = path->begin(); pi != path->end(); ++pi) {
-                        if (c->cycleGrp->find(*pi) != c->cycleGrp->end()) {
-                            f = *pi;
-                            break;
-                        }
-                    }
-                    assert(f);
-                    // Insert every proc after f to the end of path into child
-                    // There must be at least one element in the list (this proc), so the ++pi should be safe
-                    while (++pi != path->end()) {
-                        child->insert(*pi);
-                    }
-                }
-                // point cycleGrp for each element of child to child, unioning in each element's cycleGrp
-                ProcSet entries;
-                for (auto cc : *child) {
-                    if (cc->cycleGrp)
-                        entries.insert(cc->cycleGrp->begin(), cc->cycleGrp->end());
-                }
-                child->insert(entries.begin(),entries.end());
-                for (UserProc * proc : *child) {
-                    proc->cycleGrp = child;
+                if (groupRestart || !groups.isOpen(c)) {
+                    // c is in a complete recursion group, whose analysis restarted the decompilation of this proc
+                    // (e.g. after analysing a switch). That is not a new cycle
+                    continue;
                 }
+                // c is open, so it is in the recursion group of this proc, or of one of its ancestors in path
+                groups.reach(this, c);
+                inCycle = true;
                 setStatus(PROC_INCYCLE);
             } else {
                 // No new cycle
@@ -1175,58 +1169,70 @@ std::shared_ptr<ProcSet> UserProc::decompile(ProcList *path, int &indent) {
                 child->insert(tmp->begin(), tmp->end());
                 // Child has at least done middleDecompile(), possibly more
                 call->setCalleeReturn(c->getTheReturnStatement());
-                if (!tmp->empty()) {
+                if (!groupRestart)
+                    groups.returnFrom(this, c);
+                if (!tmp->empty() && !groupRestart) {
+                    inCycle = true;
                     setStatus(PROC_INCYCLE);
                 }
             }
         }
     }
 
-    // if child is empty, i.e. no child involved in recursion
-    if (child->empty()) {
+    if (groupRestart) {
+        // Redo what the recursion group analysis had done for this proc; it does the rest
+        LOG_VERBOSE(1) << "restarted " << getName() << " during its recursion group analysis\n";
+        setStatus(PROC_INCYCLE); // So the calls in the group are treated as childless
+        Boomerang::get()->alertDecompiling(this);
+        initialiseDecompile();
+        earlyDecompile();
+        middleDecompile(path, indent);
+        assert(!path->empty() && path->back() == this);
+        path->pop_back();
+        --indent;
+        LOG_VERBOSE(1) << "end decompile(" << getName() << ")\n";
+        return std::make_shared<ProcSet>(*cycleGrp); // Still involved in recursion
+    }
+    // Finds out if this proc completes a recursion group. If it is not involved in recursion, it is a group by itself
+    int group = groups.leave(this);
+
+    // if not involved in recursion
+    if (!inCycle) {
         Boomerang::get()->alertDecompiling(this);
         alignStream(LOG_STREAM(1),indent) << "decompiling " << getName() << "\n";
         initialiseDecompile(); // Sort the CFG, number statements, etc
         earlyDecompile();
+        // If there is a switch statement, middleDecompile restarts the decompilation of this proc, which could
+        // find cycles through the new callees. If so, the restarted decompile() has done the recursion logic
         child = middleDecompile(path, indent);
-        // If there is a switch statement, middleDecompile could contribute some cycles. If so, we need to test for
-        // the recursion logic again
-        if (!child->empty())
-            // We've just come back out of decompile(), so we've lost the current proc from the path.
-            path->push_back(this);
-    }
-    if (child->empty()) {
-        remUnusedStmtEtc(); // Do the whole works
-        setStatus(PROC_FINAL);
-        Boomerang::get()->alertEndDecompile(this);
+    }
+    if (!inCycle) {
+        // Unless the restarted decompile() left this proc in the open recursion group of an ancestor
+        if (child->empty()) {
+            remUnusedStmtEtc(); // Do the whole works
+            setStatus(PROC_FINAL);
+            Boomerang::get()->alertEndDecompile(this);
+        }
     } else {
         // this proc's children, and hence this proc, is/are involved in recursion
-        // find first element f in path that is also in cycleGrp
-        ProcList::iterator f;
-        for (f = path->begin(); f != path->end(); ++f)
-            if (cycleGrp->find(*f) != cycleGrp->end())
-                break;
-        // The big test: have we found all the strongly connected components (in the call graph)?
-        if (*f == this) {
+        child->insert(this);
+        // The big test: have we found all the strongly connected component (in the call graph)?
+        if (group >= 0) {
             // Yes, process these procs as a group
+            const std::vector<UserProc *> &members = groups.getComponent(group);
+            child = std::make_shared<ProcSet>(members.begin(), members.end());
+            for (UserProc *proc : members)
+                proc->cycleGrp = child;
             recursionGroupAnalysis(path, indent); // Includes remUnusedStmtEtc on all procs in cycleGrp
             setStatus(PROC_FINAL);
             Boomerang::get()->alertEndDecompile(this);
-            child->clear(); //delete child;
             child = std::make_shared<ProcSet>();
         }
     }
 
     // Remove last element (= this) from path
-    // The if should not be neccesary, but nestedswitch needs it
-    if (!path->empty()) {
-        assert(std::find(path->begin(),path->end(),this)!=path->end());
-        if(path->back()!=this)
-            qDebug() << "Last UserProc in UserProc::decompile/path is not this!";
-        path->remove(this);
-    }
-    else
-        LOG << "WARNING: UserProc::decompile: empty path when trying to remove last proc\n";
+    assert(!path->empty() && path->back() == this);
+    path->pop_back();
 
     --indent;
     LOG_VERBOSE(1) << "end decompile(" << getName() << ")\n";
@@ -1563,17 +1569,24 @@ std::shared_ptr<ProcSet> UserProc::middleDecompile(ProcList *path, int indent) {
         // First copy any new indirect jumps or calls that were decoded this time around. Just copy them all, the map
         // will prevent duplicates
         processDecodedICTs();
-        // Now, decode from scratch
+        // Now, decode only the new targets if possible, else decode from scratch
         theReturnStatement = nullptr;
-        cfg->clear();
-        prog->reDecode(this);
+        if (!reDecodeIncrementally()) {
+            theReturnStatement = nullptr; // May have been set to the return in the restored copy
+            cfg->clear();
+            prog->reDecode(this);
+        }
+        saveDecodedCfg();
         df.setRenameLocalsParams(false);        // Start again with memofs
         setStatus(PROC_VISITED);                // Back to only visited progress
-        path->erase(--path->end());             // Remove self from path
+        bool onPath = !path->empty() && path->back() == this;
+        if (onPath)
+            path->pop_back();                   // Remove self from path
         --indent;                               // Because this is not recursion
         std::shared_ptr<ProcSet> ret = decompile(path, indent); // Restart decompiling this proc
         ++indent;                               // Restore indent
-        path->push_back(this);                  // Restore self to path
+        if (onPath)
+            path->push_back(this);              // Restore self to path
         // It is important to keep the result of this call for the recursion analysis
         return ret;
     }
@@ -1649,11 +1662,12 @@ void UserProc::remUnusedStmtEtc() {
     // Only remove unused statements after decompiling as much as possible of the proc
     // Remove unused statements
     RefCounter refCounts; // The map
+    DefUseIndex defUses;  // The users of each definition, for this pass only
     // Count the references first
-    countRefs(refCounts);
+    countRefs(refCounts, defUses);
     // Now remove any that have no used
     if (!Boomerang::get()->noRemoveNull)
-        remUnusedStmtEtc(refCounts);
+        remUnusedStmtEtc(refCounts, defUses);
 
     // Remove null statements
     if (!Boomerang::get()->noRemoveNull)
@@ -1693,78 +1707,74 @@ void UserProc::remUnusedStmtEtc() {
     Boomerang::get()->alertDecompileDebugPoint(this, "after final");
 }
 
-void UserProc::remUnusedStmtEtc(RefCounter &refCounts) {
+//! Remove the statements with no references in \a refCounts, and those only used by them. \a defUses is the index
+//! countRefs() built the counts from; it is kept up to date here, and cleared once the refs change.
+void UserProc::remUnusedStmtEtc(RefCounter &refCounts, DefUseIndex &defUses) {
 
     Boomerang::get()->alertDecompileDebugPoint(this, "before remUnusedStmtEtc");
 
+    if (!defUses.isValid())
+        defUses.build(this);
+    // Start with the statements that nothing uses. Removing one decrements the counts of the definitions it uses, and
+    // any of those that reach zero become candidates in turn, so each statement is looked at a bounded number of times
+    std::deque<Instruction *> work;
     StatementList stmts;
     getStatements(stmts);
-    bool change;
-    do { // FIXME: check if this is ever needed
-        change = false;
-        StatementList::iterator ll = stmts.begin();
-        while (ll != stmts.end()) {
-            Instruction *s = *ll;
-            if (!s->isAssignment()) {
-                // Never delete a statement other than an assignment (e.g. nothing "uses" a Jcond)
-                ll++;
-                continue;
-            }
-            Assignment *as = (Assignment *)s;
-            Exp *asLeft = as->getLeft();
-            // If depth < 0, consider all depths
-            // if (asLeft && depth >= 0 && asLeft->getMemDepth() > depth) {
-            //    ll++;
-            //    continue;
-            //}
-            if (asLeft && asLeft->getOper() == opGlobal) {
-                // assignments to globals must always be kept
-                ll++;
-                continue;
-            }
-            // If it's a memof and renameable it can still be deleted
-            if (asLeft->getOper() == opMemOf && !canRename(asLeft)) {
-                // Assignments to memof-anything-but-local must always be kept.
-                ll++;
-                continue;
-            }
-            if (asLeft->getOper() == opMemberAccess || asLeft->getOper() == opArrayIndex) {
-                // can't say with these; conservatively never remove them
-                ll++;
+    for (Instruction *s : stmts) {
+        RefCounter::iterator rr = refCounts.find(s);
+        if (rr == refCounts.end() || rr->second == 0)
+            work.push_back(s);
+    }
+    std::unordered_set<Instruction *> removed;
+    while (!work.empty()) {
+        Instruction *s = work.front();
+        work.pop_front();
+        if (removed.count(s))
+            continue;
+        RefCounter::iterator rr = refCounts.find(s);
+        if (rr != refCounts.end() && rr->second != 0)
+            continue; // Only looked at while its count was zero; it may have gone negative since (see below)
+        if (!s->isAssignment()) {
+            // Never delete a statement other than an assignment (e.g. nothing "uses" a Jcond)
+            continue;
+        }
+        Assignment *as = (Assignment *)s;
+        Exp *asLeft = as->getLeft();
+        if (asLeft && asLeft->getOper() == opGlobal) {
+            // assignments to globals must always be kept
+            continue;
+        }
+        // If it's a memof and renameable it can still be deleted
+        if (asLeft->getOper() == opMemOf && !canRename(asLeft)) {
+            // Assignments to memof-anything-but-local must always be kept.
+            continue;
+        }
+        if (asLeft->getOper() == opMemberAccess || asLeft->getOper() == opArrayIndex) {
+            // can't say with these; conservatively never remove them
+            continue;
+        }
+        // Adjust the counts, due to statements only referenced by statements that are themselves unused. The index
+        // holds each definition used by s once, as refCounts is a count of the number of statements that use a
+        // definition, not the total number of refs.
+        // Note that this decrements for the uses in an implicit statement too, although countRefs did not count them.
+        // This can leave a count at -1, which keeps that definition; it is what the pass has always done
+        for (Instruction *def : defUses.getDefs(s)) {
+            if (def == s)
                 continue;
-            }
-            if (refCounts.find(s) == refCounts.end() || refCounts[s] == 0) { // Care not to insert unnecessarily
-                // First adjust the counts, due to statements only referenced by statements that are themselves unused.
-                // Need to be careful not to count two refs to the same def as two; refCounts is a count of the number
-                // of statements that use a definition, not the total number of refs
-                InstructionSet stmtsRefdByUnused;
-                LocationSet components;
-                s->addUsedLocs(components, false); // Second parameter false to ignore uses in collectors
-                LocationSet::iterator cc;
-                for (cc = components.begin(); cc != components.end(); cc++) {
-                    if ((*cc)->isSubscript()) {
-                        stmtsRefdByUnused.insert(((RefExp *)*cc)->getDef());
-                    }
-                }
-                InstructionSet::iterator dd;
-                for (dd = stmtsRefdByUnused.begin(); dd != stmtsRefdByUnused.end(); dd++) {
-                    if (*dd == nullptr)
-                        continue;
-                    if (DEBUG_UNUSED)
-                        LOG << "decrementing ref count of " << (*dd)->getNumber() << " because " << s->getNumber()
-                            << " is unused\n";
-                    refCounts[*dd]--;
-                }
-                if (DEBUG_UNUSED)
-                    LOG << "removing unused statement " << s->getNumber() << " " << s << "\n";
-                removeStatement(s);
-                ll = stmts.erase(ll); // So we don't try to re-remove it
-                change = true;
-                continue; // Don't call getNext this time
-            }
-            ll++;
+            if (DEBUG_UNUSED)
+                LOG << "decrementing ref count of " << def->getNumber() << " because " << s->getNumber()
+                    << " is unused\n";
+            if (--refCounts[def] == 0)
+                work.push_back(def);
         }
-    } while (change);
+        if (DEBUG_UNUSED)
+            LOG << "removing unused statement " << s->getNumber() << " " << s << "\n";
+        removeStatement(s);
+        defUses.removeStatement(s);
+        removed.insert(s);
+    }
+    // The renaming below changes the refs, and does not keep the index up to date
+    defUses.clear();
     // Recaluclate at least the livenesses. Example: first call to printf in test/pentium/fromssa2, eax used only in a
     // removed statement, so liveness in the call needs to be removed
     removeCallLiveness();  // Kill all existing livenesses
@@ -1986,6 +1996,7 @@ bool UserProc::doRenameBlockVars(int pass, bool clearStacks) {
   ******************************************************************************/
 void UserProc::findSpPreservation() {
     LOG_VERBOSE(1) << "finding stack pointer preservation for " << getName() << "\n";
+    prog->getProofCache().invalidate(this); // The statements have changed since the last proofs
 
     bool stdsp = false; // FIXME: are these really used?
     // Note: need this non-virtual version most of the time, since nothing proved yet
@@ -2022,6 +2033,7 @@ void UserProc::findPreserveds() {
     LOG_VERBOSE(1) << "finding preserveds for " << getName() << "\n";
 
     Boomerang::get()->alertDecompileDebugPoint(this, "before finding preserveds");
+    prog->getProofCache().invalidate(this); // The statements have changed since the last proofs
 
     if (theReturnStatement == nullptr) {
         if (DEBUG_PROOF)
@@ -2432,6 +2444,7 @@ void UserProc::trimParameters(int depth) {
 void UserProc::removeReturn(Exp *e) {
     if (theReturnStatement)
         theReturnStatement->removeReturn(e);
+    prog->getProofCache().invalidate(this); // What the callers can prove through calls to this may have changed
 }
 
 void Function::removeParameter(Exp *e) {
@@ -2460,13 +2473,15 @@ void UserProc::processFloatConstants() {
     StatementList stmts;
     getStatements(stmts);
 
-    static Ternary match(opFsize, Terminal::get(opWild), Terminal::get(opWild), Location::memOf(Terminal::get(opWild)));
+    static Ternary &match = *onHeap([] {
+        return new Ternary(opFsize, Terminal::get(opWild), Terminal::get(opWild), Location::memOf(Terminal::get(opWild)));
+    });
 
     StatementList::iterator it;
     for (it = stmts.begin(); it != stmts.end(); it++) {
         Instruction *s = *it;
 
-        std::list<Exp *> results;
+        ExpMatches results;
         s->searchAll(match, results);
         for (auto &result : results) {
             Ternary *fsize = (Ternary *)result;
@@ -2588,9 +2603,9 @@ Exp *UserProc::getSymbolExp(Exp *le, SharedType ty, bool lastPass) {
 
 // Not used with DFA Type Analysis; the equivalent thing happens in mapLocalsAndParams() now
 void UserProc::mapExpressionsToLocals(bool lastPass) {
-    static Exp *sp_location = Location::regOf(0);
+    static Exp *sp_location = onHeap([] { return Location::regOf(0); });
     // parse("[*] + sp{0}")
-    static Binary nn(opPlus, Terminal::get(opWild), RefExp::get(sp_location, nullptr));
+    static Binary &nn = *onHeap([] { return new Binary(opPlus, Terminal::get(opWild), RefExp::get(sp_location, nullptr)); });
     StatementList stmts;
     getStatements(stmts);
 
@@ -2654,7 +2669,7 @@ void UserProc::mapExpressionsToLocals(bool lastPass) {
     static_cast<Const *>(sp_location->getSubExp1())->setInt(sp); // set to search sp value
     for (it = stmts.begin(); it != stmts.end(); it++) {
         Instruction *s = *it;
-        std::list<Exp *> results;
+        ExpMatches results;
         s->searchAll(nn, results);
         for (auto &result : results) {
             Exp *wild = (result)->getSubExp1();
@@ -2668,13 +2683,15 @@ void UserProc::mapExpressionsToLocals(bool lastPass) {
     // l = m[(sp{0} + WILD1) - K2]
     static Const sp_const(0);
     static Location sp_loc(opRegOf, &sp_const, nullptr);
-    static Location query_f(
-        opMemOf, Binary::get(opMinus, Binary::get(opPlus, RefExp::get(&sp_loc, nullptr), Terminal::get(opWild)),
-                             Terminal::get(opWildIntConst)),
-        nullptr);
+    static Location &query_f = *onHeap([] {
+        return new Location(
+            opMemOf, Binary::get(opMinus, Binary::get(opPlus, RefExp::get(&sp_loc, nullptr), Terminal::get(opWild)),
+                                 Terminal::get(opWildIntConst)),
+            nullptr);
+    });
     for (it = stmts.begin(); it != stmts.end(); it++) {
         Instruction *s = *it;
-        std::list<Exp *> results;
+        ExpMatches results;
         sp_const.setInt(sp);
         s->searchAll(query_f, results);
         for (Exp *result : results) {
@@ -2730,7 +2747,7 @@ void UserProc::searchRegularLocals(OPER minusOrPlus, bool lastPass, int sp, Stat
     StatementList::iterator it;
     for (it = stmts.begin(); it != stmts.end(); it++) {
         Instruction *s = *it;
-        std::list<Exp *> results;
+        ExpMatches results;
         s->searchAll(*l, results);
         for (auto result : results) {
 
@@ -2767,6 +2784,41 @@ bool UserProc::removeNullStatements() {
     return change;
 }
 
+namespace {
+//! The users of each assignment, each user once, in the order they were found
+struct AssignUsers {
+    std::unordered_map<Instruction *, std::vector<Instruction *>> users;
+    std::unordered_map<Instruction *, std::unordered_set<Instruction *>> noted; //!< The defs each user is noted for
+
+    void build(const StatementList &stmts) {
+        for (Instruction *s : stmts)
+            add(s);
+    }
+    //! Note s as a user of each assignment whose definition it uses (including in its collectors)
+    void add(Instruction *s) {
+        LocationSet exps;
+        s->addUsedLocs(exps, true);
+        std::unordered_set<Instruction *> &defs = noted[s];
+        for (Exp *e : exps) {
+            if (!e->isSubscript())
+                continue;
+            Instruction *def = ((RefExp *)e)->getDef();
+            if (def == nullptr || def == s || !def->isAssign())
+                continue;
+            if (defs.insert(def).second)
+                users[def].push_back(s);
+        }
+    }
+};
+} // namespace
+
+//! Add the number of times each definition would be propagated into s to destCounts
+static void countDests(Instruction *s, std::map<Exp *, int, lessExpStar> &destCounts) {
+    ExpDestCounter edc(destCounts);
+    StmtDestCounter sdc(&edc);
+    s->accept(&sdc);
+}
+
 // Propagate statements, but don't remove
 // Return true if change; set convert if an indirect call is converted to direct (else clear)
 /// Propagate statemtents; return true if change; set convert if an indirect call is converted to direct
@@ -2780,14 +2832,15 @@ bool UserProc::propagateStatements(bool &convert, int pass) {
     // Find the locations that are used by a live, dominating phi-function
     LocationSet usedByDomPhi;
     findLiveAtDomPhi(usedByDomPhi);
-    // Next pass: count the number of times each assignment LHS would be propagated somewhere
+    // Next pass: count the number of times each assignment LHS would be propagated somewhere. Each statement's own
+    // counts are kept, so that when propagation changes it, only that statement is recounted
     std::map<Exp *, int, lessExpStar> destCounts;
-    // Also maintain a set of locations which are used by phi statements
+    std::unordered_map<Instruction *, std::map<Exp *, int, lessExpStar>> stmtCounts;
     for (it = stmts.begin(); it != stmts.end(); it++) {
-        Instruction *s = *it;
-        ExpDestCounter edc(destCounts);
-        StmtDestCounter sdc(&edc);
-        s->accept(&sdc);
+        std::map<Exp *, int, lessExpStar> &counts = stmtCounts[*it];
+        countDests(*it, counts);
+        for (auto &cc : counts)
+            destCounts[cc.first] += cc.second;
     }
 #if USE_DOMINANCE_NUMS
     // A third pass for dominance numbers
@@ -2801,13 +2854,57 @@ bool UserProc::propagateStatements(bool &convert, int pass) {
             continue;
         change |= s->propagateFlagsTo();
     }
-    // Finally the actual propagation
-    convert = false;
+    // Finally the actual propagation, driven by a worklist. When propagation changes an assignment, the statements
+    // using it are tried again, since what they may propagate from it (and whether they may) has changed; so one call
+    // reaches the fixed point that used to need repeated calls, with work after the first sweep only for changes.
+    // This terminates: apart from a statement using itself (e.g. an assignment to %pc), which is not requeued, the
+    // uses of the non-phi assignments form no cycles, as each such definition dominates its uses, and propagating
+    // keeps that so. The users are only found once something changes, so the calls that change nothing (as the
+    // callers' repeated calls end with) cost one sweep. They are not kept from call to call: renaming between calls
+    // changes the definitions that the refs point to
+    AssignUsers users;
+    bool haveUsers = false;
+    std::deque<Instruction *> work;
+    std::unordered_set<Instruction *> queued;
     for (it = stmts.begin(); it != stmts.end(); it++) {
         Instruction *s = *it;
-        if (s->isPhi())
+        if (!s->isPhi()) {
+            work.push_back(s);
+            queued.insert(s);
+        }
+    }
+    convert = false;
+    while (!work.empty()) {
+        Instruction *s = work.front();
+        work.pop_front();
+        queued.erase(s);
+        if (!s->propagateTo(convert, &destCounts, &usedByDomPhi))
+            continue;
+        change = true;
+        // Keep destCounts up to date, as recounting before each call used to
+        std::map<Exp *, int, lessExpStar> &counts = stmtCounts[s];
+        for (auto &cc : counts)
+            destCounts[cc.first] -= cc.second;
+        counts.clear();
+        countDests(s, counts);
+        for (auto &cc : counts)
+            destCounts[cc.first] += cc.second;
+        if (!haveUsers) {
+            users.build(stmts); // Includes the new uses of s
+            haveUsers = true;
+        } else
+            users.add(s); // It has new uses, from what was propagated into it
+        if (!s->isAssign())
+            continue;
+        auto uu = users.users.find(s);
+        if (uu == users.users.end())
             continue;
-        change |= s->propagateTo(convert, &destCounts, &usedByDomPhi);
+        for (Instruction *u : uu->second) {
+            if (u == s || u->isPhi() || queued.count(u))
+                continue;
+            queued.insert(u);
+            work.push_back(u);
+        }
     }
     simplify();
     propagateToCollector();
@@ -2829,6 +2926,14 @@ Instruction *UserProc::getStmtAtLex(unsigned int begin, unsigned int end) {
         }
     return loweststmt;
 }
+
+/// Simplify the whole procedure, with procSimplifier if one is set, then statement by statement
+void UserProc::simplify() {
+    if (procSimplifier)
+        procSimplifier(this);
+    cfg->simplify();
+}
+
 /// promote the signature if possible
 void UserProc::promoteSignature() { signature = signature->promote(this); }
 
@@ -2984,36 +3089,24 @@ QString UserProc::getSymbolName(Exp *e) {
     return ((Const *)loc->getSubExp1())->getStr();
 }
 
-// Count references to the things that are under SSA control. For each SSA subscripting, increment a counter for that
-// definition
-void UserProc::countRefs(RefCounter &refCounts) {
+// Count references to the things that are under SSA control: for each definition, the number of statements that use it.
+// The counts are read off the def-use index, which is (re)built into \a defUses for remUnusedStmtEtc to go on with
+void UserProc::countRefs(RefCounter &refCounts, DefUseIndex &defUses) {
+    defUses.build(this);
     StatementList stmts;
     getStatements(stmts);
-    StatementList::iterator it;
-    for (it = stmts.begin(); it != stmts.end(); it++) {
-        Instruction *s = *it;
-        // Don't count uses in implicit statements. There is no RHS of course, but you can still have x from m[x] on the
-        // LHS and so on, and these are not real uses
-        if (s->isImplicit())
-            continue;
-        if (DEBUG_UNUSED)
-            LOG << "counting references in " << s << "\n";
-        LocationSet refs;
-        s->addUsedLocs(refs, false); // Ignore uses in collectors
-        LocationSet::iterator rr;
-        for (rr = refs.begin(); rr != refs.end(); rr++) {
-            if (((Exp *)*rr)->isSubscript()) {
-                Instruction *def = ((RefExp *)*rr)->getDef();
-                // Used to not count implicit refs here (def->getNumber() == 0), meaning that implicit definitions get
-                // removed as dead code! But these are the ideal place to read off final parameters, and it is
-                // guaranteed now that implicit statements are sorted out for us by now (for dfa type analysis)
-                if (def /* && def->getNumber() */) {
-                    refCounts[def]++;
-                    if (DEBUG_UNUSED)
-                        LOG << "counted ref to " << *rr << "\n";
-                }
-            }
+    for (Instruction *def : stmts) {
+        // Implicit definitions are counted: they are the ideal place to read off final parameters, and it is
+        // guaranteed now that implicit statements are sorted out for us by now (for dfa type analysis)
+        int count = 0;
+        for (Instruction *user : defUses.getUsers(def)) {
+            // Don't count uses in implicit statements. There is no RHS of course, but you can still have x from m[x]
+            // on the LHS and so on, and these are not real uses
+            if (!user->isImplicit())
+                count++;
         }
+        if (count)
+            refCounts[def] = count;
     }
     if (DEBUG_UNUSED) {
         RefCounter::iterator rr;
@@ -3158,7 +3251,11 @@ void UserProc::fromSSAform() {
     typedef std::map<Exp *, FirstTypeEnt, lessExpStar> FirstTypesMap;
     FirstTypesMap firstTypes;
     FirstTypesMap::iterator ff;
-    ConnectionGraph ig; // The interference graph; these can't have the same local variable
+    // The interference graph; these can't have the same local variable. It is found with bit vectors, unless the
+    // older LocationSet and multimap version was asked for (-lm); they find the same interferences
+    bool mapLiveness = Boomerang::get()->mapLiveness;
+    ConnectionGraph igMap;
+    InterferenceGraph igBits;
     ConnectionGraph pu; // The Phi Unites: these need the same local variable or copies
 #if 0
     // Start with the parameters. There is not always a use of every parameter, yet that location may be used with
@@ -3204,13 +3301,24 @@ void UserProc::fromSSAform() {
                         << " is not compatible with first type " << ff->second.first << ".\n";
                 // There already is a type for base, and it is different to the type for this definition.
                 // Record an "interference" so it will get a new variable
-                if (!ty->isVoid()) // just ignore void interferences ??!!
-                    ig.connect(ref, ff->second.second);
+                if (!ty->isVoid()) { // just ignore void interferences ??!!
+                    if (mapLiveness)
+                        igMap.connect(ref, ff->second.second);
+                    else
+                        igBits.connect(ref, ff->second.second);
+                }
             }
         }
     }
     // Find the interferences generated by more than one version of a variable being live at the same program point
-    cfg->findInterferences(ig);
+    std::vector<std::pair<Exp *, Exp *>> ig; // Each interfering pair, in the order of a ConnectionGraph
+    if (mapLiveness) {
+        cfg->findInterferences(igMap);
+        ig.assign(igMap.begin(), igMap.end());
+    } else {
+        cfg->findInterferences(igBits);
+        igBits.forEachEdge([&ig](Exp *a, Exp *b) { ig.emplace_back(a, b); });
+    }
 
     // Find the set of locations that are "united" by phi-functions
     // FIXME: are these going to be trivially predictable?
@@ -3219,8 +3327,8 @@ void UserProc::fromSSAform() {
     ConnectionGraph::iterator ii;
     if (DEBUG_LIVENESS) {
         LOG << "## ig interference graph:\n";
-        for (ii = ig.begin(); ii != ig.end(); ii++)
-            LOG << "   ig " << ii->first << " -> " << ii->second << "\n";
+        for (const auto &edge : ig)
+            LOG << "   ig " << edge.first << " -> " << edge.second << "\n";
         LOG << "## pu phi unites graph:\n";
         for (ii = pu.begin(); ii != pu.end(); ii++)
             LOG << "   pu " << ii->first << " -> " << ii->second << "\n";
@@ -3229,10 +3337,10 @@ void UserProc::fromSSAform() {
 
     // Choose one of each interfering location to give a new name to
 
-    for (ii = ig.begin(); ii != ig.end(); ++ii) {
+    for (const auto &edge : ig) {
         RefExp *r1, *r2;
-        r1 = (RefExp *)ii->first;
-        r2 = (RefExp *)ii->second; // r1 -> r2 and vice versa
+        r1 = (RefExp *)edge.first;
+        r2 = (RefExp *)edge.second; // r1 -> r2 and vice versa
         QString name1 = lookupSymFromRefAny(*r1);
         QString name2 = lookupSymFromRefAny(*r2);
         if (!name1.isNull() && !name2.isNull() && name1!=name2)
@@ -3278,7 +3386,8 @@ void UserProc::fromSSAform() {
         RefExp *r2 = (RefExp *)ii->second;
         QString name1 = lookupSymFromRef(*r1);
         QString name2 = lookupSymFromRef(*r2);
-        if (!name1.isNull() && !name2.isNull() && !ig.isConnected(r1, *r2)) {
+        bool interfere = mapLiveness ? igMap.isConnected(r1, *r2) : igBits.isConnected(r1, *r2);
+        if (!name1.isNull() && !name2.isNull() && !interfere) {
             // There is a case where this is unhelpful, and it happen in test/pentium/fromssa2. We have renamed the
             // destination of the phi to ebx_1, and that leaves the two phi operands as ebx. However, we attempt to
             // unite them here, which will cause one of the operands to become ebx_1, so the neat oprimisation of
@@ -3494,6 +3603,39 @@ bool UserProc::prove(Binary *query, bool conditional /* = false */) {
     if (Boomerang::get()->noProve)
         return false;
 
+    proofStats.Queries++;
+    ProofCache &proofs = prog->getProofCache();
+    bool outermost = !proofs.isActive();
+    ProofCache::Query scope(proofs, this, Boomerang::get()->proofBudget);
+    // Look the query up with both sides simplified (so sp = sp + 0 is sp = sp), under the premises assumed so far
+    UniqExp key(Binary::get(opEquals, queryLeft->clone()->simplify(), queryRight->clone()->simplify()));
+    std::vector<ProofCache::Premise> premises;
+    if (cycleGrp) {
+        for (UserProc *p : *cycleGrp)
+            for (auto &pp : p->recurPremises)
+                premises.push_back(ProofCache::Premise{p, pp.first, pp.second});
+    }
+    bool result;
+    if (proofs.find(this, key.get(), conditional, premises, result)) {
+        proofStats.CacheHits++;
+        if (DEBUG_PROOF)
+            LOG << "found " << (result ? "true" : "false") << " in proof cache " << query << " in " << getName()
+                << "\n";
+        return result;
+    }
+
+    result = proveUncached(query, conditional);
+    if (outermost && proofs.isExhausted()) {
+        proofStats.Exhausted++;
+        LOG_VERBOSE(1) << "gave up proving " << key.get() << " in " << getName() << " after "
+                       << Boomerang::get()->proofBudget << " steps\n";
+    }
+    proofs.insert(this, key.get(), conditional, premises, result);
+    return result;
+}
+
+/// The work of prove(), without looking in or adding to the ProofCache
+bool UserProc::proveUncached(Binary *query, bool conditional) {
     UniqExp original(query->clone());
     Exp *origLeft = original->getSubExp1();
     Exp *origRight = original->getSubExp2();
@@ -3525,6 +3667,7 @@ bool UserProc::prove(Binary *query, bool conditional /* = false */) {
                 if (DEBUG_PROOF)
                     LOG << "Using all=all for " << query->getSubExp1() << "\n" << "prove returns true\n";
                 provenTrue[origLeft->clone()] = right;
+                prog->getProofCache().invalidate(this); // Other queries may depend on this
                 return true;
             }
             else
@@ -3549,8 +3692,10 @@ bool UserProc::prove(Binary *query, bool conditional /* = false */) {
         LOG << "prove returns " << (result ? "true" : "false") << " for " << query << " in " << getName() << "\n";
 
     if (!conditional) {
-        if (result)
-            provenTrue[origLeft] = origRight; // Save the now proven equation
+        if (result) {
+            provenTrue[origLeft] = origRight;       // Save the now proven equation
+            prog->getProofCache().invalidate(this); // Other queries may depend on this
+        }
     }
     return result;
 }
@@ -3569,10 +3714,17 @@ bool UserProc::prover(Exp *query, std::set<PhiAssign *> &lastPhis, std::map<PhiA
 
     std::set<Instruction *> refsTo;
 
+    // Only the top node of query is changed in place below (and it is cloned before simplifying), so its
+    // subexpressions may be shared with the proven and premise sets without copying them
     query = query->clone();
     bool change = true;
     bool swapped = false;
     while (change) {
+        if (!prog->getProofCache().step()) {
+            if (DEBUG_PROOF)
+                LOG << "proof step budget exhausted at " << query << "\n";
+            return false; // Not proven is always safe
+        }
         if (DEBUG_PROOF)
             LOG << query << "\n";
 
@@ -3620,7 +3772,7 @@ bool UserProc::prover(Exp *query, std::set<PhiAssign *> &lastPhis, std::map<PhiA
                         Exp *provenTo = destProc->getProven(base);
                         if (provenTo) {
                             // There is a proven preservation. Use it to bypass the call
-                            Exp *queryLeft = call->localiseExp(provenTo->clone());
+                            Exp *queryLeft = call->localiseExp(provenTo);
                             query->setSubExp1(queryLeft);
                             // Now try everything on the result
                             return prover(query, lastPhis, cache, lastPhi);
@@ -3631,7 +3783,7 @@ bool UserProc::prover(Exp *query, std::set<PhiAssign *> &lastPhis, std::map<PhiA
                                 if (DEBUG_PROOF)
                                     LOG << "conditional preservation for call from " << getName() << " to "
                                         << destProc->getName() << ", allows bypassing\n";
-                                Exp *queryLeft = call->localiseExp(premisedTo->clone());
+                                Exp *queryLeft = call->localiseExp(premisedTo);
                                 query->setSubExp1(queryLeft);
                                 return prover(query, lastPhis, cache, lastPhi);
                             } else {
@@ -3651,7 +3803,7 @@ bool UserProc::prover(Exp *query, std::set<PhiAssign *> &lastPhis, std::map<PhiA
                                         LOG << "conditional preservation with new premise " << newQuery
                                             << " succeeds for " << destProc->getName() << "\n";
                                     // Use the new conditionally proven result
-                                    Exp *queryLeft = call->localiseExp(base->clone());
+                                    Exp *queryLeft = call->localiseExp(base);
                                     query->setSubExp1(queryLeft);
                                     return destProc->prover(query, lastPhis, cache, lastPhi);
                                 } else {
@@ -3666,7 +3818,6 @@ bool UserProc::prover(Exp *query, std::set<PhiAssign *> &lastPhis, std::map<PhiA
                     // Seems reasonable that recursive procs need protection from call loops too
                     Exp *right = call->getProven(r->getSubExp1()); // getProven returns the right side of what is
                     if (right) {                                   //    proven about r (the LHS of query)
-                        right = right->clone();
                         if (called.find(call) != called.end() && *called[call] == *query) {
                             LOG << "found call loop to " << call->getDestProc()->getName() << " " << query << "\n";
                             query = new Terminal(opFalse);
@@ -3937,7 +4088,8 @@ bool UserProc::searchAndReplace(const Exp &search, Exp *replace) {
     StatementList::iterator it;
     for (it = stmts.begin(); it != stmts.end(); it++) {
         Instruction *s = *it;
-        ch |= s->searchAndReplace(search, replace);
+        if (s->searchAndReplace(search, replace))
+            ch = true;
     }
     return ch;
 }
@@ -3986,7 +4138,7 @@ void UserProc::castConst(int num, SharedType ty) {
 bool UserProc::ellipsisProcessing() {
     BB_IT it;
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
+    BasicBlock::stmtrit srit;
     bool ch = false;
     for (it = cfg->begin(); it != cfg->end(); ++it) {
         CallStatement *c = dynamic_cast<CallStatement *>((*it)->getLastStmt(rrit, srit));
@@ -4178,7 +4330,7 @@ void UserProc::updateArguments() {
     LOG_VERBOSE(1) << "### update arguments for " << getName() << " ###\n";
     Boomerang::get()->alertDecompileDebugPoint(this, "before updating arguments");
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
+    BasicBlock::stmtrit srit;
     for (BasicBlock *it : *cfg) {
         CallStatement *c = dynamic_cast<CallStatement *>(it->getLastStmt(rrit, srit));
         // Note: we may have removed some statements, so there may no longer be a last statement!
@@ -4658,7 +4810,7 @@ void UserProc::fixCallAndPhiRefs() {
   ******************************************************************************/
 void UserProc::markAsNonChildless(const std::shared_ptr<ProcSet> &cs) {
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
+    BasicBlock::stmtrit srit;
 
     for (BasicBlock *bb : *cfg) {
         CallStatement *c = dynamic_cast<CallStatement *>(bb->getLastStmt(rrit, srit));
@@ -4690,9 +4842,10 @@ void UserProc::propagateToCollector() {
             if (as == nullptr || !as->isAssign())
                 continue;
             bool ch;
-            Exp *res = addr->clone()->searchReplaceAll(*r, as->getRight(), ch);
+            Exp *res = addr->substitute(*r, as->getRight(), ch); // Nothing is cloned unless there is a match
             if (!ch)
                 continue; // No change
+            res = res->clone(); // res shares nodes with addr and the rhs; it is simplified and kept below
             Exp *memOfRes = Location::memOf(res)->simplify();
             // First check to see if memOfRes is already in the set
             if (col.exists(memOfRes)) {
@@ -4809,7 +4962,7 @@ bool UserProc::isLocalOrParamPattern(Exp *e) {
   ******************************************************************************/
 bool UserProc::doesParamChainToCall(Exp *param, UserProc *p, ProcSet *visited) {
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
+    BasicBlock::stmtrit srit;
 
     for (BasicBlock *pb : *cfg) {
         CallStatement *c = (CallStatement *)pb->getLastStmt(rrit, srit);
@@ -5203,7 +5356,7 @@ void UserProc::updateForUseChange(std::set<UserProc *> &removeRetSet) {
     StatementList oldParameters(parameters);
     std::map<CallStatement *, UseCollector> callLiveness;
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
+    BasicBlock::stmtrit srit;
     BB_IT it;
     for (BasicBlock *bb = cfg->getFirstBB(it); bb; bb = cfg->getNextBB(it)) {
         CallStatement *c = dynamic_cast<CallStatement *>(bb->getLastStmt(rrit, srit));
@@ -5259,7 +5412,7 @@ void UserProc::clearUses() {
     col.clear();
     BB_IT it;
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
+    BasicBlock::stmtrit srit;
     for (it = cfg->begin(); it != cfg->end(); ++it) {
         CallStatement *c = (CallStatement *)(*it)->getLastStmt(rrit, srit);
         // Note: we may have removed some statements, so there may no longer be a last statement!
@@ -5330,7 +5483,7 @@ RTL *globalRtl = nullptr;
 void UserProc::processDecodedICTs() {
     BB_IT it;
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
+    BasicBlock::stmtrit srit;
     for (BasicBlock *bb = cfg->getFirstBB(it); bb; bb = cfg->getNextBB(it)) {
         Instruction *last = bb->getLastStmt(rrit, srit);
         if (last == nullptr)
@@ -5347,6 +5500,57 @@ void UserProc::processDecodedICTs() {
     }
 }
 
+/***************************************************************************/ /**
+  *
+  * \brief Get the arena from which the Exps and Statements of this proc are allocated (see arena.h), creating it
+  * on first use. Returns nullptr (i.e. use the heap) if the proc does not belong to a Prog.
+  *
+  ******************************************************************************/
+MemoryArena *UserProc::getArena() {
+    if (Arena == nullptr && prog != nullptr)
+        Arena = prog->createArena(getName());
+    return Arena;
+}
+
+/***************************************************************************/ /**
+  *
+  * \brief Keep a copy of the CFG as it is now (just decoded, not yet analysed), for reDecodeIncrementally()
+  *
+  ******************************************************************************/
+void UserProc::saveDecodedCfg() {
+    if (!Boomerang::get()->incrementalRedecode)
+        return;
+    delete decodedCfg;
+    decodedCfg = new Cfg;
+    decodedCfg->setProc(this);
+    decodedCfg->deepCopyFrom(*cfg);
+}
+
+/***************************************************************************/ /**
+  *
+  * \brief Re-decode this proc after indirect jumps or calls have been analysed, without decoding all of it again.
+  * The CFG is restored to the copy made by saveDecodedCfg(), the analysed statements saved by processDecodedICTs()
+  * are put back in, and only the newly found targets (e.g. switch arms) are decoded and added to the CFG, splitting
+  * BBs as needed.
+  * \returns false if this is not possible (e.g. -ir not given), and the proc has to be decoded from scratch
+  *
+  ******************************************************************************/
+bool UserProc::reDecodeIncrementally() {
+    if (!Boomerang::get()->incrementalRedecode || decodedCfg == nullptr)
+        return false;
+    cfg->deepCopyFrom(*decodedCfg);
+    // The return statement is needed to decode any new returns (see FrontEnd::createReturnBlock)
+    BasicBlock *retBB = cfg->findRetNode();
+    Instruction *last = retBB ? retBB->getLastStmt() : nullptr;
+    if (last && last->isReturn())
+        setTheReturnAddr((ReturnStatement *)last, ((ReturnStatement *)last)->getRetAddr());
+    if (!prog->decodeNewTargets(this))
+        return false;
+    setEntryBB();
+    LOG_VERBOSE(1) << "re-decoded only the new targets of " << getName() << "\n";
+    return true;
+}
+
 // Find or insert a new implicit reference just before statement s, for address expression a with type t.
 // Meet types if necessary
 /// Find and if necessary insert an implicit reference before s whose address expression is a and type is t.
@@ -5417,7 +5621,7 @@ void UserProc::eliminateDuplicateArgs() {
         LOG << "### eliminate duplicate args for " << getName() << " ###\n";
     BB_IT it;
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
+    BasicBlock::stmtrit srit;
     for (BasicBlock *bb : *cfg) {
         CallStatement *c = dynamic_cast<CallStatement *>(bb->getLastStmt(rrit, srit));
         // Note: we may have removed some statements, so there may no longer be a last statement!
@@ -5432,7 +5636,7 @@ void UserProc::removeCallLiveness() {
         LOG << "### removing call livenesses for " << getName() << " ###\n";
     BB_IT it;
     BasicBlock::rtlrit rrit;
-    StatementList::reverse_iterator srit;
+    BasicBlock::stmtrit srit;
     for (it = cfg->begin(); it != cfg->end(); ++it) {
         CallStatement *c = dynamic_cast<CallStatement *>((*it)->getLastStmt(rrit, srit));
         // Note: we may have removed some statements, so there may no longer be a last statement!
@@ -5474,6 +5678,12 @@ void Function::setProvenTrue(Exp *fact) {
     Exp *lhs = ((Binary *)fact)->getSubExp1();
     Exp *rhs = ((Binary *)fact)->getSubExp2();
     provenTrue[lhs] = rhs;
+    if (prog == nullptr)
+        return;
+    if (isLib())
+        prog->getProofCache().invalidate(); // Library procs make no queries, so nothing records what depends on them
+    else
+        prog->getProofCache().invalidate((UserProc *)this);
 }
 
 //! Map expressions to locals and initial parameters
@@ -5725,7 +5935,7 @@ scaledArrayPat(opMemOf, Binary::get(opPlus, Binary::get(opMult, Terminal::get(op
 
 void UserProc::dfa_analyze_scaled_array_ref(Instruction *s, Prog *prog) {
     Exp *arr;
-    std::list<Exp *> result;
+    ExpMatches result;
     s->searchAll(scaledArrayPat, result);
     // query: (memOf (opPlus (opMult ? ?:IntConst) ?:IntConst))
     // rewrite_as (opArrayIndex (global `(getOrCreateGlobalName arg3) ) arg2 ) assert (= (typeSize
@@ -35,6 +35,7 @@
 #include "frontend.h"
 #include "signature.h"
 #include "boomerang.h"
+#include "callgraph.h"
 #include "ansi-c-parser.h"
 #include "config.h"
 #include "managed.h"
@@ -53,6 +54,7 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <unordered_map>
 #include <algorithm>
 #include <cmath>
 #ifdef _WIN32
@@ -73,6 +75,8 @@ Prog::Prog(const QString &name) : pLoaderPlugin(nullptr), DefaultFrontend(nullpt
     m_rootCluster = getOrInsertModule("prog");
     Image = Boomerang::get()->getImage();
     BinarySymbols = (SymTab *)Boomerang::get()->getSymbols();
+    MemoryArena::setPlacement(Boomerang::get()->arenaAlloc);
+    GlobalArena = createArena("<global>");
     // Default constructor
 }
 /// Create or retrieve existing module
@@ -107,11 +111,108 @@ void Prog::setFrontEnd(FrontEnd *_pFE) {
 }
 
 Prog::~Prog() {
-    pLoaderPlugin->deleteLater();
+    if (pLoaderPlugin) // Not set if no front end was ever set
+        pLoaderPlugin->deleteLater();
     delete DefaultFrontend;
     for (Module *m : ModuleList) {
         delete m;
     }
+    // Exps are shared between procs (e.g. through call and return statements), so the arenas can only go now
+    Arenas.clear();
+}
+
+/***************************************************************************/ /**
+  * \brief Create a new memory arena, owned by this program
+  * \param name - name used when reporting the arena's counters, usually the name of the owning proc
+  ******************************************************************************/
+MemoryArena *Prog::createArena(const QString &name) {
+    Arenas.emplace_back(name);
+    return &Arenas.back();
+}
+
+/***************************************************************************/ /**
+  * \brief Print the allocation counters of every arena that was used
+  ******************************************************************************/
+void Prog::printArenaStats(QTextStream &os) const {
+    uint64_t totalAllocs = 0, totalBytes = 0;
+    for (const MemoryArena &arena : Arenas) {
+        if (arena.getNumAllocs() == 0)
+            continue;
+        os << arena.getName() << ": " << arena.getNumAllocs() << " allocations, " << arena.getBytesAllocated()
+           << " bytes";
+        if (arena.getBytesReserved())
+            os << " (" << arena.getBytesReserved() << " bytes reserved)";
+        os << "\n";
+        totalAllocs += arena.getNumAllocs();
+        totalBytes += arena.getBytesAllocated();
+    }
+    os << "total: " << totalAllocs << " allocations, " << totalBytes << " bytes\n";
+}
+
+/***************************************************************************/ /**
+  * \brief Print the Exp::simplify counters of every user proc
+  ******************************************************************************/
+void Prog::printSimplifyStats(QTextStream &os) {
+    SimplifyStats total;
+    for (Module *module : ModuleList) {
+        for (Function *func : *module) {
+            if (func->isLib())
+                continue;
+            const SimplifyStats &st = ((UserProc *)func)->getSimplifyStats();
+            if (st.Calls == 0)
+                continue;
+            os << func->getName() << ": " << st.Calls << " calls, " << st.Skipped << " already simplified, "
+               << st.Rewrites << " rewrites, " << st.Nsecs / 1000 << " us\n";
+            total.Calls += st.Calls;
+            total.Skipped += st.Skipped;
+            total.Rewrites += st.Rewrites;
+            total.Nsecs += st.Nsecs;
+        }
+    }
+    os << "total: " << total.Calls << " calls, " << total.Skipped << " already simplified, " << total.Rewrites
+       << " rewrites, " << total.Nsecs / 1000 << " us\n";
+}
+void Prog::printProofStats(QTextStream &os) {
+    ProofStats total;
+    for (Module *module : ModuleList) {
+        for (Function *func : *module) {
+            if (func->isLib())
+                continue;
+            const ProofStats &st = ((UserProc *)func)->getProofStats();
+            if (st.Queries == 0)
+                continue;
+            os << func->getName() << ": " << st.Queries << " queries, " << st.CacheHits << " cache hits, "
+               << st.Exhausted << " out of budget\n";
+            total.Queries += st.Queries;
+            total.CacheHits += st.CacheHits;
+            total.Exhausted += st.Exhausted;
+        }
+    }
+    os << "total: " << total.Queries << " queries, " << total.CacheHits << " cache hits, " << total.Exhausted
+       << " out of budget\n";
+}
+
+/***************************************************************************/ /**
+  * \brief Print the phi placement counters of every user proc, and which placement was used
+  ******************************************************************************/
+void Prog::printPhiStats(QTextStream &os) {
+    PhiStats total;
+    for (Module *module : ModuleList) {
+        for (Function *func : *module) {
+            if (func->isLib())
+                continue;
+            const PhiStats &st = ((UserProc *)func)->getDataFlow()->getPhiStats();
+            if (st.Placed == 0 && st.Pruned == 0)
+                continue;
+            os << func->getName() << ": " << st.Placed << " placed, " << st.Pruned << " pruned, " << st.Nsecs / 1000
+               << " us\n";
+            total.Placed += st.Placed;
+            total.Pruned += st.Pruned;
+            total.Nsecs += st.Nsecs;
+        }
+    }
+    os << "total: " << total.Placed << " placed, " << total.Pruned << " pruned, " << total.Nsecs / 1000 << " us ("
+       << (Boomerang::get()->prunedPhis ? "pruned" : "minimal") << " SSA)\n";
 }
 //! Assign a name to this program
 void Prog::setName(const char *name) {
@@ -1046,12 +1147,42 @@ void Prog::decodeEverythingUndecoded() {
 //! Do the main non-global decompilation steps
 void Prog::decompile() {
     Boomerang * boom=Boomerang::get();
+    ArenaScope arenaScope(GlobalArena);
     assert(!ModuleList.empty());
     getNumProcs();
     LOG_VERBOSE(1) << getNumProcs(false) << " procedures\n";
 
+    if (!boom->noDecodeChildren) {
+        // Decompile the call graph bottom up, one strongly connected component at a time. Tarjan's algorithm finishes
+        // the components in the same order as the depth first search in UserProc::decompile, so the result is the
+        // same, but each decompile() now only recurses within a recursion group, however deep the call chains are.
+        // The components are decompiled one after the other: components that do not call each other could be done in
+        // parallel, but the decompiler's global state (e.g. the Boomerang singleton and the log) is not thread safe
+        CallGraphSCCs sccs;
+        for (UserProc *up : entryProcs)
+            sccs.addRoot(up);
+        LOG_VERBOSE(1) << (int)sccs.size() << " call graph components\n";
+        for (size_t i = 0; i < sccs.size(); i++) {
+            // The first procedure is where the search entered the component, so decompiling it visits the rest of
+            // its recursion group as decompiling the entry point would have done
+            for (UserProc *up : sccs.getComponent(i)) {
+                if (up->isDecompiled())
+                    continue;
+                if (std::find(entryProcs.begin(), entryProcs.end(), up) != entryProcs.end())
+                    LOG_VERBOSE(1) << "decompiling entry point " << up->getName() << "\n";
+                else
+                    up->promoteSignature(); // As the caller would have done on the way down
+                ProcList call_path;
+                int indent = 0;
+                up->decompile(&call_path, indent);
+            }
+        }
+    }
+
     // Start decompiling each entry point
     for (UserProc *up : entryProcs) {
+        if (up->isDecompiled())
+            continue;
         ProcList call_path;
         LOG_VERBOSE(1) << "decompiling entry point " << up->getName() << "\n";
         int indent = 0;
@@ -1088,11 +1219,10 @@ void Prog::decompile() {
 
     if (!Boomerang::get()->noDecompile) {
         if (!Boomerang::get()->noRemoveReturns) {
-            // A final pass to remove returns not used by any caller
+            // A final pass to remove returns not used by any caller. This reaches a fixed point by itself; only the
+            // procs affected by a change are examined again
             LOG_VERBOSE(1) << "prog: global removing unused returns\n";
-            // Repeat until no change. Note 100% sure if needed.
-            while (removeUnusedReturns())
-                ;
+            removeUnusedReturns();
         }
 
         // print XML after removing returns
@@ -1112,6 +1242,17 @@ void Prog::decompile() {
 
     // removeUnusedLocals(); Note: is now in UserProc::generateCode()
     removeUnusedGlobals();
+
+    if (VERBOSE) {
+        LOG << "memory arenas:\n";
+        printArenaStats(LOG_STREAM());
+        LOG << "simplification:\n";
+        printSimplifyStats(LOG_STREAM());
+        LOG << "proofs:\n";
+        printProofStats(LOG_STREAM());
+        LOG << "phi functions:\n";
+        printPhiStats(LOG_STREAM());
+    }
 }
 //! As the name suggests, removes globals unused in the decompiled code.
 void Prog::removeUnusedGlobals() {
@@ -1179,30 +1320,55 @@ void Prog::removeUnusedGlobals() {
   *
   ******************************************************************************/
 bool Prog::removeUnusedReturns() {
-    // For each UserProc. Each proc may process many others, so this may duplicate some work. Really need a worklist of
-    // procedures not yet processed.
-    // Define a workset for the procedures who have to have their returns checked
-    // This will be all user procs, except those undecoded (-sf says just trust the given signature)
-    std::set<UserProc *> removeRetSet;
-    bool change = false;
-    for(Module *module : ModuleList) {
+    // Examine the procs top down in the call graph, since the returns of a proc are decided by the liveness at the
+    // calls to it. A proc is examined again only when removeRedundantReturns() schedules it: a caller whose arguments
+    // changed, or a callee whose liveness at some call changed, which is where changes propagate down the call tree
+    // (no caller uses potential returns for child) and up it (removal of returns and/or dead code removes parameters,
+    // which affects all callers).
+    // The procs to start with are all user procs, except those undecoded (-sf says just trust the given signature)
+    CallGraphSCCs sccs;
+    for (Module *module : ModuleList) {
         for (Function *pp : *module) {
             UserProc *proc = dynamic_cast<UserProc *>(pp);
-            if (nullptr==proc || !proc->isDecoded())
-                continue; // e.g. use -sf file to just prototype the proc
-            removeRetSet.insert(proc);
+            if (proc != nullptr && proc->isDecoded())
+                sccs.addRoot(proc);
         }
     }
-    // The workset is processed in arbitrary order. May be able to do better, but note that sometimes changes propagate
-    // down the call tree (no caller uses potential returns for child), and sometimes up the call tree (removal of
-    // returns and/or dead code removes parameters, which affects all callers).
-    while (!removeRetSet.empty()) {
-        auto it = removeRetSet.begin(); // Pick the first element of the set
-        change |= (*it)->removeRedundantReturns(removeRetSet);
-        // Note: removing the currently processed item here should prevent unnecessary reprocessing of self recursive
-        // procedures
-        removeRetSet.erase(it); // Remove the current element (may no longer be the first)
+    std::vector<UserProc *> byOrder; // Callers before callees, except within a recursion group
+    std::unordered_map<UserProc *, size_t> order;
+    for (size_t i = sccs.size(); i-- > 0;) {
+        for (UserProc *proc : sccs.getComponent(i)) {
+            order[proc] = byOrder.size();
+            byOrder.push_back(proc);
+        }
     }
+    std::set<size_t> workSet; // Positions in byOrder of the procs still to examine
+    for (size_t i = 0; i < byOrder.size(); i++) {
+        if (byOrder[i]->isDecoded())
+            workSet.insert(i);
+    }
+
+    bool change = false;
+    std::set<UserProc *> removeRetSet; // The procs scheduled by the last one examined
+    int numExamined = 0;
+    while (!workSet.empty()) {
+        UserProc *proc = byOrder[*workSet.begin()];
+        workSet.erase(workSet.begin());
+        numExamined++;
+        removeRetSet.clear();
+        change |= proc->removeRedundantReturns(removeRetSet);
+        // Note: a self recursive proc may schedule itself; it was taken off the work set first, so it is examined
+        // again, since there is no longer a second pass over all the procs to catch what that would find
+        for (UserProc *sched : removeRetSet) {
+            auto ff = order.find(sched);
+            if (ff == order.end()) { // Not reached from a decoded proc; examine it last
+                ff = order.emplace(sched, byOrder.size()).first;
+                byOrder.push_back(sched);
+            }
+            workSet.insert(ff->second);
+        }
+    }
+    LOG_VERBOSE(1) << "examined " << numExamined << " procs for unused returns\n";
     return change;
 }
 
@@ -1615,6 +1781,9 @@ void Prog::reDecode(UserProc *proc) {
     DefaultFrontend->processProc(proc->getNativeAddress(), proc, os);
 }
 
+//! Decode only the new targets of the analysed indirect jumps and calls of this proc (see FrontEnd::decodeNewTargets)
+bool Prog::decodeNewTargets(UserProc *proc) { return DefaultFrontend->decodeNewTargets(proc); }
+
 void Prog::decodeFragment(UserProc *proc, ADDRESS a) {
     if (a >= Image->getLimitTextLow() && a < Image->getLimitTextHigh())
         DefaultFrontend->decodeFragment(proc, a);
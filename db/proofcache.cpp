@@ -0,0 +1,118 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/***************************************************************************/ /**
+  * \file       proofcache.cpp
+  * OVERVIEW:   Implementation of the ProofCache class.
+  ******************************************************************************/
+
+#include "proofcache.h"
+
+#include "exp.h"
+#include "exphelp.h"
+#include "arena.h"
+
+bool ProofCache::KeyLess::operator()(const Key &a, const Key &b) const {
+    lessExpStar less;
+    if (a.Proc != b.Proc)
+        return a.Proc < b.Proc;
+    if (a.Conditional != b.Conditional)
+        return b.Conditional;
+    if (a.Query == nullptr || b.Query == nullptr) // Only when looking for the first key of a proc
+        return a.Query == nullptr && b.Query != nullptr;
+    if (less(a.Query, b.Query))
+        return true;
+    if (less(b.Query, a.Query))
+        return false;
+    if (a.Premises.size() != b.Premises.size())
+        return a.Premises.size() < b.Premises.size();
+    for (size_t i = 0; i < a.Premises.size(); i++) {
+        const Premise &pa = a.Premises[i];
+        const Premise &pb = b.Premises[i];
+        if (pa.Proc != pb.Proc)
+            return pa.Proc < pb.Proc;
+        if (less(pa.Left, pb.Left))
+            return true;
+        if (less(pb.Left, pa.Left))
+            return false;
+        if (less(pa.Right, pb.Right))
+            return true;
+        if (less(pb.Right, pa.Right))
+            return false;
+    }
+    return false;
+}
+
+//! Set result to the remembered result of query in proc under premises, if there is one
+bool ProofCache::find(UserProc *proc, Exp *query, bool conditional, const std::vector<Premise> &premises,
+                      bool &result) const {
+    Key key{proc, query, conditional, premises};
+    auto found = Results.find(key);
+    if (found == Results.end())
+        return false;
+    result = found->second;
+    return true;
+}
+
+/// Remember the result of query in proc under premises. The expressions are copied. Once the budget has run out, the
+/// results of the queries made by the outermost one are not to be trusted, so only its own result is kept.
+void ProofCache::insert(UserProc *proc, Exp *query, bool conditional, const std::vector<Premise> &premises,
+                        bool result) {
+    if (Exhausted && Active.size() > 1)
+        return;
+    Key key{proc, query, conditional, premises};
+    if (Results.find(key) != Results.end())
+        return;
+    // The copies live as long as the cache, which can be longer than the arena of the proc
+    key.Query = onHeap([query] { return query->clone(); });
+    for (Premise &p : key.Premises) {
+        p.Left = onHeap([&p] { return p.Left->clone(); });
+        p.Right = onHeap([&p] { return p.Right->clone(); });
+    }
+    Results.emplace(std::move(key), result);
+}
+
+//! Delete the expressions owned by a key of Results
+void ProofCache::release(const Key &key) {
+    delete key.Query;
+    for (const Premise &p : key.Premises) {
+        delete p.Left;
+        delete p.Right;
+    }
+}
+
+/// Forget the results of proc, e.g. because something new has been proven in it or its statements have changed, and
+/// those of every proc that depends on it
+void ProofCache::invalidate(UserProc *proc) {
+    std::set<UserProc *> done;
+    std::vector<UserProc *> todo{proc};
+    while (!todo.empty()) {
+        UserProc *p = todo.back();
+        todo.pop_back();
+        if (!done.insert(p).second)
+            continue;
+        // The keys are ordered by proc first, so the results of p are one range. No query sorts before any other.
+        Key first{p, nullptr, false, {}};
+        auto rr = Results.lower_bound(first);
+        while (rr != Results.end() && rr->first.Proc == p) {
+            release(rr->first);
+            rr = Results.erase(rr);
+        }
+        // The dependences are kept: a query of a dependent may be in progress, and insert its result afterwards
+        auto dd = Dependents.find(p);
+        if (dd != Dependents.end())
+            todo.insert(todo.end(), dd->second.begin(), dd->second.end());
+    }
+}
+
+//! Forget all results
+void ProofCache::invalidate() {
+    for (auto &rr : Results)
+        release(rr.first);
+    Results.clear();
+    Dependents.clear();
+}
@@ -46,7 +46,7 @@ RTL::RTL() : nativeAddr(ADDRESS::g(0L)) {}
   ******************************************************************************/
 RTL::RTL(ADDRESS instNativeAddr, const std::list<Instruction *> *listStmt /*= nullptr*/) : nativeAddr(instNativeAddr) {
     if (listStmt)
-        *(std::list<Instruction *> *)this = *listStmt;
+        assign(listStmt->begin(), listStmt->end());
 }
 
 /***************************************************************************/ /**
@@ -54,7 +54,8 @@ RTL::RTL(ADDRESS instNativeAddr, const std::list<Instruction *> *listStmt /*= nu
   *                    so that the lists of Exps do not share memory.
   * \param        other RTL to copy from
   ******************************************************************************/
-RTL::RTL(const RTL &other) : std::list<Instruction *>(), nativeAddr(other.nativeAddr) {
+RTL::RTL(const RTL &other) : std::vector<Instruction *>(), nativeAddr(other.nativeAddr) {
+    reserve(other.size());
     for (auto const &elem : other) {
         push_back(elem->clone());
     }
@@ -75,6 +76,7 @@ RTL &RTL::operator=(const RTL &other) {
         qDeleteAll(*this);
         // Do a deep copy always
         clear();
+        reserve(other.size());
         const_iterator it;
         for (it = other.begin(); it != other.end(); it++)
             push_back((*it)->clone());
@@ -91,11 +93,12 @@ RTL &RTL::operator=(const RTL &other) {
   * \returns             Pointer to a new RTL that is a clone of this one
   ******************************************************************************/
 RTL *RTL::clone() const {
-    std::list<Instruction *> le;
+    RTL *res = new RTL(nativeAddr);
+    res->reserve(size());
     for (auto const &elem : *this) {
-        le.push_back((elem)->clone());
+        res->push_back((elem)->clone());
     }
-    return new RTL(nativeAddr, &le);
+    return res;
 }
 
 /***************************************************************************/ /**
@@ -130,9 +133,9 @@ void RTL::appendStmt(Instruction *s) {
 /***************************************************************************/ /**
   * \brief  Append a given list of Statements to this RTL
   * \note   A copy of the Statements in le are appended
-  * \param  le - list of Statements to insert
+  * \param  le - RTL with the Statements to insert
   ******************************************************************************/
-void RTL::appendListStmt(std::list<Instruction *> &le) {
+void RTL::appendListStmt(const RTL &le) {
     for (Instruction *it : le) {
         push_back(it->clone());
     }
@@ -1693,11 +1693,13 @@ Exp *Signature::getEarlyParamExp(int n, Prog *prog) {
 
 StatementList &Signature::getStdRetStmt(Prog *prog) {
     // pc := m[r[28]]
-    static Assign pent1ret(new Terminal(opPC), Location::memOf(Location::regOf(28)));
+    static Assign &pent1ret = *onHeap([] { return new Assign(new Terminal(opPC), Location::memOf(Location::regOf(28))); });
     // r[28] := r[28] + 4
-    static Assign pent2ret(Location::regOf(28), Binary::get(opPlus, Location::regOf(28), new Const(4)));
-    static Assign st20_1ret(new Terminal(opPC), Location::memOf(Location::regOf(3)));
-    static Assign st20_2ret(Location::regOf(3), Binary::get(opPlus, Location::regOf(3), new Const(16)));
+    static Assign &pent2ret =
+        *onHeap([] { return new Assign(Location::regOf(28), Binary::get(opPlus, Location::regOf(28), new Const(4))); });
+    static Assign &st20_1ret = *onHeap([] { return new Assign(new Terminal(opPC), Location::memOf(Location::regOf(3))); });
+    static Assign &st20_2ret =
+        *onHeap([] { return new Assign(Location::regOf(3), Binary::get(opPlus, Location::regOf(3), new Const(16))); });
     MACHINE mach = prog->getMachine();
     switch (mach) {
     case MACHINE_SPARC:
@@ -1763,7 +1765,7 @@ bool Signature::isAddrOfStackLocal(Prog *prog, Exp *e) {
     if (op == opAddrOf)
         return isStackLocal(prog, e->getSubExp1());
     // e must be sp -/+ K or just sp
-    static Exp *sp = Location::regOf(getStackRegister(prog));
+    static Exp *sp = onHeap([&] { return Location::regOf(getStackRegister(prog)); });
     if (op != opMinus && op != opPlus) {
         // Matches if e is sp or sp{0} or sp{-}
         return (*e == *sp ||
@@ -1793,7 +1795,7 @@ bool CallingConvention::StdC::SparcSignature::isAddrOfStackLocal(Prog *prog, Exp
     if (op == opAddrOf)
         return isStackLocal(prog, e->getSubExp1());
     // e must be sp -/+ K or just sp
-    static Exp *sp = Location::regOf(14);
+    static Exp *sp = onHeap([] { return Location::regOf(14); });
     if (op != opMinus && op != opPlus) {
         // Matches if e is sp or sp{0} or sp{-}
         return (*e == *sp ||
@@ -152,6 +152,7 @@ bool RTLInstDict::readSSLFile(const QString &SSLFileName) {
     theParser.yyparse(*this);
 
     fixupParams();
+    buildIndices();
 
     if (Boomerang::get()->debugDecoder) {
         QTextStream q_cout(stdout);
@@ -536,7 +537,7 @@ void RTLInstDict::transformPostVars(std::list<Instruction *> &rts, bool optimise
                     var.second.used = true;
                     break;
                 }
-                std::list<Exp *> res1, res2;
+                ExpMatches res1, res2;
                 s->searchAll(*var.second.base, res1);
                 s->searchAll(*var.second.post, res2);
                 // Each match of a post will also match the base.
@@ -600,4 +601,151 @@ void RTLInstDict::reset() {
     fastMap.clear();
     idict.clear();
     fetchExecCycle = nullptr;
+    RegIndex.clear();
+    RegIdxBySlot.clear();
+    RegNameByIdx.clear();
+    RegSizeByIdx.clear();
+    ParamIndex.clear();
+    ParamBySlot.clear();
+}
+
+/***************************************************************************/ /**
+  * \brief Build the lookup tables for registers and parameters from RegMap, DetRegMap and DetParamMap. Called
+  * after the SSL file is read; the maps must not change after this
+  ******************************************************************************/
+void RTLInstDict::buildIndices() {
+    std::vector<QString> names;
+    RegIdxBySlot.clear();
+    RegNameByIdx.clear();
+    for (const std::pair<QString, int> &elem : RegMap) {
+        names.push_back(elem.first);
+        RegIdxBySlot.push_back(elem.second);
+        if (elem.second < 0)
+            continue;
+        if (RegNameByIdx.size() <= size_t(elem.second))
+            RegNameByIdx.resize(elem.second + 1);
+        if (RegNameByIdx[elem.second].isNull()) // Keep the first name, as the old search of RegMap did
+            RegNameByIdx[elem.second] = elem.first;
+    }
+    RegIndex.build(names);
+
+    RegSizeByIdx.clear();
+    for (const std::pair<const int, Register> &elem : DetRegMap) {
+        if (elem.first < 0)
+            continue;
+        if (RegSizeByIdx.size() <= size_t(elem.first))
+            RegSizeByIdx.resize(elem.first + 1, 0);
+        RegSizeByIdx[elem.first] = elem.second.g_size();
+    }
+
+    names.clear();
+    ParamBySlot.clear();
+    for (auto iter = DetParamMap.begin(); iter != DetParamMap.end(); ++iter) {
+        names.push_back(iter.key());
+        ParamBySlot.push_back(&iter.value());
+    }
+    ParamIndex.build(names);
+}
+
+/***************************************************************************/ /**
+  * \brief Get the index of a register from its name (e.g. "%g0")
+  * \returns the index, or -1 if there is no such register
+  ******************************************************************************/
+int RTLInstDict::getRegIdx(const char *name) const {
+    int slot = RegIndex.find(name);
+    return slot == -1 ? -1 : RegIdxBySlot[slot];
+}
+
+/***************************************************************************/ /**
+  * \brief Get the name of a register from its index
+  * \returns the name, or a null string if there is no such register
+  ******************************************************************************/
+QString RTLInstDict::getRegName(int idx) const {
+    if (idx >= 0)
+        return size_t(idx) < RegNameByIdx.size() ? RegNameByIdx[idx] : QString();
+    // Special registers all have index -1; rare, so just search
+    for (const std::pair<QString, int> &elem : RegMap)
+        if (elem.second == idx)
+            return elem.first;
+    return QString();
+}
+
+/***************************************************************************/ /**
+  * \brief Get the size in bits of a register from its index
+  * \returns the size, or 0 if the register is not defined
+  ******************************************************************************/
+int RTLInstDict::getRegSize(int idx) const {
+    if (idx < 0 || size_t(idx) >= RegSizeByIdx.size())
+        return 0;
+    return RegSizeByIdx[idx];
+}
+
+/***************************************************************************/ /**
+  * \brief Get the details of a parameter (operand) from its name
+  * \returns the ParamEntry, or nullptr if the parameter has no details
+  ******************************************************************************/
+ParamEntry *RTLInstDict::getParam(const char *name) const {
+    int slot = ParamIndex.find(name);
+    return slot == -1 ? nullptr : ParamBySlot[slot];
+}
+
+/***************************************************************************/ /**
+  * \brief Build the hash for a set of distinct names. Seeds are tried until one maps all names to different
+  * slots; the table is doubled if none is found quickly, which only happens for unlucky sets of names.
+  * \param names - the names; the slot of names[i] is i
+  ******************************************************************************/
+void NameIndex::build(const std::vector<QString> &names) {
+    Names.clear();
+    for (const QString &name : names)
+        Names.push_back(name.toLatin1());
+    size_t tableSize = 2;
+    while (tableSize < 2 * Names.size())
+        tableSize <<= 1;
+    for (;;) {
+        Slots.resize(tableSize);
+        Mask = tableSize - 1;
+        for (Seed = 0; Seed < 256; ++Seed) {
+            std::fill(Slots.begin(), Slots.end(), -1);
+            size_t i = 0;
+            for (; i < Names.size(); ++i) {
+                int &slot = Slots[hash(Names[i].constData(), Names[i].size(), Seed) & Mask];
+                if (slot != -1)
+                    break; // Collision; try the next seed
+                slot = i;
+            }
+            if (i == Names.size())
+                return;
+        }
+        tableSize <<= 1;
+    }
+}
+
+void NameIndex::clear() {
+    Names.clear();
+    Slots.clear();
+    Seed = Mask = 0;
+}
+
+/***************************************************************************/ /**
+  * \brief Find the slot of a name
+  * \returns the slot, or -1 if the name is not in the set
+  ******************************************************************************/
+int NameIndex::find(const char *name) const {
+    if (Slots.empty())
+        return -1;
+    int slot = Slots[hash(name, strlen(name), Seed) & Mask];
+    if (slot == -1 || Names[slot] != name)
+        return -1;
+    return slot;
+}
+
+//! Seeded FNV-1a, with a final mix so that the low bits (used for the slot) depend on all the bytes
+uint32_t NameIndex::hash(const char *s, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (size_t i = 0; i < len; ++i)
+        h = (h ^ uint8_t(s[i])) * 16777619u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    return h;
 }
@@ -202,6 +202,31 @@ void Instruction::dump() {
     q_cerr << "\n";
 }
 
+/***************************************************************************/ /**
+  * \brief Find all instances of the search expression, in the order searchEach finds them
+  * \param search - a location to search for
+  * \param result - the matches are appended to it
+  * \returns true if there were any matches
+  ******************************************************************************/
+bool Instruction::searchAll(const Exp &search, std::list<Exp *> &result) {
+    size_t before = result.size();
+    auto collect = searchWith([&result](Exp *e) {
+        result.push_back(e);
+        return true;
+    });
+    searchEach(search, collect);
+    return result.size() != before;
+}
+bool Instruction::searchAll(const Exp &search, ExpMatches &result) {
+    size_t before = result.size();
+    auto collect = searchWith([&result](Exp *e) {
+        result.push_back(e);
+        return true;
+    });
+    searchEach(search, collect);
+    return result.size() != before;
+}
+
 /* This function is designed to find basic flag calls, plus in addition two variations seen with Pentium FP code.
         These variations involve ANDing and/or XORing with constants. So it should return true for these values of e:
         ADDFLAGS(...)
@@ -650,17 +675,16 @@ bool GotoStatement::searchAndReplace(const Exp &search, Exp *replace, bool /*cc*
 }
 
 /***************************************************************************/ /**
-  * \fn        GotoStatement::searchAll
+  * \fn        GotoStatement::searchEach
   * \brief        Find all instances of the search expression
   * \param search - a location to search for
-  * \param result - a list which will have any matching exprs
-  *                 appended to it
-  * \returns true if there were any matches
+  * \param cb - receives each matching expression
+  * \returns false if cb stopped the search
   ******************************************************************************/
-bool GotoStatement::searchAll(const Exp &search, std::list<Exp *> &result) {
+bool GotoStatement::searchEach(const Exp &search, SearchCallback &cb) {
     if (pDest)
-        return pDest->searchAll(search, result);
-    return false;
+        return pDest->searchEach(search, cb);
+    return true;
 }
 
 /***************************************************************************/ /**
@@ -968,16 +992,15 @@ bool BranchStatement::searchAndReplace(const Exp &search, Exp *replace, bool cc)
 }
 
 /***************************************************************************/ /**
-  * \brief   Find all instances of the search expression
+  * \brief   Find all instances of the search expression in the condition
   * \param   search - a location to search for
-  * \param   result - a list which will have any matching exprs
-  *          appended to it
-  * \returns true if there were any matches
+  * \param   cb - receives each matching expression
+  * \returns false if cb stopped the search
   ******************************************************************************/
-bool BranchStatement::searchAll(const Exp &search, std::list<Exp *> &result) {
+bool BranchStatement::searchEach(const Exp &search, SearchCallback &cb) {
     if (pCond)
-        return pCond->searchAll(search, result);
-    return false;
+        return pCond->searchEach(search, cb);
+    return true;
 }
 
 /***************************************************************************/ /**
@@ -1479,15 +1502,29 @@ bool CaseStatement::searchAndReplace(const Exp &search, Exp *replace, bool cc) {
 }
 
 /***************************************************************************/ /**
-  * \fn    CaseStatement::searchAll
-  * \brief Find all instances of the search expression
+  * \fn    CaseStatement::searchEach
+  * \brief Find all instances of the search expression. The switch variable is only searched if the destination
+  * has no match
   * \param search - a location to search for
-  * \param result - a list which will have any matching exprs appended to it
-  * \returns true if there were any matches
+  * \param cb - receives each matching expression
+  * \returns false if cb stopped the search
   ******************************************************************************/
-bool CaseStatement::searchAll(const Exp &search, std::list<Exp *> &result) {
-    return GotoStatement::searchAll(search, result) ||
-           (pSwitchInfo && pSwitchInfo->pSwitchVar && pSwitchInfo->pSwitchVar->searchAll(search, result));
+bool CaseStatement::searchEach(const Exp &search, SearchCallback &cb) {
+    //! Passes the matches on, noting whether there were any
+    struct NoteFound : public SearchCallback {
+        explicit NoteFound(SearchCallback &inner) : Inner(inner) {}
+        bool found(Exp **pp) override {
+            Found = true;
+            return Inner.found(pp);
+        }
+        SearchCallback &Inner;
+        bool Found = false;
+    } dest(cb);
+    if (!GotoStatement::searchEach(search, dest))
+        return false;
+    if (dest.Found || pSwitchInfo == nullptr || pSwitchInfo->pSwitchVar == nullptr)
+        return true;
+    return pSwitchInfo->pSwitchVar->searchEach(search, cb);
 }
 
 /***************************************************************************/ /**
@@ -1731,24 +1768,22 @@ bool CallStatement::searchAndReplace(const Exp &search, Exp *replace, bool cc) {
 }
 
 /***************************************************************************/ /**
-  * \fn    CallStatement::searchAll
+  * \fn    CallStatement::searchEach
   * \brief Find all instances of the search expression
   * \param search - a location to search for
-  * \param result - a list which will have any matching exprs appended to it
-  * \returns true if there were any matches
+  * \param cb - receives each matching expression
+  * \returns false if cb stopped the search
   ******************************************************************************/
-bool CallStatement::searchAll(const Exp &search, std::list<Exp *> &result) {
-    bool found = GotoStatement::searchAll(search, result);
-    StatementList::iterator ss;
-    for (ss = defines.begin(); ss != defines.end(); ++ss) {
-        if ((*ss)->searchAll(search, result))
-            found = true;
-    }
-    for (ss = arguments.begin(); ss != arguments.end(); ++ss) {
-        if ((*ss)->searchAll(search, result))
-            found = true;
-    }
-    return found;
+bool CallStatement::searchEach(const Exp &search, SearchCallback &cb) {
+    if (!GotoStatement::searchEach(search, cb))
+        return false;
+    for (Instruction *s : defines)
+        if (!s->searchEach(search, cb))
+            return false;
+    for (Instruction *s : arguments)
+        if (!s->searchEach(search, cb))
+            return false;
+    return true;
 }
 
 /***************************************************************************/ /**
@@ -2560,14 +2595,11 @@ bool ReturnStatement::searchAndReplace(const Exp &search, Exp *replace, bool cc)
     return change;
 }
 
-bool ReturnStatement::searchAll(const Exp &search, std::list<Exp *> &result) {
-    bool found = false;
-    ReturnStatement::iterator rr;
-    for (rr = begin(); rr != end(); ++rr) {
-        if ((*rr)->searchAll(search, result))
-            found = true;
-    }
-    return found;
+bool ReturnStatement::searchEach(const Exp &search, SearchCallback &cb) {
+    for (Instruction *s : returns)
+        if (!s->searchEach(search, cb))
+            return false;
+    return true;
 }
 
 bool CallStatement::isDefinition() {
@@ -2789,13 +2821,12 @@ bool BoolAssign::search(const Exp &search, Exp *&result) {
     return pCond->search(search, result);
 }
 
-bool BoolAssign::searchAll(const Exp &search, std::list<Exp *> &result) {
-    bool ch = false;
+bool BoolAssign::searchEach(const Exp &search, SearchCallback &cb) {
     assert(lhs);
-    if (lhs->searchAll(search, result))
-        ch = true;
+    if (!lhs->searchEach(search, cb))
+        return false;
     assert(pCond);
-    return pCond->searchAll(search, result) || ch;
+    return pCond->searchEach(search, cb);
 }
 
 bool BoolAssign::searchAndReplace(const Exp &search, Exp *replace, bool cc) {
@@ -3096,22 +3127,13 @@ bool PhiAssign::search(const Exp &search, Exp *&result) {
 }
 bool ImplicitAssign::search(const Exp &search, Exp *&result) { return lhs->search(search, result); }
 
-bool Assign::searchAll(const Exp &search, std::list<Exp *> &result) {
-    bool res;
-    std::list<Exp *> leftResult;
-    std::list<Exp *>::iterator it;
-    res = lhs->searchAll(search, leftResult);
-    // Ugh: searchAll clears the list!
-    res |= rhs->searchAll(search, result);
-    for (it = leftResult.begin(); it != leftResult.end(); it++)
-        result.push_back(*it);
-    return res;
+// The matches in the right hand side come first
+bool Assign::searchEach(const Exp &search, SearchCallback &cb) {
+    return rhs->searchEach(search, cb) && lhs->searchEach(search, cb);
 }
 // FIXME: is this the right semantics for searching a phi statement, disregarding the RHS?
-bool PhiAssign::searchAll(const Exp &search, std::list<Exp *> &result) { return lhs->searchAll(search, result); }
-bool ImplicitAssign::searchAll(const Exp &search, std::list<Exp *> &result) {
-    return lhs->searchAll(search, result);
-}
+bool PhiAssign::searchEach(const Exp &search, SearchCallback &cb) { return lhs->searchEach(search, cb); }
+bool ImplicitAssign::searchEach(const Exp &search, SearchCallback &cb) { return lhs->searchEach(search, cb); }
 
 bool Assign::searchAndReplace(const Exp &search, Exp *replace, bool /*cc*/) {
     bool chl, chr, chg = false;
@@ -4638,8 +4660,9 @@ Exp *CallStatement::bypassRef(RefExp * r, bool &ch) {
         return r;                // Can't bypass, since nothing proven
     Exp *to = localiseExp(base); // e.g. r28{17}
     assert(to);
-    proven = proven->clone();                         // Don't modify the expressions in destProc->proven!
-    proven = proven->searchReplaceAll(*base, to, ch); // e.g. r28{17} + 4
+    // Don't modify the expressions in destProc->proven! substitute() leaves proven alone and only copies the path to
+    // each match; the one clone then gives the caller a private copy it may simplify
+    proven = proven->substitute(*base, to, ch)->clone(); // e.g. r28{17} + 4
     if (ch)
         LOG_VERBOSE(1) << "bypassRef() replacing " << r << " with " << proven << "\n";
     return proven;
@@ -4703,8 +4726,8 @@ bool ImpRefStatement::search(const Exp &search, Exp *&result) {
     result = nullptr;
     return addressExp->search(search, result);
 }
-bool ImpRefStatement::searchAll(const Exp &search, std::list<Exp *, std::allocator<Exp *>> &result) {
-    return addressExp->searchAll(search, result);
+bool ImpRefStatement::searchEach(const Exp &search, SearchCallback &cb) {
+    return addressExp->searchEach(search, cb);
 }
 bool ImpRefStatement::searchAndReplace(const Exp &search, Exp *replace, bool /*cc*/) {
     bool change;
@@ -15,10 +15,14 @@
 #include "log.h"
 #include "boomerang.h"
 #include "basicblock.h"
+#include "managed.h"
+#include "statement.h"
+#include "rtl.h"
 
 #include <QDir>
 #include <QProcessEnvironment>
 #include <QDebug>
+#include <algorithm>
 
 #define FRONTIER_PENTIUM baseDir.absoluteFilePath("tests/inputs/pentium/frontier")
 #define SEMI_PENTIUM baseDir.absoluteFilePath("tests/inputs/pentium/semi")
@@ -87,10 +91,8 @@ void CfgTest::testDominators() {
     expected << FRONTIER_THIRTEEN << " " << FRONTIER_FOUR << " " << FRONTIER_TWELVE << " " << FRONTIER_FIVE
              << " ";
     int n5 = df->pbbToNode(bb);
-    std::set<int>::iterator ii;
-    std::set<int> &DFset = df->getDF(n5);
-    for (ii = DFset.begin(); ii != DFset.end(); ii++)
-        actual << df->nodeToBB(*ii)->getLowAddr() << " ";
+    for (int n : df->getDF(n5))
+        actual << df->nodeToBB(n)->getLowAddr() << " ";
     QCOMPARE(actual_st,expect_st);
 
     pBF->deleteLater();
@@ -151,14 +153,63 @@ void CfgTest::testSemiDominators() {
     QTextStream expected(&expected_st), actual(&actual_st);
     // expected << std::hex << SEMI_M << " " << SEMI_B << " ";
     expected << SEMI_B << " " << SEMI_M << " ";
-    std::set<int>::iterator ii;
-    std::set<int> &DFset = df->getDF(nL);
-    for (ii = DFset.begin(); ii != DFset.end(); ii++)
-        actual << df->nodeToBB(*ii)->getLowAddr() << " ";
+    for (int n : df->getDF(nL))
+        actual << df->nodeToBB(n)->getLowAddr() << " ";
     QCOMPARE(actual_st,expected_st);
     delete pFE;
 }
 
+/***************************************************************************/ /**
+  * \fn        CfgTest::testDominatorTree
+  * OVERVIEW:        Check the dominator tree and frontiers against their definitions
+  ******************************************************************************/
+void CfgTest::testDominatorTree() {
+    BinaryFileFactory bff;
+    QObject *pBF = bff.Load(FRONTIER_PENTIUM);
+    QVERIFY(pBF != 0);
+    Prog *prog = new Prog(FRONTIER_PENTIUM);
+    FrontEnd *pFE = new PentiumFrontEnd(pBF, prog, &bff);
+    Type::clearNamedTypes();
+    prog->setFrontEnd(pFE);
+    pFE->decode(prog);
+
+    Module *m = *prog->begin();
+    QVERIFY(m!=nullptr);
+    QVERIFY(m->size()>0);
+
+    UserProc *pProc = (UserProc *)*(m->begin());
+    Cfg *cfg = pProc->getCFG();
+    DataFlow *df = pProc->getDataFlow();
+    df->dominators(cfg);
+
+    int numBB = cfg->getNumBBs();
+    for (int n = 1; n < numBB; n++) {
+        int d = df->getIdom(n);
+        QVERIFY(d != -1); // Every BB of this program is reachable
+        QVERIFY(df->doesDominate(0, n));
+        QVERIFY(df->doesDominate(d, n));
+        QVERIFY(!df->doesDominate(n, d));
+        QVERIFY(!df->doesDominate(n, n));
+        DataFlow::NodeRange children = df->getDomChildren(d);
+        QVERIFY(std::find(children.begin(), children.end(), n) != children.end());
+    }
+    // y is in DF(n) iff n dominates a predecessor of y (or is one) but does not strictly dominate y
+    for (int n = 0; n < numBB; n++) {
+        for (int y = 0; y < numBB; y++) {
+            bool inFrontier = false;
+            for (BasicBlock *pred : df->nodeToBB(y)->getInEdges()) {
+                int p = df->pbbToNode(pred);
+                if (p == n || df->doesDominate(n, p))
+                    inFrontier = !df->doesDominate(n, y);
+            }
+            DataFlow::NodeRange DFn = df->getDF(n);
+            QCOMPARE(std::find(DFn.begin(), DFn.end(), y) != DFn.end(), inFrontier);
+        }
+    }
+    pBF->deleteLater();
+    delete pFE;
+}
+
 /***************************************************************************/ /**
   * \fn        CfgTest::testPlacePhi
   * OVERVIEW:        Test the placing of phi functions
@@ -201,6 +252,110 @@ void CfgTest::testPlacePhi() {
     delete pFE;
 }
 
+//! A diamond: BB 0 (r24 := 1, r25 := 5) branches to BB 1 (r24 := 2, r25 := 6) and BB 2 (r26 := 0), which both go to
+//! BB 3 (r24 := 3, r26 := r25). Only r25 is live at the start of BB 3
+static UserProc *makeDiamond() {
+    UserProc *proc = new UserProc(nullptr, "diamond", ADDRESS::g(0x1000));
+    Cfg *cfg = proc->getCFG();
+    std::vector<std::vector<Instruction *>> stmts = {
+        {new Assign(Location::regOf(24), new Const(1)), new Assign(Location::regOf(25), new Const(5))},
+        {new Assign(Location::regOf(24), new Const(2)), new Assign(Location::regOf(25), new Const(6))},
+        {new Assign(Location::regOf(26), new Const(0))},
+        {new Assign(Location::regOf(24), new Const(3)), new Assign(Location::regOf(26), Location::regOf(25))}};
+    static const BBTYPE types[] = {BBTYPE::TWOWAY, BBTYPE::FALL, BBTYPE::FALL, BBTYPE::RET};
+    static const int numOut[] = {2, 1, 1, 0};
+    std::vector<BasicBlock *> bbs;
+    for (size_t i = 0; i < stmts.size(); i++) {
+        RTL *rtl = new RTL(ADDRESS::g(0x1000 + 4 * i));
+        for (Instruction *s : stmts[i]) {
+            s->setProc(proc);
+            rtl->appendStmt(s);
+        }
+        std::list<RTL *> *rtls = new std::list<RTL *>;
+        rtls->push_back(rtl);
+        bbs.push_back(cfg->newBB(rtls, types[i], numOut[i]));
+    }
+    cfg->addOutEdge(bbs[0], bbs[1]);
+    cfg->addOutEdge(bbs[0], bbs[2]);
+    cfg->addOutEdge(bbs[1], bbs[3]);
+    cfg->addOutEdge(bbs[2], bbs[3]);
+    cfg->setEntryBB(bbs[0]);
+    return proc;
+}
+
+//! The BBs where phi functions for e were placed, as text
+static QString phiBBs(DataFlow *df, Exp *e) {
+    QString res;
+    QTextStream os(&res);
+    for (int n : df->getA_phi(e))
+        os << n << " ";
+    return res;
+}
+
+/***************************************************************************/ /**
+  * \fn        CfgTest::testPlacePhiPruned
+  * OVERVIEW:        Test that pruned phi placement leaves out exactly the phi functions for dead locations, and places
+  *                  a subset of the minimal phi functions on a real program
+  ******************************************************************************/
+void CfgTest::testPlacePhiPruned() {
+    Exp *r24 = Location::regOf(24), *r25 = Location::regOf(25), *r26 = Location::regOf(26);
+    UserProc *minimal = makeDiamond();
+    DataFlow *df = minimal->getDataFlow();
+    df->dominators(minimal->getCFG());
+    df->placePhiFunctions(minimal);
+    QCOMPARE(phiBBs(df, r24), QString("3 "));
+    QCOMPARE(phiBBs(df, r25), QString("3 "));
+    QCOMPARE(phiBBs(df, r26), QString("3 "));
+    QCOMPARE(df->getPhiStats().Placed, (uint64_t)3);
+
+    UserProc *pruned = makeDiamond();
+    df = pruned->getDataFlow();
+    df->dominators(pruned->getCFG());
+    Boomerang::get()->prunedPhis = true;
+    df->placePhiFunctions(pruned);
+    Boomerang::get()->prunedPhis = false;
+    QCOMPARE(phiBBs(df, r24), QString("")); // Defined in BB 3 before any use
+    QCOMPARE(phiBBs(df, r25), QString("3 "));
+    QCOMPARE(phiBBs(df, r26), QString("")); // Only defined in BB 3
+    QCOMPARE(df->getPhiStats().Placed, (uint64_t)1);
+    QCOMPARE(df->getPhiStats().Pruned, (uint64_t)2);
+    delete minimal;
+    delete pruned;
+
+    BinaryFileFactory bff;
+    QObject *pBF = bff.Load(FRONTIER_PENTIUM);
+    QVERIFY(pBF != 0);
+    Prog *prog = new Prog(FRONTIER_PENTIUM);
+    FrontEnd *pFE = new PentiumFrontEnd(pBF, prog, &bff);
+    Type::clearNamedTypes();
+    prog->setFrontEnd(pFE);
+    pFE->decode(prog);
+
+    Module *m = *prog->begin();
+    QVERIFY(m!=nullptr);
+    QVERIFY(m->size()>0);
+
+    UserProc *pProc = (UserProc *)(*m->begin());
+    Cfg *cfg = pProc->getCFG();
+
+    cfg->sortByAddress();
+    prog->finishDecode();
+    df = pProc->getDataFlow();
+    df->dominators(cfg);
+    Boomerang::get()->prunedPhis = true;
+    df->placePhiFunctions(pProc);
+    Boomerang::get()->prunedPhis = false;
+
+    // x is live at some of the join points {7 8 10 15 20 21} where minimal SSA places its phis, and only there
+    Exp *e = new Unary(opMemOf, new Binary(opMinus, Location::regOf(29), new Const(4)));
+    std::set<int> all = {7, 8, 10, 15, 20, 21};
+    std::set<int> &A_phi = df->getA_phi(e);
+    QVERIFY(!A_phi.empty());
+    QVERIFY(std::includes(all.begin(), all.end(), A_phi.begin(), A_phi.end()));
+    delete e;
+    delete pFE;
+}
+
 /***************************************************************************/ /**
   * \fn        CfgTest::testPlacePhi2
   * OVERVIEW:        Test a case where a phi function is not needed
@@ -318,4 +473,316 @@ void CfgTest::testRenameVars() {
 
     delete pFE;
 }
+
+/***************************************************************************/ /**
+  * \fn        CfgTest::testUpdateBlockVars
+  * OVERVIEW:        Test that updating the renaming subscripts a new use as renaming everything would
+  ******************************************************************************/
+void CfgTest::testUpdateBlockVars() {
+    BinaryFileFactory bff;
+    QObject *pBF = bff.Load(FRONTIER_PENTIUM);
+    QVERIFY(pBF != 0);
+    Prog *prog = new Prog(FRONTIER_PENTIUM);
+    FrontEnd *pFE = new PentiumFrontEnd(pBF, prog, &bff);
+    Type::clearNamedTypes();
+    prog->setFrontEnd(pFE);
+    pFE->decode(prog);
+
+    Module *m = *prog->begin();
+    QVERIFY(m!=nullptr);
+    QVERIFY(m->size()>0);
+
+    UserProc *pProc = (UserProc *)(*m->begin());
+    Cfg *cfg = pProc->getCFG();
+    DataFlow *df = pProc->getDataFlow();
+    prog->finishDecode();
+
+    bool changed = true;
+    QVERIFY(!df->updateBlockVars(pProc, changed)); // Nothing has been renamed yet
+    df->dominators(cfg);
+    df->placePhiFunctions(pProc);
+    pProc->numberStatements();
+    df->renameBlockVars(pProc, 0, true);
+    QVERIFY(df->updateBlockVars(pProc, changed));
+    QVERIFY(!changed);
+
+    // Give the last assignment a new use of esp, as propagation might
+    StatementList stmts;
+    pProc->getStatements(stmts);
+    Assign *last = nullptr;
+    for (Instruction *s : stmts) {
+        if (s->isAssign())
+            last = (Assign *)s;
+    }
+    QVERIFY(last);
+    last->setRight(Location::regOf(28));
+    QVERIFY(df->updateBlockVars(pProc, changed));
+    QVERIFY(changed);
+    QString updated_st;
+    QTextStream updated(&updated_st);
+    updated << last;
+
+    last->setRight(Location::regOf(28));
+    df->renameBlockVars(pProc, 0, true);
+    QString renamed_st;
+    QTextStream renamed(&renamed_st);
+    renamed << last;
+    QCOMPARE(updated_st, renamed_st);
+
+    // A new definition needs a full renaming
+    last->setLeft(Location::regOf(last->getLeft()->isRegN(27) ? 26 : 27));
+    QVERIFY(!df->updateBlockVars(pProc, changed));
+    pBF->deleteLater();
+    delete pFE;
+}
+
+/***************************************************************************/ /**
+  * \fn        CfgTest::testDeepCopy
+  * OVERVIEW:        Test that Cfg::deepCopyFrom copies the BBs, their edges and RTLs, sharing nothing
+  ******************************************************************************/
+void CfgTest::testDeepCopy() {
+    BinaryFileFactory bff;
+    QObject *pBF = bff.Load(FRONTIER_PENTIUM);
+    QVERIFY(pBF != 0);
+    Prog *prog = new Prog(FRONTIER_PENTIUM);
+    FrontEnd *pFE = new PentiumFrontEnd(pBF, prog, &bff);
+    Type::clearNamedTypes();
+    prog->setFrontEnd(pFE);
+    pFE->decode(prog);
+
+    Module *m = *prog->begin();
+    QVERIFY(m != nullptr);
+    QVERIFY(m->size() > 0);
+    UserProc *pProc = (UserProc *)*(m->begin());
+    Cfg *cfg = pProc->getCFG();
+
+    Cfg copy;
+    copy.setProc(pProc);
+    copy.deepCopyFrom(*cfg);
+    QCOMPARE(copy.getNumBBs(), cfg->getNumBBs());
+
+    QString orig_st, copy_st;
+    QTextStream orig_os(&orig_st), copy_os(&copy_st);
+    cfg->print(orig_os);
+    copy.print(copy_os);
+    QCOMPARE(copy_st, orig_st);
+
+    std::set<BasicBlock *> origBBs(cfg->begin(), cfg->end());
+    for (BasicBlock *bb : copy) {
+        QVERIFY(origBBs.count(bb) == 0);
+        for (BasicBlock *succ : bb->getOutEdges())
+            QVERIFY(succ == nullptr || origBBs.count(succ) == 0);
+        for (BasicBlock *pred : bb->getInEdges())
+            QVERIFY(origBBs.count(pred) == 0);
+        for (BasicBlock *origBB : origBBs) {
+            if (origBB->getLowAddr() == bb->getLowAddr() && !origBB->getRTLs()->empty()) {
+                QVERIFY(bb->getRTLs() != origBB->getRTLs());
+                QVERIFY(bb->getRTLs()->front() != origBB->getRTLs()->front());
+            }
+        }
+    }
+    pBF->deleteLater();
+    delete pFE;
+}
+
+/***************************************************************************/ /**
+  * \fn        CfgTest::testBitSets
+  * OVERVIEW:        Test BitSet operations, and conversion of statement and location sets to and from BitSets
+  ******************************************************************************/
+void CfgTest::testBitSets() {
+    BitSet a, b;
+    a.insert(1);
+    a.insert(64);
+    a.insert(200);
+    b.insert(64);
+    QCOMPARE(a.size(), (size_t)3);
+    QVERIFY(b.isSubSetOf(a));
+    QVERIFY(!a.isSubSetOf(b));
+    QVERIFY(!a.makeUnion(b)); // No change
+    QVERIFY(b.makeUnion(a));
+    QVERIFY(a == b);
+    QVERIFY(b.makeDiff(a));
+    QVERIFY(b.empty());
+    b.insert(200);
+    b.insert(300);
+    QVERIFY(a.makeIsect(b));
+    QCOMPARE(a.size(), (size_t)1);
+    QVERIFY(a.exists(200) && !a.exists(1) && !a.exists(300));
+    std::vector<size_t> elems;
+    b.forEach([&elems](size_t i) { elems.push_back(i); });
+    QVERIFY(elems == std::vector<size_t>({200, 300}));
+
+    // Statement sets, by number
+    Assign s1(Location::regOf(8), new Const(1)), s2(Location::regOf(9), new Const(2));
+    s1.setNumber(1);
+    s2.setNumber(2);
+    InstructionSet ss;
+    ss.insert(&s1);
+    ss.insert(&s2);
+    BitSet bits;
+    QVERIFY(ss.toBits(bits));
+    QVERIFY(bits.exists(1) && bits.exists(2) && bits.size() == 2);
+    std::vector<Instruction *> byNumber{nullptr, &s1, &s2};
+    InstructionSet ss2;
+    ss2.fromBits(bits, byNumber);
+    QVERIFY(ss == ss2);
+    ImplicitAssign imp(Location::regOf(10));
+    ss.insert(&imp); // Unnumbered
+    QVERIFY(!ss.toBits(bits));
+
+    // Location sets; equal locations get the same number
+    LocationNumbering numbering;
+    LocationSet ls;
+    ls.insert(Location::regOf(8));
+    ls.insert(Location::memOf(Location::regOf(28)));
+    numbering.toBits(ls, bits);
+    QCOMPARE(numbering.size(), (size_t)2);
+    Exp *r8 = Location::regOf(8);
+    QVERIFY(numbering.find(r8) >= 0 && bits.exists(numbering.find(r8)));
+    QCOMPARE(numbering.number(r8), (size_t)numbering.find(r8));
+    QCOMPARE(numbering.size(), (size_t)2);
+    LocationSet ls2;
+    numbering.toLocationSet(bits, ls2);
+    QVERIFY(ls == ls2);
+}
+
+/***************************************************************************/ /**
+  * \fn        CfgTest::testInterferenceGraph
+  * OVERVIEW:        Test that an InterferenceGraph has the same connections, in the same order, as a ConnectionGraph
+  ******************************************************************************/
+void CfgTest::testInterferenceGraph() {
+    Assign s1(Location::regOf(8), new Const(1));
+    Assign s2(Location::regOf(8), new Const(2));
+    Assign s3(Location::regOf(9), new Const(3));
+    Exp *r8a = RefExp::get(Location::regOf(8), &s1);
+    Exp *r8b = RefExp::get(Location::regOf(8), &s2);
+    Exp *r9 = RefExp::get(Location::regOf(9), &s3);
+    Exp *r10 = RefExp::get(Location::regOf(10), nullptr);
+    std::pair<Exp *, Exp *> connections[] = {{r8b, r8a}, {r9, r10}, {r8a, r9}, {r10, r8b}};
+    ConnectionGraph cg;
+    InterferenceGraph ig;
+    for (auto &c : connections) {
+        cg.connect(c.first, c.second);
+        ig.connect(c.first, c.second);
+    }
+    std::vector<std::pair<Exp *, Exp *>> expected(cg.begin(), cg.end()), edges;
+    ig.forEachEdge([&edges](Exp *a, Exp *b) { edges.emplace_back(a, b); });
+    QCOMPARE(edges.size(), expected.size());
+    for (size_t i = 0; i < edges.size(); i++) {
+        QVERIFY(*edges[i].first == *expected[i].first);
+        QVERIFY(*edges[i].second == *expected[i].second);
+    }
+    for (Exp *a : {r8a, r8b, r9, r10})
+        for (Exp *b : {r8a, r8b, r9, r10})
+            QCOMPARE(ig.isConnected(a, *b), cg.isConnected(a, *b));
+}
+
+// Decode the first proc of a test program, put it in SSA form and propagate, so that some live ranges overlap
+static UserProc *decodeToSSA(const QString &path, BinaryFileFactory &bff, QObject *&pBF, FrontEnd *&pFE) {
+    pBF = bff.Load(path);
+    if (pBF == nullptr)
+        return nullptr;
+    Prog *prog = new Prog(path);
+    pFE = new PentiumFrontEnd(pBF, prog, &bff);
+    Type::clearNamedTypes();
+    prog->setFrontEnd(pFE);
+    pFE->decode(prog);
+    prog->finishDecode();
+    UserProc *pProc = (UserProc *)(*(*prog->begin())->begin());
+    DataFlow *df = pProc->getDataFlow();
+    df->dominators(pProc->getCFG());
+    df->placePhiFunctions(pProc);
+    pProc->numberStatements();
+    df->renameBlockVars(pProc, 0, true);
+    bool convert;
+    pProc->propagateStatements(convert, 1);
+    df->renameBlockVars(pProc, 0, true);
+    return pProc;
+}
+
+// The live locations at the start of each BB, in CFG order
+static QStringList liveIns(Cfg *cfg) {
+    QStringList res;
+    for (BasicBlock *bb : *cfg) {
+        QString live;
+        QTextStream os(&live);
+        for (Exp *e : bb->getLiveIn())
+            os << e << " ";
+        res << live;
+    }
+    return res;
+}
+
+/***************************************************************************/ /**
+  * \fn        CfgTest::testFindInterferences
+  * OVERVIEW:        Test that the bit vector Cfg::findInterferences finds the same interferences, in the same order,
+  *                  and leaves the same live locations, as the LocationSet one, on the same decoded proc
+  ******************************************************************************/
+void CfgTest::testFindInterferences() {
+    BinaryFileFactory bff1, bff2;
+    QObject *pBF1, *pBF2;
+    FrontEnd *pFE1, *pFE2;
+    UserProc *proc1 = decodeToSSA(FRONTIER_PENTIUM, bff1, pBF1, pFE1);
+    UserProc *proc2 = decodeToSSA(FRONTIER_PENTIUM, bff2, pBF2, pFE2);
+    QVERIFY(proc1 && proc2);
+
+    ConnectionGraph cg;
+    proc1->getCFG()->findInterferences(cg);
+    InterferenceGraph ig;
+    proc2->getCFG()->findInterferences(ig);
+
+    QStringList expected, actual;
+    for (auto &c : cg) {
+        QString edge;
+        QTextStream os(&edge);
+        os << c.first << " " << c.second;
+        expected << edge;
+    }
+    ig.forEachEdge([&actual](Exp *a, Exp *b) {
+        QString edge;
+        QTextStream os(&edge);
+        os << a << " " << b;
+        actual << edge;
+    });
+    QCOMPARE(actual, expected);
+    QCOMPARE(liveIns(proc2->getCFG()), liveIns(proc1->getCFG()));
+
+    pBF1->deleteLater();
+    pBF2->deleteLater();
+    delete pFE1;
+    delete pFE2;
+}
+
+/***************************************************************************/ /**
+  * \fn        CfgTest::testDefUseIndex
+  * OVERVIEW:        Test that a DefUseIndex holds each definition and user once, and forgets removed statements
+  ******************************************************************************/
+void CfgTest::testDefUseIndex() {
+    // 1: r8 := 1; 2: r9 := r8{1} + r8{1}; 3: r10 := r8{1} + r9{2}
+    Assign s1(Location::regOf(8), new Const(1));
+    Assign s2(Location::regOf(9), Binary::get(opPlus, RefExp::get(Location::regOf(8), &s1),
+                                              RefExp::get(Location::regOf(8), &s1)));
+    Assign s3(Location::regOf(10), Binary::get(opPlus, RefExp::get(Location::regOf(8), &s1),
+                                               RefExp::get(Location::regOf(9), &s2)));
+    DefUseIndex index;
+    index.addUses(&s2); // Not valid yet, so ignored
+    QCOMPARE(index.numUsers(&s1), (size_t)0);
+    UserProc proc(nullptr, "test", ADDRESS::g(0x1000)); // No statements
+    index.build(&proc);
+    QVERIFY(index.isValid());
+    index.addUses(&s2);
+    index.addUses(&s3);
+    QCOMPARE(index.numUsers(&s1), (size_t)2); // Two refs from s2 count once
+    QCOMPARE(index.numUsers(&s2), (size_t)1);
+    QCOMPARE(index.getDefs(&s3).size(), (size_t)2);
+    index.addUses(&s3); // Again; replaces rather than adds
+    QCOMPARE(index.numUsers(&s1), (size_t)2);
+    index.removeStatement(&s2);
+    QCOMPARE(index.numUsers(&s1), (size_t)1);
+    QVERIFY(index.getDefs(&s3) == std::vector<Instruction *>{&s1});
+    index.clear();
+    QVERIFY(!index.isValid());
+    QCOMPARE(index.numUsers(&s1), (size_t)0);
+}
+
 QTEST_MAIN(CfgTest)
@@ -9,7 +9,15 @@ class CfgTest : public QObject {
     void initTestCase();
     void testDominators();
     void testSemiDominators();
+    void testDominatorTree();
     void testPlacePhi();
+    void testPlacePhiPruned();
     void testPlacePhi2();
     void testRenameVars();
+    void testUpdateBlockVars();
+    void testBitSets();
+    void testInterferenceGraph();
+    void testFindInterferences();
+    void testDefUseIndex();
+    void testDeepCopy();
 };
@@ -0,0 +1,175 @@
+/***************************************************************************/ /**
+  * \file       ExpressionTest.cpp
+  * OVERVIEW:   Provides the implementation for the ExpressionTest class, which tests the Exp and derived classes.
+  *             Unlike ExpTest, which is not built, this is a QtTest fixture that is run with the other tests
+  ******************************************************************************/
+#include "ExpressionTest.h"
+
+#include "exp.h"
+#include "exphelp.h"
+
+/***************************************************************************/ /**
+  * \fn        ExpressionTest::testIntern
+  * OVERVIEW:  Test the hash-consing of expressions by ExpInterner
+  ******************************************************************************/
+void ExpressionTest::testIntern() {
+    ExpInterner in;
+    // m[r[28] - 4], twice
+    Exp *e1 = Location::memOf(new Binary(opMinus, Location::regOf(28), new Const(4)));
+    Exp *e2 = Location::memOf(new Binary(opMinus, Location::regOf(28), new Const(4)));
+    const Exp *c1 = in.intern(e1);
+    const Exp *c2 = in.intern(e2);
+    QVERIFY(c1 != nullptr);
+    QVERIFY(c1 == c2);
+    QVERIFY(*c1 == *e1);
+    QVERIFY(c1 != e1);
+    // m, -, r, 28 and 4
+    QCOMPARE((int)in.size(), 5);
+    // Subexpressions are canonical too
+    QVERIFY(in.intern(e1->getSubExp1()->getSubExp1()) == c1->getSubExp1()->getSubExp1());
+    QVERIFY(in.isCanonical(c1->getSubExp1()));
+    QVERIFY(in.intern(c1) == c1);
+    // Different structures get different nodes
+    Exp *e3 = Location::memOf(new Binary(opMinus, Location::regOf(28), new Const(8)));
+    QVERIFY(in.intern(e3) != c1);
+    Const c99(99);
+    Exp *r2 = Location::regOf(2);
+    QVERIFY(in.intern(&c99) != in.intern(r2));
+    // Not internable: subscripts and wildcards, also inside other expressions
+    RefExp ref(Location::regOf(28), nullptr);
+    QVERIFY(in.intern(&ref) == nullptr);
+    Binary withRef(opPlus, ref.clone(), new Const(1));
+    QVERIFY(!ExpInterner::isInternable(&withRef));
+    QVERIFY(in.intern(&withRef) == nullptr);
+    Terminal wild(opWild);
+    QVERIFY(in.intern(&wild) == nullptr);
+    // The order is consistent
+    lessInterned lessI(&in);
+    const Exp *c3 = in.intern(e3);
+    QVERIFY(lessI(c1, c3) != lessI(c3, c1));
+    QVERIFY(!lessI(c1, c1));
+    delete e1;
+    delete e2;
+    delete e3;
+    delete r2;
+}
+
+/***************************************************************************/ /**
+  * \fn        ExpressionTest::testSimplifyMarked
+  * OVERVIEW:  Test that simplified expressions are not simplified again until they change
+  ******************************************************************************/
+void ExpressionTest::testSimplifyMarked() {
+    SimplifyStats stats;
+    SimplifyStats::Scope scope(&stats);
+    // m[r28 + (4 - 4)] + 0
+    Exp *e = new Binary(opPlus, Location::memOf(new Binary(opPlus, Location::regOf(28),
+                                                              new Binary(opMinus, new Const(4), new Const(4)))),
+                        new Const(0));
+    QVERIFY(!e->isSimplifiedTree());
+    e = e->simplify();
+    QString expected("m[r28]");
+    QString actual;
+    QTextStream ost(&actual);
+    ost << e;
+    QCOMPARE(actual, expected);
+    QVERIFY(e->isSimplifiedTree());
+    QCOMPARE(stats.Calls, (uint64_t)1);
+    QVERIFY(stats.Rewrites > 0);
+
+    // Nothing changed: the second call is skipped
+    uint64_t rewrites = stats.Rewrites;
+    QVERIFY(e->simplify() == e);
+    QCOMPARE(stats.Calls, (uint64_t)2);
+    QCOMPARE(stats.Skipped, (uint64_t)1);
+    QCOMPARE(stats.Rewrites, rewrites);
+
+    // Changing a subexpression makes it simplifiable again: m[r28 + 0]
+    e->setSubExp1(new Binary(opPlus, Location::regOf(28), new Const(0)));
+    QVERIFY(!e->isSimplifiedTree());
+    e = e->simplify();
+    QString actual2;
+    QTextStream ost2(&actual2);
+    ost2 << e;
+    QCOMPARE(actual2, expected);
+    QCOMPARE(stats.Skipped, (uint64_t)1);
+
+    // So does changing a constant deep inside: m[r28] to m[r29]
+    ((Const *)e->getSubExp1()->getSubExp1())->setInt(29);
+    QVERIFY(!e->isSimplifiedTree());
+    e = e->simplify();
+    QVERIFY(e->isSimplifiedTree());
+    // Clones are not marked
+    Exp *c = e->clone();
+    QVERIFY(!c->isSimplifiedTree());
+    delete c;
+    delete e;
+
+    // TypedExp::polySimplify simplifies its child: the nested call is not counted again
+    uint64_t calls = stats.Calls;
+    Exp *t = new TypedExp(IntegerType::get(32), new Binary(opPlus, new Const(3), new Const(4)));
+    t = t->simplify();
+    QCOMPARE(stats.Calls, calls + 1);
+    delete t;
+}
+
+/***************************************************************************/ /**
+  * \fn        ExpressionTest::testSearchEach
+  * OVERVIEW:  Test that searchAll keeps a few matches inline, and that searchEach stops when the callback says so
+  ******************************************************************************/
+void ExpressionTest::testSearchEach() {
+    Exp *r2 = Location::regOf(2);
+    // (r2 * 99) + (r8 * 4) + r9
+    Location search(opRegOf, Terminal::get(opWild), nullptr); // r[?]
+    Binary e(opPlus, new Binary(opPlus, new Binary(opMult, r2->clone(), new Const(99)),
+                                new Binary(opMult, Location::regOf(8), new Const(4))),
+             Location::regOf(9));
+    ExpMatches matches;
+    QVERIFY(e.searchAll(search, matches));
+    QVERIFY(matches.size() == 3);
+    QVERIFY(matches.isInline());
+    QVERIFY(*matches[0] == *r2);
+    // Stop at the second match
+    int seen = 0;
+    auto stop = searchWith([&seen](Exp *) { return ++seen < 2; });
+    QVERIFY(!e.searchEach(search, stop));
+    QVERIFY(seen == 2);
+    delete r2;
+}
+
+/***************************************************************************/ /**
+  * \fn        ExpressionTest::testSubstitute
+  * OVERVIEW:  Test that substitute copies only the path to a change, and leaves the original alone
+  ******************************************************************************/
+void ExpressionTest::testSubstitute() {
+    // m[r28 + 4] + (r24 * 2), replace r28 with r29
+    Exp *left = Location::memOf(Binary::get(opPlus, Location::regOf(28), new Const(4)));
+    Exp *right = Binary::get(opMult, Location::regOf(24), new Const(2));
+    Exp *e = Binary::get(opPlus, left, right);
+    QString before;
+    QTextStream os(&before);
+    os << e;
+    os.flush();
+    Exp *r28 = Location::regOf(28);
+    Exp *r29 = Location::regOf(29);
+    bool change;
+    Exp *res = e->substitute(*r28, r29, change);
+    QVERIFY(change);
+    QVERIFY(res != e);
+    // The original is unchanged
+    QString after;
+    QTextStream os2(&after);
+    os2 << e;
+    os2.flush();
+    QVERIFY(before == after);
+    // Only the path to the change is copied: the untouched right side and the replacement are shared
+    QVERIFY(res->getSubExp2() == right);
+    QVERIFY(res->getSubExp1() != left);
+    QVERIFY(res->getSubExp1()->getSubExp1()->getSubExp1() == r29);
+    QVERIFY(res->getSubExp1()->getSubExp1()->getSubExp2() == left->getSubExp1()->getSubExp2());
+    // No match: no new nodes
+    Exp *r30 = Location::regOf(30);
+    QVERIFY(e->substitute(*r30, r29, change) == e);
+    QVERIFY(!change);
+}
+
+QTEST_MAIN(ExpressionTest)
@@ -0,0 +1,10 @@
+#include <QtTest/QTest>
+
+class ExpressionTest : public QObject {
+    Q_OBJECT
+  private slots:
+    void testIntern();
+    void testSimplifyMarked();
+    void testSearchEach();
+    void testSubstitute();
+};
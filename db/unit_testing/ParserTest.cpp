@@ -5,6 +5,7 @@
   ******************************************************************************/
 #include "ParserTest.h"
 #include "sslparser.h"
+#include "rtl.h"
 #include "log.h"
 #include "boomerang.h"
 
@@ -64,4 +65,29 @@ void ParserTest::testExp() {
     QCOMPARE(res,"   0 " + s);
 }
 
+/***************************************************************************/ /**
+  * \fn        ParserTest::testRegisterIndex
+  * OVERVIEW:        Test that the register and parameter lookup tables agree with the maps read from the SSL file
+  ******************************************************************************/
+void ParserTest::testRegisterIndex() {
+    RTLInstDict d;
+    QVERIFY(d.readSSLFile(SPARC_SSL));
+    QVERIFY(!d.RegMap.empty());
+    for (const std::pair<QString, int> &elem : d.RegMap) {
+        QCOMPARE(d.getRegIdx(qPrintable(elem.first)), elem.second);
+        QCOMPARE(d.RegMap[d.getRegName(elem.second)], elem.second);
+    }
+    for (const std::pair<const int, Register> &elem : d.DetRegMap)
+        QCOMPARE(d.getRegSize(elem.first), elem.second.g_size());
+    QCOMPARE(d.getRegIdx("%nosuchreg"), -1);
+    QCOMPARE(d.getRegSize(10000), 0);
+    QVERIFY(d.getRegName(10000).isNull());
+    for (auto iter = d.DetParamMap.begin(); iter != d.DetParamMap.end(); ++iter)
+        QVERIFY(d.getParam(qPrintable(iter.key())) == &iter.value());
+    QVERIFY(d.getParam("nosuchparam") == nullptr);
+    // A second read must rebuild the tables
+    QVERIFY(d.readSSLFile(SPARC_SSL));
+    QCOMPARE(d.getRegIdx("%g0"), d.RegMap["%g0"]);
+}
+
 QTEST_MAIN(ParserTest)
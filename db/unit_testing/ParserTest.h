@@ -5,5 +5,6 @@ class ParserTest : public QObject {
   private slots:
     void testRead();
     void testExp();
+    void testRegisterIndex();
     void initTestCase();
 };
@@ -16,6 +16,7 @@
 #include "visitor.h"
 #include "log.h"
 #include "boomerang.h"
+#include "binaryir.h"
 
 #include <sstream>
 
@@ -293,4 +294,126 @@ void RtlTest::testSetConscripts() {
     QCOMPARE(actual,expected);
 }
 
+/***************************************************************************/ /**
+  * \fn        RtlTest::testArena
+  * OVERVIEW:        Test allocating statements and expressions from a MemoryArena
+  ******************************************************************************/
+void RtlTest::testArena() {
+    bool oldPlacement = MemoryArena::placementEnabled();
+    MemoryArena arena("test");
+    MemoryArena::setPlacement(true);
+    RTL *r = nullptr;
+    Exp *onHeapExp = nullptr;
+    {
+        ArenaScope scope(&arena);
+        std::list<Instruction *> ls;
+        ls.push_back(new Assign(Location::regOf(8), new Binary(opPlus, Location::regOf(9), new Const(99))));
+        r = new RTL(ADDRESS::g(0x1234), &ls);
+        onHeapExp = onHeap([] { return Location::regOf(10); });
+    }
+    // One Assign, two Locations, three Consts and a Binary; the RTL itself is not arena allocated
+    QCOMPARE(arena.getNumAllocs(), (uint64_t)7);
+    QVERIFY(arena.getBytesReserved() > 0);
+    QString actual;
+    QTextStream os(&actual);
+    r->print(os);
+    QCOMPARE(actual, QString("00001234    0 *v* r8 := r9 + 99\n"));
+    delete r; // No effect on the arena memory
+    delete onHeapExp;
+    MemoryArena::setPlacement(oldPlacement);
+    arena.release();
+    QCOMPARE(arena.getBytesReserved(), (size_t)0);
+    QCOMPARE(arena.getNumAllocs(), (uint64_t)7);
+}
+
+/***************************************************************************/ /**
+  * \fn        RtlTest::testBinaryIR
+  * OVERVIEW:        Test a round trip of RTLs and expressions through BinaryIRWriter and BinaryIRReader
+  ******************************************************************************/
+void RtlTest::testBinaryIR() {
+    Assign *a1 = new Assign(Location::regOf(8), new Binary(opPlus, Location::regOf(9), new Const(99)));
+    a1->setNumber(1);
+    Assign *a2 = new Assign(IntegerType::get(16), new Location(opParam, new Const("x"), nullptr),
+                            new Location(opParam, new Const("y"), nullptr));
+    a2->setNumber(2);
+    Assign *a3 = new Assign(Location::regOf(10),
+                            new Binary(opMinus, new RefExp(Location::regOf(8), a1),
+                                       Location::memOf(new Binary(opPlus, Location::regOf(28), new Const(-4)))));
+    a3->setNumber(3);
+    BranchStatement *br = new BranchStatement;
+    br->setNumber(4);
+    br->setDest(ADDRESS::g(0x1000));
+    br->setCondType(BRANCH_JE);
+    br->setCondExpr(new Binary(opEquals, Location::regOf(10), new Const(0)));
+    std::list<Instruction *> ls{a1, a2, a3, br};
+    RTL *r = new RTL(ADDRESS::g(0x1234), &ls);
+
+    // A subtree shared by two expressions, and a reference to a statement written after it
+    Exp *shared = new Binary(opPlus, Location::regOf(28), new Const(8));
+    Exp *e1 = Location::memOf(shared);
+    Exp *e2 = new Binary(opMult, shared, new Const(2));
+    Assign *a7 = new Assign(Location::regOf(24), new Const(5));
+    a7->setNumber(7);
+    Exp *e3 = new RefExp(Location::regOf(24), a7);
+
+    BinaryIRWriter writer;
+    writer.write(r);
+    writer.write(e1);
+    writer.write(e2);
+    writer.write(e3);
+    writer.write(a7);
+    QVERIFY(writer.isOk());
+
+    BinaryIRReader reader(writer.data().constData(), writer.data().size());
+    RTL *r2 = reader.readRTL();
+    Exp *f1 = reader.readExp();
+    Exp *f2 = reader.readExp();
+    Exp *f3 = reader.readExp();
+    Instruction *b7 = reader.readStatement();
+    reader.resolveDefs();
+    QVERIFY(reader.isOk());
+    QVERIFY(reader.atEnd());
+    QCOMPARE(reader.getNumUnresolved(), (size_t)0);
+
+    QString expected, actual;
+    QTextStream os1(&expected), os2(&actual);
+    r->print(os1);
+    r2->print(os2);
+    QCOMPARE(actual, expected);
+    QCOMPARE(r2->getAddress(), ADDRESS::g(0x1234));
+    // The reference in the third statement is to the first statement read, not the original
+    Assign *third = (Assign *)*std::next(r2->begin(), 2);
+    QVERIFY(((RefExp *)third->getRight()->getSubExp1())->getDef() == r2->front());
+
+    QVERIFY(*f1 == *e1);
+    QVERIFY(*f2 == *e2);
+    QVERIFY(f1->getSubExp1() == f2->getSubExp1());
+    QVERIFY(((RefExp *)f3)->getDef() == b7);
+    QCOMPARE(b7->getNumber(), 7);
+
+    // Truncated input is an error, not a crash
+    BinaryIRReader truncated(writer.data().constData(), writer.data().size() / 2);
+    truncated.readRTL();
+    truncated.readExp();
+    truncated.readExp();
+    truncated.readExp();
+    truncated.readStatement();
+    QVERIFY(!truncated.isOk());
+
+    // So is an operator that is not in the OPER enum
+    BinaryIRWriter opWriter;
+    opWriter.write(e2);
+    QByteArray bad = opWriter.data();
+    unsigned badOp = opNumOf + 1;
+    QByteArray badVarint;
+    badVarint.append(char((badOp & 0x7F) | 0x80));
+    badVarint.append(char(badOp >> 7));
+    bad.replace(1, 1, badVarint); // The byte after the tag of the opMult node
+    BinaryIRReader badReader(bad.constData(), bad.size());
+    QVERIFY(badReader.readExp() == nullptr);
+    QVERIFY(!badReader.isOk());
+    delete r;
+    delete r2;
+}
+
 QTEST_MAIN(RtlTest)
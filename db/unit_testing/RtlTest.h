@@ -6,5 +6,7 @@ class RtlTest : public QObject {
     void testClone();
     void testVisitor();
     void testSetConscripts();
+    void testArena();
+    void testBinaryIR();
     void initTestCase();
 };
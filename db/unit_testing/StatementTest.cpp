@@ -15,6 +15,7 @@
 #include <map>
 #include "StatementTest.h"
 #include "cfg.h"
+#include "basicblock.h"
 #include "rtl.h"
 #include "pentiumfrontend.h"
 #include "boomerang.h"
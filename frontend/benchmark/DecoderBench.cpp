@@ -0,0 +1,249 @@
+/***************************************************************************/ /**
+  * \file       DecoderBench.cpp
+  * OVERVIEW:   Decoder throughput and correctness benchmark. For each supported architecture the code sections of
+  *             the binaries in tests/inputs/<arch> are decoded linearly, and the decoding speed, the number of
+  *             allocations and statements per instruction, and a checksum of the RTL text are reported.
+  *             The checksum only depends on the decoded RTLs, so it can be used to check that a change to the
+  *             decoders is behavior preserving. Each binary is decoded both one instruction at a time
+  *             (decodeInstruction) and in straight-line runs (decodeInstructions); the two must give the same
+  *             checksum.
+  *
+  *             usage: DecoderBench [-b base_dir] [-r repeat_count] [arch ...]
+  ******************************************************************************/
+#include "types.h"
+#include "rtl.h"
+#include "prog.h"
+#include "frontend.h"
+#include "decoder.h"
+#include "BinaryFile.h"
+#include "IBinaryImage.h"
+#include "IBinarySection.h"
+#include "boomerang.h"
+#include "log.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QProcessEnvironment>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+// Allocation counting: every operator new made while decoding is counted
+static bool countAllocs = false;
+static uint64_t numAllocs = 0;
+
+void *operator new(size_t sz) {
+    if (countAllocs)
+        numAllocs++;
+    void *res = malloc(sz ? sz : 1);
+    if (res == nullptr)
+        throw std::bad_alloc();
+    return res;
+}
+void *operator new[](size_t sz) { return operator new(sz); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+struct ArchInfo {
+    const char *name;      //!< Name, and the directory in tests/inputs
+    MACHINE machine;       //!< Machine the loader must report for a binary to be used
+    int minInstructionSize; //!< How far to skip over an invalid instruction
+    int maxInstructionSize; //!< Used to keep runs of decodeInstructions inside the section
+};
+
+static const ArchInfo archs[] = {
+    {"pentium", MACHINE_PENTIUM, 1, 15}, {"sparc", MACHINE_SPARC, 4, 4}, {"ppc", MACHINE_PPC, 4, 4},
+    {"mips", MACHINE_MIPS, 4, 4},        {"st20", MACHINE_ST20, 1, 16},
+};
+
+struct BenchStats {
+    uint64_t numInstructions = 0;
+    uint64_t numInvalid = 0;
+    uint64_t numBytes = 0;
+    uint64_t numStatements = 0;
+    uint64_t numAllocs = 0;
+    qint64 nsecs = 0;
+    uint32_t checksum = 2166136261u; //!< FNV-1a of the printed RTLs
+
+    void add(const BenchStats &o) {
+        numInstructions += o.numInstructions;
+        numInvalid += o.numInvalid;
+        numBytes += o.numBytes;
+        numStatements += o.numStatements;
+        numAllocs += o.numAllocs;
+        nsecs += o.nsecs;
+        checksum = (checksum ^ o.checksum) * 16777619u;
+    }
+};
+
+static void addToChecksum(uint32_t &checksum, const QByteArray &data) {
+    for (char c : data)
+        checksum = (checksum ^ (uint8_t)c) * 16777619u;
+}
+
+/***************************************************************************/ /**
+  * \brief Count one decoded instruction, delete its RTL, and return the address of the next one
+  ******************************************************************************/
+static ADDRESS account(DecodeResult &inst, ADDRESS pc, const ArchInfo &arch, BenchStats &stats, bool withChecksum) {
+    if (!inst.valid || inst.numBytes <= 0) {
+        stats.numInvalid++;
+        delete inst.rtl;
+        return pc + arch.minInstructionSize;
+    }
+    stats.numInstructions++;
+    stats.numBytes += inst.numBytes;
+    if (inst.rtl)
+        stats.numStatements += inst.rtl->size();
+    if (inst.rtl && withChecksum) {
+        QString text;
+        QTextStream os(&text);
+        inst.rtl->print(os);
+        os.flush();
+        addToChecksum(stats.checksum, text.toUtf8());
+    }
+    delete inst.rtl;
+    return pc + inst.numBytes;
+}
+
+/***************************************************************************/ /**
+  * \brief Linearly decode all code sections of the currently loaded image
+  * \param batch - if true, decode straight-line runs with decodeInstructions, as the front end does; otherwise
+  *        decode one instruction at a time with decodeInstruction
+  * \param withChecksum - if true, add the text of the decoded RTLs to the checksum (only done for the first pass,
+  *        so the checksum does not depend on the repeat count)
+  ******************************************************************************/
+static void decodeImage(NJMCDecoder *decoder, const ArchInfo &arch, BenchStats &stats, bool batch,
+                        bool withChecksum) {
+    IBinaryImage *image = Boomerang::get()->getImage();
+    QElapsedTimer timer;
+    DecodeResult results[FrontEnd::DECODE_RUN_SIZE];
+    for (IBinarySection *sect : *image) {
+        if (!sect->isCode() || sect->hostAddr().isZero())
+            continue;
+        ptrdiff_t delta = (sect->hostAddr() - sect->sourceAddr()).m_value;
+        ADDRESS end = sect->sourceAddr() + sect->size();
+        ADDRESS pc = sect->sourceAddr();
+        while (pc + arch.minInstructionSize <= end) {
+            countAllocs = true;
+            uint64_t allocsBefore = numAllocs;
+            if (!batch) {
+                timer.start();
+                DecodeResult &inst = decoder->decodeInstruction(pc, delta);
+                stats.nsecs += timer.nsecsElapsed();
+                countAllocs = false;
+                stats.numAllocs += numAllocs - allocsBefore;
+                pc = account(inst, pc, arch, stats, withChecksum);
+                continue;
+            }
+            // Near the end of the section, shorten the run so it can't read past it
+            int maxCount = std::max(1, std::min((int)FrontEnd::DECODE_RUN_SIZE,
+                                                (int)((end - pc).m_value / arch.maxInstructionSize)));
+            timer.start();
+            int count = decoder->decodeInstructions(pc, delta, results, maxCount);
+            stats.nsecs += timer.nsecsElapsed();
+            countAllocs = false;
+            stats.numAllocs += numAllocs - allocsBefore;
+            for (int i = 0; i < count; i++) {
+                bool skip = !results[i].valid || results[i].numBytes <= 0;
+                pc = account(results[i], pc, arch, stats, withChecksum);
+                if (skip)
+                    break; // The run ends at an invalid instruction; carry on after it as above
+            }
+        }
+    }
+}
+
+static void report(QTextStream &out, const QString &name, const BenchStats &stats) {
+    double secs = stats.nsecs / 1e9;
+    double perInst = stats.numInstructions ? 1.0 / stats.numInstructions : 0;
+    out << qSetFieldWidth(24) << left << name << qSetFieldWidth(0) << right;
+    out << " insts " << stats.numInstructions << " (" << stats.numInvalid << " invalid)";
+    out << " insts/s " << (secs > 0 ? qint64(stats.numInstructions / secs) : 0);
+    out << " bytes/s " << (secs > 0 ? qint64(stats.numBytes / secs) : 0);
+    out << " allocs/inst " << QString::number(stats.numAllocs * perInst, 'f', 2);
+    out << " stmts/inst " << QString::number(stats.numStatements * perInst, 'f', 2);
+    out << " checksum " << QString::number(stats.checksum, 16).rightJustified(8, '0') << "\n";
+    out.flush();
+}
+
+static BenchStats benchArch(QTextStream &out, const QDir &baseDir, const ArchInfo &arch, int repeat, bool batch) {
+    BenchStats total;
+    QDir inputs(baseDir.absoluteFilePath(QString("tests/inputs/") + arch.name));
+    if (!inputs.exists()) {
+        out << arch.name << ": no inputs in " << inputs.path() << "\n";
+        return total;
+    }
+    for (const QString &fname : inputs.entryList(QDir::Files, QDir::Name)) {
+        QString path = inputs.absoluteFilePath(fname);
+        BinaryFileFactory bff;
+        QObject *pBF = bff.Load(path);
+        if (pBF == nullptr)
+            continue;
+        LoaderInterface *iface = qobject_cast<LoaderInterface *>(pBF);
+        if (iface->getMachine() != arch.machine) {
+            bff.UnLoad();
+            continue;
+        }
+        Prog *prog = new Prog(path);
+        FrontEnd *pFE = FrontEnd::instantiate(pBF, prog, &bff);
+        if (pFE == nullptr) {
+            delete prog;
+            bff.UnLoad();
+            continue;
+        }
+        prog->setFrontEnd(pFE);
+        BenchStats stats;
+        for (int i = 0; i < repeat; i++)
+            decodeImage(pFE->getDecoder(), arch, stats, batch, i == 0);
+        report(out, QString("  ") + arch.name + "/" + fname + (batch ? ", batch" : ""), stats);
+        total.add(stats);
+        delete prog; // Also deletes the front end
+        bff.UnLoad();
+    }
+    report(out, QString(arch.name) + (batch ? ", batch" : ""), total);
+    return total;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QString base = QProcessEnvironment::systemEnvironment().value("BOOMERANG_TEST_BASE", "..");
+    int repeat = 1;
+    QStringList selected;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        if (args[i] == "-b" && i + 1 < args.size())
+            base = args[++i];
+        else if (args[i] == "-r" && i + 1 < args.size())
+            repeat = std::max(1, args[++i].toInt());
+        else if (args[i].startsWith("-")) {
+            out << "usage: " << args[0] << " [-b base_dir] [-r repeat_count] [arch ...]\n";
+            return 1;
+        } else
+            selected << args[i];
+    }
+    QDir baseDir(base);
+    Boomerang::get()->setProgPath(baseDir.absolutePath());
+    Boomerang::get()->setPluginPath(baseDir.absoluteFilePath("out"));
+    Boomerang::get()->setLogger(new NullLogger());
+
+    BenchStats total, batchTotal;
+    for (const ArchInfo &arch : archs) {
+        if (!selected.isEmpty() && !selected.contains(arch.name))
+            continue;
+        total.add(benchArch(out, baseDir, arch, repeat, false));
+        batchTotal.add(benchArch(out, baseDir, arch, repeat, true));
+    }
+    report(out, "total", total);
+    report(out, "total, batch", batchTotal);
+    if (batchTotal.checksum != total.checksum) {
+        out << "error: decodeInstructions and decodeInstruction give different RTLs\n";
+        return 1;
+    }
+    return 0;
+}
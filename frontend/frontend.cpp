@@ -126,18 +126,11 @@ FrontEnd::~FrontEnd() {
         pbff->UnLoad(); // Unload the BinaryFile library with dlclose() or FreeLibrary()
 }
 
-QString FrontEnd::getRegName(int idx) const {
-    static QString nullres;
-    for (const std::pair<QString,int> &elem : decoder->getRTLDict().RegMap)
-        if (elem.second == idx)
-            return elem.first;
-    return nullres;
-}
+QString FrontEnd::getRegName(int idx) const { return decoder->getRTLDict().getRegName(idx); }
 
 int FrontEnd::getRegSize(int idx) {
-    if (decoder->getRTLDict().DetRegMap.find(idx) == decoder->getRTLDict().DetRegMap.end())
-        return 32;
-    return decoder->getRTLDict().DetRegMap[idx].g_size();
+    int size = decoder->getRTLDict().getRegSize(idx);
+    return size ? size : 32;
 }
 
 bool FrontEnd::isWin32() { return ldrIface->GetFormat() == LOADFMT_PE; }
@@ -377,6 +370,62 @@ void FrontEnd::decodeFragment(UserProc *proc, ADDRESS a) {
     processProc(a, proc, os, true);
 }
 
+//! The analysed RTL that replaces the last RTL of \a pBB, or nullptr if it is unchanged
+RTL *FrontEnd::analysedReplacement(BasicBlock *pBB) {
+    std::list<RTL *> *rtls = pBB->getRTLs();
+    if (rtls == nullptr || rtls->empty())
+        return nullptr;
+    std::map<ADDRESS, RTL *>::iterator ff = previouslyDecoded.find(rtls->back()->getAddress());
+    if (ff == previouslyDecoded.end() || ff->second == rtls->back())
+        return nullptr;
+    return ff->second;
+}
+
+bool FrontEnd::decodeNewTargets(UserProc *pProc) {
+    Cfg *pCfg = pProc->getCFG();
+    // Check everything first, so the CFG is either fully updated or left alone
+    for (BasicBlock *pBB : *pCfg) {
+        RTL *analysed = analysedReplacement(pBB);
+        if (analysed == nullptr)
+            continue;
+        Instruction *hl = analysed->getHlStmt();
+        if (hl == nullptr || !(hl->isCase() || hl->isCall()))
+            return false; // Don't know how to add this to the CFG
+    }
+    // Note: decoding switch arms appends BBs to the CFG; they are visited too, but already have the right RTLs
+    for (BasicBlock *pBB : *pCfg) {
+        RTL *analysed = analysedReplacement(pBB);
+        if (analysed == nullptr)
+            continue;
+        std::list<RTL *> *rtls = pBB->getRTLs();
+        RTL *pRtl = rtls->back();
+        Instruction *hl = analysed->getHlStmt();
+        Instruction *old = pRtl->getHlStmt();
+        if (old && old->isCall())
+            pCfg->getCalls().erase(static_cast<CallStatement *>(old));
+        rtls->back() = analysed;
+        delete pRtl;
+        if (hl->isCase()) {
+            // Decode the arms of the newly analysed switch statement
+            if (static_cast<CaseStatement *>(hl)->getDest() == nullptr && pBB->getType() == BBTYPE::COMPJUMP)
+                pBB->processSwitch(pProc);
+            continue;
+        }
+        CallStatement *call = static_cast<CallStatement *>(hl);
+        if (!call->isComputed() && pBB->getType() == BBTYPE::COMPCALL)
+            pBB->updateType(BBTYPE::CALL, 1);
+        pCfg->addCall(call);
+        Function *np = call->getDestProc();
+        if (np == nullptr && call->getFixedDest() != NO_ADDRESS)
+            np = pProc->getProg()->setNewProc(call->getFixedDest());
+        if (np != nullptr) {
+            np->setFirstCaller(pProc);
+            pProc->addCallee(np);
+        }
+    }
+    return true;
+}
+
 DecodeResult &FrontEnd::decodeInstruction(ADDRESS pc) {
     if (!Image || Image->getSectionInfoByAddr(pc) == nullptr) {
         LOG << "ERROR: attempted to decode outside any known section " << pc << "\n";
@@ -390,6 +439,44 @@ DecodeResult &FrontEnd::decodeInstruction(ADDRESS pc) {
     return decoder->decodeInstruction(pc, host_native_diff);
 }
 
+/***************************************************************************/ /**
+  * \brief   Decode a straight-line run of instructions starting at pc, stopping after the first control transfer
+  *          instruction, or at the end of the section containing pc.
+  * \param   pc - native address of the first instruction
+  * \param   results - caller provided array of at least maxCount entries
+  * \param   maxCount - maximum number of instructions to decode
+  * \returns the number of entries of results that were filled in (at least one)
+  ******************************************************************************/
+int FrontEnd::decodeInstructions(ADDRESS pc, DecodeResult *results, int maxCount) {
+    const IBinarySection *pSect = Image ? Image->getSectionInfoByAddr(pc) : nullptr;
+    if (pSect == nullptr) {
+        results[0] = FrontEnd::decodeInstruction(pc); // Logs the error, returns an invalid result
+        return 1;
+    }
+    ptrdiff_t host_native_diff = (pSect->hostAddr() - pSect->sourceAddr()).m_value;
+    int count = decoder->decodeInstructions(pc, host_native_diff, results, maxCount);
+    // Don't let the run wander past the end of the section; anything after that is decoded (and reported) by itself
+    ADDRESS sectEnd = pSect->sourceAddr() + pSect->size();
+    for (int i = 1; i < count; i++) {
+        pc += results[i - 1].numBytes;
+        if (pc >= sectEnd) {
+            discardDecoded(results + i, count - i);
+            return i;
+        }
+    }
+    return count;
+}
+
+/***************************************************************************/ /**
+  * \brief   Free the RTLs of decoded, but unused, instructions
+  ******************************************************************************/
+void FrontEnd::discardDecoded(DecodeResult *results, int count) {
+    for (int i = 0; i < count; i++) {
+        delete results[i].rtl;
+        results[i].rtl = nullptr;
+    }
+}
+
 /***************************************************************************/ /**
   *
   * \brief       Read the library signatures from a file
@@ -497,6 +584,8 @@ bool FrontEnd::refersToImportedFunction(Exp *pDest)
   ******************************************************************************/
 bool FrontEnd::processProc(ADDRESS uAddr, UserProc *pProc, QTextStream &/*os*/, bool /*frag*/ /* = false */,
                            bool spec /* = false */) {
+    ArenaScope arenaScope(pProc->getArena());
+    SimplifyStats::Scope simplifyScope(&pProc->getSimplifyStats());
     BasicBlock *pBB; // Pointer to the current basic block
 
     // just in case you missed it
@@ -528,6 +617,11 @@ bool FrontEnd::processProc(ADDRESS uAddr, UserProc *pProc, QTextStream &/*os*/,
     int nTotalBytes = 0;
     ADDRESS startAddr = uAddr;
     ADDRESS lastAddr = uAddr;
+
+    // Instructions are decoded a straight-line run at a time; decodedRun[runPos] is the instruction at runAddr
+    DecodeResult decodedRun[DECODE_RUN_SIZE];
+    int runPos = 0, runLen = 0;
+    ADDRESS runAddr = NO_ADDRESS;
     while ((uAddr = targetQueue.nextAddress(*pCfg)) != NO_ADDRESS) {
         // The list of RTLs for the current basic block
         std::list<RTL *> *BB_rtls = new std::list<RTL *>();
@@ -541,15 +635,23 @@ bool FrontEnd::processProc(ADDRESS uAddr, UserProc *pProc, QTextStream &/*os*/,
             if (Boomerang::get()->traceDecoder)
                 LOG << "*" << uAddr << "\t";
 
-            // Decode the inst at uAddr.
-            inst = decodeInstruction(uAddr);
+            // Decode the inst at uAddr, unless it is the next one of the current run.
+            if (runPos == runLen || runAddr != uAddr) {
+                discardDecoded(decodedRun + runPos, runLen - runPos);
+                runLen = decodeInstructions(uAddr, decodedRun, DECODE_RUN_SIZE);
+                runPos = 0;
+            }
+            inst = decodedRun[runPos++];
+            runAddr = uAddr + inst.numBytes;
             if(!inst.valid || inst.rtl->empty()) {
                 qDebug() << "Valid but undecoded instruction at " << QString::number(uAddr.m_value,16);
             }
 
             // If invalid and we are speculating, just exit
-            if (spec && !inst.valid)
+            if (spec && !inst.valid) {
+                discardDecoded(decodedRun + runPos, runLen - runPos);
                 return false;
+            }
 
             // Need to construct a new list of RTLs if a basic block has just been finished but decoding is
             // continuing from its lexical successor
@@ -608,7 +710,7 @@ bool FrontEnd::processProc(ADDRESS uAddr, UserProc *pProc, QTextStream &/*os*/,
             ADDRESS uDest;
 
             // For each Statement in the RTL
-            std::list<Instruction *> sl = *(std::list<Instruction *> *)pRtl;
+            std::list<Instruction *> sl(pRtl->begin(), pRtl->end());
             // Make a copy (!) of the list. This is needed temporarily to work around the following problem.
             // We are currently iterating an RTL, which could be a return instruction. The RTL is passed to
             // createReturnBlock; if this is not the first return statement, it will get cleared, and this will
@@ -995,6 +1097,7 @@ bool FrontEnd::processProc(ADDRESS uAddr, UserProc *pProc, QTextStream &/*os*/,
         sequentialDecode = true;
 
     } // while nextAddress() != NO_ADDRESS
+    discardDecoded(decodedRun + runPos, runLen - runPos);
 
     // ProgWatcher *w = prog->getWatcher();
     // if (w)
@@ -17,6 +17,7 @@
 #include "rtl.h"
 #include "exp.h"
 #include "register.h"
+#include "statement.h"
 #include "cfg.h"
 #include "proc.h"
 #include "prog.h"
@@ -87,6 +88,27 @@ std::list<Instruction *> *NJMCDecoder::instantiate(ADDRESS pc, const char *name,
     return instance;
 }
 
+/***************************************************************************/ /**
+  * \brief   Decode a straight-line run of instructions, one decodeInstruction call at a time.
+  *          Decoders that care about the per instruction overhead override this.
+  * \param   pc - native address of the first instruction
+  * \param   delta - difference between host and native addresses
+  * \param   results - caller provided array of at least maxCount entries
+  * \param   maxCount - maximum number of instructions to decode
+  * \returns the number of entries of results that were filled in
+  ******************************************************************************/
+int NJMCDecoder::decodeInstructions(ADDRESS pc, ptrdiff_t delta, DecodeResult *results, int maxCount) {
+    int count = 0;
+    while (count < maxCount) {
+        DecodeResult &res(results[count++]);
+        res = decodeInstruction(pc, delta);
+        if (res.endsRun())
+            break;
+        pc += res.numBytes;
+    }
+    return count;
+}
+
 /***************************************************************************/ /**
   * \brief   Similarly to NJMCDecoder::instantiate, given a parameter name and a list of Exp*'s representing
   * sub-parameters, return a fully substituted Exp for the whole expression
@@ -96,12 +118,12 @@ std::list<Instruction *> *NJMCDecoder::instantiate(ADDRESS pc, const char *name,
   * \returns an instantiated list of Exps
   ******************************************************************************/
 Exp *NJMCDecoder::instantiateNamedParam(char *name, ...) {
-    if (RTLDict.ParamSet.find(name) == RTLDict.ParamSet.end()) {
+    ParamEntry *pent = RTLDict.getParam(name);
+    if (pent == nullptr) {
         LOG_STREAM() << "No entry for named parameter '" << name << "'\n";
         return nullptr;
     }
-    assert(RTLDict.DetParamMap.find(name) != RTLDict.DetParamMap.end());
-    ParamEntry &ent = RTLDict.DetParamMap[name];
+    ParamEntry &ent = *pent;
     if (ent.kind != PARAM_ASGN && ent.kind != PARAM_LAMBDA) {
         LOG_STREAM() << "Attempt to instantiate expressionless parameter '" << name << "'\n";
         return nullptr;
@@ -133,11 +155,12 @@ Exp *NJMCDecoder::instantiateNamedParam(char *name, ...) {
   * \returns an instantiated list of Exps
   ******************************************************************************/
 void NJMCDecoder::substituteCallArgs(char *name, Exp *&exp, ...) {
-    if (RTLDict.ParamSet.find(name) == RTLDict.ParamSet.end()) {
+    ParamEntry *pent = RTLDict.getParam(name);
+    if (pent == nullptr) {
         LOG_STREAM() << "No entry for named parameter '" << name << "'\n";
         return;
     }
-    ParamEntry &ent = RTLDict.DetParamMap[name];
+    ParamEntry &ent = *pent;
     /*if (ent.kind != PARAM_ASGN && ent.kind != PARAM_LAMBDA) {
                 LOG_STREAM() << "Attempt to instantiate expressionless parameter '" << name << "'\n";
                 return;
@@ -165,6 +188,30 @@ void DecodeResult::reset() {
     forceOutEdge = ADDRESS::g(0L);
 }
 
+/***************************************************************************/ /**
+  * \brief   Check if the decoded instruction ends a straight-line run of instructions, i.e. it is invalid, it is
+  *          a control transfer instruction, or the next instruction is not simply at pc + numBytes.
+  ******************************************************************************/
+bool DecodeResult::endsRun() const {
+    if (!valid || reDecode || type != NCT || !forceOutEdge.isZero())
+        return true;
+    if (rtl == nullptr)
+        return false; // Cancelled instruction; decoding continues after it
+    for (Instruction *s : *rtl) {
+        switch (s->getKind()) {
+        case STMT_CALL:
+        case STMT_RET:
+        case STMT_BRANCH:
+        case STMT_GOTO:
+        case STMT_CASE:
+            return true;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
 /***************************************************************************/ /**
   * These are functions used to decode instruction operands into
   * Exp*s.
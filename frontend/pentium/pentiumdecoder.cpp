@@ -55,6 +55,15 @@ void genBSFR(ADDRESS pc, Exp *reg, Exp *modrm, int init, int size, OPER incdec,
  * PentiumDecoder methods.
  **********************************/
 static DecodeResult result;
+/***************************************************************************/ /**
+  * \brief   Decode a straight-line run of at most maxCount instructions starting at pc into results, stopping
+  *          after the first control transfer instruction. See NJMCDecoder::decodeInstructions
+  * \returns the number of entries of results that were filled in
+  ******************************************************************************/
+int PentiumDecoder::decodeInstructions(ADDRESS pc, ptrdiff_t delta, DecodeResult *results, int maxCount) {
+    return decodeRun<PentiumDecoder>(pc, delta, results, maxCount);
+}
+
 /***************************************************************************/ /**
   * \brief   Decodes a machine instruction and returns an RTL instance. In most cases a single instruction is
   *              decoded. However, if a higher level construct that may consist of multiple instructions is matched,
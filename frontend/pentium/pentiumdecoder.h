@@ -26,6 +26,7 @@ class PentiumDecoder : public NJMCDecoder {
   public:
     PentiumDecoder(Prog *prog);
     virtual DecodeResult &decodeInstruction(ADDRESS pc, ptrdiff_t delta);
+    virtual int decodeInstructions(ADDRESS pc, ptrdiff_t delta, DecodeResult *results, int maxCount);
     virtual int decodeAssemblyInstruction(ADDRESS pc, ptrdiff_t delta);
 
   private:
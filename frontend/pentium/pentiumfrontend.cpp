@@ -38,6 +38,7 @@
 #include <cassert>
 #include <cstring>
 #include <sstream>
+#include <vector>
 /***************************************************************************/ /**
   * Forward declarations.
   ******************************************************************************/
@@ -132,18 +133,21 @@ bool PentiumFrontEnd::isAssignFromTern(Instruction *s) {
   *
   ******************************************************************************/
 void PentiumFrontEnd::bumpRegisterAll(Exp *e, int min, int max, int delta, int mask) {
-    std::list<Exp **> li;
-    std::list<Exp **>::iterator it;
+    ExpMatches regs;
+    auto collect = searchWith([&regs](Exp *r) {
+        regs.push_back(r);
+        return true;
+    });
     Exp *exp = e;
     // Use doSearch, which is normally an internal method of Exp, to avoid problems of replacing the wrong
     // subexpression (in some odd cases)
-    Exp::doSearch(*Location::regOf(Terminal::get(opWild)), exp, li, false);
-    for (it = li.begin(); it != li.end(); it++) {
-        int reg = ((Const *)((Unary *)**it)->getSubExp1())->getInt();
+    Exp::doSearch(*Location::regOf(Terminal::get(opWild)), exp, collect);
+    for (Exp *r : regs) {
+        int reg = ((Const *)((Unary *)r)->getSubExp1())->getInt();
         if ((min <= reg) && (reg <= max)) {
             // Replace the K in r[ K] with a new K
-            // **it is a reg[K]
-            Const *K = (Const *)((Unary *)**it)->getSubExp1();
+            // r is a reg[K]
+            Const *K = (Const *)((Unary *)r)->getSubExp1();
             K->setInt(min + ((reg - min + delta) & mask));
         }
     }
@@ -247,37 +251,21 @@ void PentiumFrontEnd::processFloatCode(Cfg *pCfg) {
             for (auto iter = rtl->begin(); iter != rtl->end(); /*incremented inside*/) {
                 // Get the current Exp
                 st = *iter;
-                if (st->isFpush()) {
-                    rtl->insert(iter, new Assign(FloatType::get(80),
-                                                 Location::tempOf(Const::get(const_cast<char *>("tmpD9"))),
-                                                 Location::regOf(39)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(39), Location::regOf(38)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(38), Location::regOf(37)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(37), Location::regOf(36)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(36), Location::regOf(35)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(35), Location::regOf(34)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(34), Location::regOf(33)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(33), Location::regOf(32)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(32),
-                                                 Location::tempOf(Const::get(const_cast<char *>("tmpD9")))));
-                    // Remove the FPUSH
-                    iter = rtl->erase(iter);
-                    continue;
-                } else if (st->isFpop()) {
-                    rtl->insert(iter, new Assign(FloatType::get(80),
-                                                 Location::tempOf(Const::get(const_cast<char *>("tmpD9"))),
-                                                 Location::regOf(32)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(32), Location::regOf(33)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(33), Location::regOf(34)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(34), Location::regOf(35)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(35), Location::regOf(36)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(36), Location::regOf(37)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(37), Location::regOf(38)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(38), Location::regOf(39)));
-                    rtl->insert(iter, new Assign(FloatType::get(80), Location::regOf(39),
-                                                 Location::tempOf(Const::get(const_cast<char *>("tmpD9")))));
-                    // Remove the FPOP
+                if (st->isFpush() || st->isFpop()) {
+                    // FPUSH moves r[32..38] up to r[33..39] and r[39] to r[32]; FPOP moves them the other way
+                    int first = st->isFpush() ? 39 : 32;
+                    int step = st->isFpush() ? -1 : 1;
+                    int last = first + 7 * step;
+                    Exp *tmp = Location::tempOf(Const::get(const_cast<char *>("tmpD9")));
+                    std::vector<Instruction *> semantics;
+                    semantics.push_back(new Assign(FloatType::get(80), tmp, Location::regOf(first)));
+                    for (int r = first; r != last; r += step)
+                        semantics.push_back(
+                            new Assign(FloatType::get(80), Location::regOf(r), Location::regOf(r + step)));
+                    semantics.push_back(new Assign(FloatType::get(80), Location::regOf(last), tmp->clone()));
+                    // Replace the FPUSH or FPOP with these, and continue after them
                     iter = rtl->erase(iter);
+                    iter = rtl->insert(iter, semantics.begin(), semantics.end()) + semantics.size();
                     continue;
                 }
                 ++iter;
@@ -844,8 +832,8 @@ bool PentiumFrontEnd::decodeSpecial_out(ADDRESS pc, DecodeResult &r) {
     r.type = NCT;
     r.reDecode = false;
     r.rtl = new RTL(pc);
-    Exp *dx = Location::regOf(decoder->getRTLDict().RegMap["%dx"]);
-    Exp *al = Location::regOf(decoder->getRTLDict().RegMap["%al"]);
+    Exp *dx = Location::regOf(decoder->getRTLDict().getRegIdx("%dx"));
+    Exp *al = Location::regOf(decoder->getRTLDict().getRegIdx("%al"));
     CallStatement *call = new CallStatement();
     call->setDestProc(Program->getLibraryProc("outp"));
     call->setArgumentExp(0, dx);
@@ -886,6 +874,29 @@ DecodeResult &PentiumFrontEnd::decodeInstruction(ADDRESS pc) {
     return FrontEnd::decodeInstruction(pc);
 }
 
+//! Check if the instruction at pc is one that decodeSpecial handles
+bool PentiumFrontEnd::isSpecial(ADDRESS pc) {
+    int n = Image->readNative1(pc);
+    if (n == (int)(char)0xee)
+        return true;
+    return n == (int)(char)0x0f && Image->readNative1(pc + 1) == (int)(char)0x0b;
+}
+
+int PentiumFrontEnd::decodeInstructions(ADDRESS pc, DecodeResult *results, int maxCount) {
+    if (decodeSpecial(pc, results[0]))
+        return 1;
+    int count = FrontEnd::decodeInstructions(pc, results, maxCount);
+    // Special instructions must start a run of their own, so that decodeSpecial gets to see them
+    for (int i = 1; i < count; i++) {
+        pc += results[i - 1].numBytes;
+        if (isSpecial(pc)) {
+            discardDecoded(results + i, count - i);
+            return i;
+        }
+    }
+    return count;
+}
+
 // EXPERIMENTAL: can we find function pointers in arguments to calls this early?
 void PentiumFrontEnd::extraProcessCall(CallStatement *call, std::list<RTL *> *BB_rtls) {
     if (not call->getDestProc())
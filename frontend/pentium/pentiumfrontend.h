@@ -64,12 +64,14 @@ class PentiumFrontEnd : public FrontEnd {
     bool isAssignFromTern(Instruction *s);
     void bumpRegisterAll(Exp *e, int min, int max, int delta, int mask);
     unsigned fetch4(unsigned char *ptr);
+    bool isSpecial(ADDRESS pc);
     bool decodeSpecial(ADDRESS pc, DecodeResult &r);
     bool decodeSpecial_out(ADDRESS pc, DecodeResult &r);
     bool decodeSpecial_invalid(ADDRESS pc, DecodeResult &r);
 
   protected:
     virtual DecodeResult &decodeInstruction(ADDRESS pc);
+    virtual int decodeInstructions(ADDRESS pc, DecodeResult *results, int maxCount);
     virtual void extraProcessCall(CallStatement *call, std::list<RTL *> *BB_rtls);
 };
 
@@ -74,6 +74,15 @@ Exp *crBit(int bitNum); // Get an expression for a CR bit access
     jump->setCondType(cond);                                                                                           \
     SHOW_ASM(name << " " << BIcr << ", 0x" << relocd - delta)
 
+/***************************************************************************/ /**
+  * \brief   Decode a straight-line run of at most maxCount instructions starting at pc into results, stopping
+  *          after the first control transfer instruction. See NJMCDecoder::decodeInstructions
+  * \returns the number of entries of results that were filled in
+  ******************************************************************************/
+int PPCDecoder::decodeInstructions(ADDRESS pc, ptrdiff_t delta, DecodeResult *results, int maxCount) {
+    return decodeRun<PPCDecoder>(pc, delta, results, maxCount);
+}
+
 /***************************************************************************/ /**
   * \fn       PPCDecoder::decodeInstruction
   * \brief       Attempt to decode the high level instruction at a given address.
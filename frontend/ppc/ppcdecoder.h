@@ -33,6 +33,7 @@ class PPCDecoder : public NJMCDecoder {
          * the instruction.
          */
     virtual DecodeResult &decodeInstruction(ADDRESS pc, ptrdiff_t delta);
+    virtual int decodeInstructions(ADDRESS pc, ptrdiff_t delta, DecodeResult *results, int maxCount);
 
     /*
          * Disassembles the machine instruction at pc and returns the number of
@@ -54,9 +54,8 @@
 void DEBUG_STMTS(DecodeResult &result) {
     if (DEBUG_DECODER) {
         QTextStream q_cout(stdout);
-        std::list<Instruction *>::iterator ii;
-        for (ii = result.rtl->begin(); ii != result.rtl->end(); ii++)
-            q_cout << "            " << *ii << "\n";
+        for (Instruction *s : *result.rtl)
+            q_cout << "            " << s << "\n";
     }
 }
 
@@ -175,6 +174,15 @@ RTL *SparcDecoder::createBranchRtl(ADDRESS pc, std::list<Instruction *> *stmts,
     return res;
 }
 
+/***************************************************************************/ /**
+  * \brief   Decode a straight-line run of at most maxCount instructions starting at pc into results, stopping
+  *          after the first control transfer instruction. See NJMCDecoder::decodeInstructions
+  * \returns the number of entries of results that were filled in
+  ******************************************************************************/
+int SparcDecoder::decodeInstructions(ADDRESS pc, ptrdiff_t delta, DecodeResult *results, int maxCount) {
+    return decodeRun<SparcDecoder>(pc, delta, results, maxCount);
+}
+
 /***************************************************************************/ /**
   * \fn     SparcDecoder::decodeInstruction
   * \brief  Attempt to decode the high level instruction at a given address.
@@ -38,6 +38,7 @@ public:
          * the instruction.
          */
     virtual DecodeResult &decodeInstruction(ADDRESS pc, ptrdiff_t delta);
+    virtual int decodeInstructions(ADDRESS pc, ptrdiff_t delta, DecodeResult *results, int maxCount);
 
     /*
          * Disassembles the machine instruction at pc and returns the number of
@@ -749,6 +749,12 @@ bool SparcFrontEnd::processProc(ADDRESS uAddr, UserProc *proc, QTextStream &os,
     // Initialise the queue of control flow targets that have yet to be decoded.
     targetQueue.initial(uAddr);
 
+    // Instructions are decoded a straight-line run at a time; decodedRun[runPos] is the instruction at runAddr.
+    // Delay slot instructions are decoded by themselves
+    DecodeResult decodedRun[DECODE_RUN_SIZE];
+    int runPos = 0, runLen = 0;
+    ADDRESS runAddr = NO_ADDRESS;
+
     // Get the next address from which to continue decoding and go from
     // there. Exit the loop if there are no more addresses or they all
     // correspond to locations that have been decoded.
@@ -774,12 +780,22 @@ bool SparcFrontEnd::processProc(ADDRESS uAddr, UserProc *proc, QTextStream &os,
                 inst.rtl = ff->second;
                 inst.valid = true;
                 inst.type = DD; // E.g. decode the delay slot instruction
-            } else
-                inst = decodeInstruction(uAddr);
+            } else {
+                // Decode the inst at uAddr, unless it is the next one of the current run
+                if (runPos == runLen || runAddr != uAddr) {
+                    discardDecoded(decodedRun + runPos, runLen - runPos);
+                    runLen = decodeInstructions(uAddr, decodedRun, DECODE_RUN_SIZE);
+                    runPos = 0;
+                }
+                inst = decodedRun[runPos++];
+                runAddr = uAddr + inst.numBytes;
+            }
 
             // If invalid and we are speculating, just exit
-            if (spec && !inst.valid)
+            if (spec && !inst.valid) {
+                discardDecoded(decodedRun + runPos, runLen - runPos);
                 return false;
+            }
 
             // Check for invalid instructions
             if (!inst.valid) {
@@ -790,6 +806,7 @@ bool SparcFrontEnd::processProc(ADDRESS uAddr, UserProc *proc, QTextStream &os,
                 LOG_STREAM() << "\n";
                 LOG_STREAM().flush();
                 assert(false);
+                discardDecoded(decodedRun + runPos, runLen - runPos);
                 return false;
             }
 
@@ -1162,6 +1179,7 @@ bool SparcFrontEnd::processProc(ADDRESS uAddr, UserProc *proc, QTextStream &os,
         // Must set sequentialDecode back to true
         sequentialDecode = true;
     } // End huge while loop
+    discardDecoded(decodedRun + runPos, runLen - runPos);
 
     // Add the callees to the set of CallStatements to proces for parameter recovery, and also to the Prog object
     for (std::list<CallStatement *>::iterator it = callList.begin(); it != callList.end(); it++) {
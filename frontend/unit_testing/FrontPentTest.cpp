@@ -169,6 +169,46 @@ void FrontPentTest::test3() {
     // delete pBF;
 }
 
+/***************************************************************************/ /**
+  * FUNCTION:        FrontPentTest::testDecodeRun
+  * OVERVIEW:        Test decoding a straight-line run of instructions in one go
+  *============================================================================*/
+void FrontPentTest::testDecodeRun() {
+    DecodeResult results[16];
+    BinaryFileFactory bff;
+    QObject *pBF = bff.Load(HELLO_PENT);
+    QVERIFY(pBF != 0);
+    Prog *prog = new Prog(HELLO_PENT);
+    FrontEnd *pFE = new PentiumFrontEnd(pBF, prog, &bff);
+    prog->setFrontEnd(pFE);
+
+    // add esp, 16; mov eax, 0; leave; ret
+    int count = pFE->decodeInstructions(ADDRESS::n(0x8048345), results, 16);
+    QCOMPARE(count, 4);
+    QCOMPARE(results[1].rtl->getAddress(), ADDRESS::n(0x8048348));
+    QCOMPARE(results[2].rtl->getAddress(), ADDRESS::n(0x804834d));
+    QCOMPARE(results[3].rtl->getAddress(), ADDRESS::n(0x804834e));
+    QVERIFY(!results[2].endsRun());
+    QVERIFY(results[3].endsRun());
+
+    // Each entry has to be the same as decoding the instruction by itself
+    for (int i = 0; i < count; i++) {
+        QString batch, single;
+        QTextStream batchStrm(&batch), singleStrm(&single);
+        results[i].rtl->print(batchStrm);
+        DecodeResult inst = pFE->decodeInstruction(results[i].rtl->getAddress());
+        inst.rtl->print(singleStrm);
+        QCOMPARE(batch, single);
+        QCOMPARE(results[i].numBytes, inst.numBytes);
+    }
+
+    // A run stops at maxCount
+    count = pFE->decodeInstructions(ADDRESS::n(0x8048345), results, 2);
+    QCOMPARE(count, 2);
+
+    delete pFE;
+}
+
 void FrontPentTest::testBranch() {
     DecodeResult inst;
     QString expected;
@@ -6,6 +6,7 @@ class FrontPentTest : public QObject {
     void test1();
     void test2();
     void test3();
+    void testDecodeRun();
     void testFindMain();
     void testBranch();
 };
@@ -0,0 +1,94 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/***************************************************************************/ /**
+  * \file        arena.h
+  * OVERVIEW:    Region allocator for the Exp and Instruction objects of a procedure.
+  ******************************************************************************/
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/***************************************************************************/ /**
+  \class  MemoryArena
+   A bump pointer region from which the Exps and Instructions created while an arena is current are allocated.
+   Every UserProc has one (created by Prog on first use), and the Prog has one for the program level phases.
+   Memory from an arena is never given back one object at a time; deleting an object that lives in an arena
+   does nothing, and the whole region is freed by release() (called when the owning Prog is destroyed).
+
+   Allocations are always counted against the current arena, so the memory used by each procedure can be
+   reported. Placing the objects in the arena is optional (see setPlacement()); when it is off the objects
+   come from the normal heap and can be deleted as usual.
+  ******************************************************************************/
+class MemoryArena {
+  public:
+    explicit MemoryArena(const QString &name);
+    MemoryArena(const MemoryArena &) = delete;
+    MemoryArena &operator=(const MemoryArena &) = delete;
+    ~MemoryArena();
+
+    const QString &getName() const { return Name; }
+    uint64_t getNumAllocs() const { return NumAllocs; }           //!< Number of objects allocated while current
+    uint64_t getBytesAllocated() const { return BytesAllocated; } //!< Size of those objects
+    size_t getBytesReserved() const { return BytesReserved; }     //!< Size of the chunks owned by this arena
+    void release();
+
+    static MemoryArena *current() { return Current; }
+    static void setPlacement(bool on) { Placement = on; }
+    static bool placementEnabled() { return Placement; }
+    static void *allocate(size_t size);
+    static void deallocate(void *p);
+
+  private:
+    friend class ArenaScope;
+    void *allocateHere(size_t size);
+
+    QString Name;
+    std::vector<char *> Chunks;
+    char *Next = nullptr;  //!< First free byte in the last chunk
+    char *Limit = nullptr; //!< End of the last chunk
+    uint64_t NumAllocs = 0;
+    uint64_t BytesAllocated = 0;
+    size_t BytesReserved = 0;
+
+    static thread_local MemoryArena *Current;
+    static bool Placement;
+    static std::map<const char *, const char *> ChunkRanges; //!< Start to end of every live chunk of every arena
+};
+
+/***************************************************************************/ /**
+  \class  ArenaScope
+   Makes an arena the current one for the lifetime of the scope, and restores the previous one afterwards.
+   Passing nullptr makes the objects created in the scope come from the heap (e.g. for function level statics
+   that outlive any procedure).
+  ******************************************************************************/
+class ArenaScope {
+  public:
+    explicit ArenaScope(MemoryArena *arena) : Saved(MemoryArena::Current) { MemoryArena::Current = arena; }
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+    ~ArenaScope() { MemoryArena::Current = Saved; }
+
+  private:
+    MemoryArena *Saved;
+};
+
+/***************************************************************************/ /**
+  * \brief Call \a make with no current arena and return its result. Use this for objects that must outlive every
+  * arena, such as the subexpressions of the static search patterns that some functions create on their first call.
+  ******************************************************************************/
+template <class Func> auto onHeap(Func make) -> decltype(make()) {
+    ArenaScope heap(nullptr);
+    return make();
+}
+
+#endif
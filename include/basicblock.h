@@ -121,6 +121,8 @@ class BasicBlock {
     typedef std::vector<BasicBlock *>::iterator iEdgeIterator;
     typedef std::list<RTL *>::iterator rtlit;
     typedef std::list<RTL *>::reverse_iterator rtlrit;
+    typedef std::vector<Instruction *>::iterator stmtit;          //!< Iterator over the statements of an RTL
+    typedef std::vector<Instruction *>::reverse_iterator stmtrit; //!< Reverse iterator over the statements of an RTL
     typedef std::list<Exp *>::iterator elit;
 
   protected:
@@ -220,6 +222,7 @@ class BasicBlock {
 
     size_t getNumInEdges() const { return InEdges.size(); }
 
+    const LocationSet &getLiveIn() const { return LiveIn; }
     const std::vector<BasicBlock *> &getOutEdges();
     void clearOutEdges() { OutEdges.clear(); } //!<called when noreturn call is found
     void setInEdge(size_t i, BasicBlock *newIn);
@@ -269,12 +272,12 @@ class BasicBlock {
      * Somewhat intricate because of the post call semantics; these funcs save a lot of duplicated, easily-bugged
      * code
      */
-    Instruction *getFirstStmt(rtlit &rit, StatementList::iterator &sit);
-    Instruction *getNextStmt(rtlit &rit, StatementList::iterator &sit);
-    Instruction *getLastStmt(rtlrit &rit, StatementList::reverse_iterator &sit);
+    Instruction *getFirstStmt(rtlit &rit, stmtit &sit);
+    Instruction *getNextStmt(rtlit &rit, stmtit &sit);
+    Instruction *getLastStmt(rtlrit &rit, stmtrit &sit);
     Instruction *getFirstStmt();
     Instruction *getLastStmt();
-    Instruction *getPrevStmt(rtlrit &rit, StatementList::reverse_iterator &sit);
+    Instruction *getPrevStmt(rtlrit &rit, stmtrit &sit);
     RTL *getLastRtl() { return ListOfRTLs->back(); }
     void getStatements(StatementList &stmts) const;
     char *getStmtNumber();
@@ -290,12 +293,13 @@ class BasicBlock {
     // Liveness
     bool calcLiveness(ConnectionGraph &ig, UserProc *proc);
     void getLiveOut(LocationSet &live, LocationSet &phiLocs);
+    void getPhiLiveOut(LocationSet &phiLocs);
 
     bool decodeIndirectJmp(UserProc *proc);
     void processSwitch(UserProc *proc);
     int findNumCases();
     bool undoComputedBB(Instruction *stmt);
-    bool searchAll(const Exp &search_for, std::list<Exp *> &results);
+    bool searchAll(const Exp &search_for, ExpMatches &results);
     bool searchAndReplace(const Exp &search, Exp *replace);
 
     void generateCode_Loop(HLLCode *hll, std::list<BasicBlock *> &gotoSet, int indLevel, UserProc *proc,
@@ -0,0 +1,137 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/***************************************************************************/ /**
+  * \file       binaryir.h
+  * OVERVIEW:   A compact binary encoding of expressions, types, statements and RTLs.
+  *
+  * Each expression node is a tag byte followed by its operator and operands as LEB128 varints (signed values are
+  * zigzag encoded). A node that was already written by the same writer (a subtree shared between two parents, e.g.
+  * by Exp::substitute()) is written as a back reference to its number, so sharing survives a round trip.
+  * Procedures are written by name and definitions (RefExp, PhiAssign) by statement number; the reader looks them up
+  * in the Prog and UserProc it is given.
+  *
+  * The format is a building block for caches and checkpoints: it has no header or version of its own.
+  ******************************************************************************/
+#ifndef BINARYIR_H
+#define BINARYIR_H
+
+#include <QByteArray>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class Exp;
+class Instruction;
+class RTL;
+class Prog;
+class UserProc;
+class RefExp;
+class PhiAssign;
+class BasicBlock;
+class Type;
+typedef std::shared_ptr<Type> SharedType;
+
+/***************************************************************************/ /**
+  * \class BinaryIRWriter
+  * Appends the encoding of expressions, types, statements and RTLs to a byte array. The expressions written must
+  * stay alive until clear(), since back references are found by address.
+  ******************************************************************************/
+class BinaryIRWriter {
+  public:
+    BinaryIRWriter() = default;
+
+    void write(const Exp *e);
+    void write(const SharedType &ty);
+    void write(Instruction *s);
+    void write(RTL *rtl);
+
+    const QByteArray &data() const { return Buf; }
+    //! False if something could not be encoded (a function type; it is written as void)
+    bool isOk() const { return Ok; }
+    void clear();
+
+  private:
+    void writeByte(uint8_t b) { Buf.append(char(b)); }
+    void writeVarint(uint64_t v);
+    void writeSigned(int64_t v) { writeVarint((uint64_t(v) << 1) ^ uint64_t(v >> 63)); }
+    void writeString(const QString &s);
+    void writeDef(const Instruction *def);
+    void writeStatements(const std::list<Instruction *> &stmts);
+
+    QByteArray Buf;
+    std::unordered_map<const Exp *, uint32_t> ExpIds; //!< Number of each node written so far
+    bool Ok = true;
+};
+
+/***************************************************************************/ /**
+  * \class BinaryIRReader
+  * Decodes what a BinaryIRWriter wrote. The reader works directly on the caller's buffer, which must stay alive
+  * while it is in use; nothing is copied except the strings.
+  *
+  * A definition is resolved against the statements this reader has already made, then (if there is one) the
+  * statements of the UserProc. References to statements that come later in the input are resolved by
+  * resolveDefs(); call it once everything has been read.
+  ******************************************************************************/
+class BinaryIRReader {
+  public:
+    BinaryIRReader(const char *data, size_t size, Prog *prog = nullptr, UserProc *proc = nullptr);
+
+    Exp *readExp();
+    SharedType readType();
+    Instruction *readStatement();
+    RTL *readRTL();
+    void resolveDefs();
+
+    bool atEnd() const { return Pos == End; }
+    //! False once malformed or truncated input has been seen; everything read after that is null
+    bool isOk() const { return Ok; }
+    //! Number of definitions that resolveDefs() could not find
+    size_t getNumUnresolved() const { return Unresolved; }
+
+  private:
+    uint8_t readByte();
+    uint64_t readVarint();
+    int64_t readSigned() {
+        uint64_t v = readVarint();
+        return int64_t(v >> 1) ^ -int64_t(v & 1);
+    }
+    int readOper();
+    int readBranchType();
+    QString readString();
+    Instruction *readDef(int &number);
+    bool readStatements(std::list<Instruction *> &stmts);
+    Instruction *findDef(int number);
+    void fail() { Ok = false; }
+
+    //! A definition that was not known when it was read
+    struct PendingDef {
+        RefExp *Ref;       //!< The RefExp to set, or
+        PhiAssign *Phi;    //!< the phi to set the definition of
+        BasicBlock *PhiBB; //!< for this in-edge
+        int Number;
+    };
+
+    const uint8_t *Pos;
+    const uint8_t *End;
+    Prog *Prg;
+    UserProc *Proc;
+    bool Ok = true;
+    size_t Unresolved = 0;
+    std::vector<Exp *> Exps;                    //!< Nodes by number, for back references
+    std::map<int, Instruction *> Numbered;      //!< Statements read, by number
+    std::map<int, Instruction *> ProcNumbered;  //!< Statements of Proc, by number; filled when first needed
+    bool ProcScanned = false;
+    std::vector<PendingDef> Pending;
+};
+
+#endif
@@ -274,10 +274,17 @@ public:
     bool dumpXML = false;
     bool noRemoveReturns = false;
     bool decodeThruIndCall = false;
+    bool incrementalRedecode = false; ///< Only decode the new targets after analysing indirect jumps and calls
+    bool arenaAlloc = false;          ///< Place Exps and Statements in the arena of their proc (see arena.h)
+    bool ruleSimplify = false;        ///< Simplify with the rules in transformations/ instead of polySimplify
+    bool egraphSimplify = false;      ///< Simplify each proc as a whole with an e-graph before the usual simplify
+    bool prunedPhis = false;          ///< Only place phi functions where the location is live (pruned SSA)
+    bool mapLiveness = false;         ///< Find the interferences for fromSSAform with LocationSets, not bit vectors
     bool noDecodeChildren = false;
     bool loadBeforeDecompile = false;
     bool saveBeforeDecompile = false;
     bool noProve = false;
+    int proofBudget = 100000; ///< Steps allowed for each query to UserProc::prove before giving up (0: no limit)
     bool noChangeSignatures = false;
     bool conTypeAnalysis = false;
     bool dfaTypeAnalysis = true;
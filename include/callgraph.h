@@ -0,0 +1,69 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/***************************************************************************/ /**
+  * \file       callgraph.h
+  * OVERVIEW:   The strongly connected components of the call graph between user procedures.
+  *
+  * A component is a single procedure, or a group of mutually recursive ones. The components are found with Tarjan's
+  * algorithm, which produces them in reverse topological order: every component comes after all the components it
+  * calls. Decompiling them in that order means that each procedure's callees are final before it is started, except
+  * for the other members of its own recursion group.
+  ******************************************************************************/
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class UserProc;
+
+/***************************************************************************/ /**
+  * \class CallGraphSCCs
+  * The components of the part of the call graph reachable from the procedures given to addRoot(). The callees of a
+  * procedure are the user procedures its call statements are known to call, in the order of its BBs; procedures that
+  * are not yet decoded have none.
+  *
+  * The search can also be driven by a caller that finds the callees itself (UserProc::decompile() does, since decoding
+  * and analysing a procedure can find new ones), with the steps enter(), reach(), returnFrom() and leave().
+  ******************************************************************************/
+class CallGraphSCCs {
+  public:
+    void addRoot(UserProc *root);
+    void clear();
+
+    size_t size() const { return Components.size(); }
+    //! The procedures of component i, starting with the one the search entered it by
+    const std::vector<UserProc *> &getComponent(size_t i) const { return Components[i]; }
+    const std::vector<UserProc *> &getCallees(UserProc *proc);
+
+    static void findCallees(UserProc *proc, std::vector<UserProc *> &callees);
+
+    // The steps of Tarjan's algorithm
+    void enter(UserProc *proc);
+    void reach(UserProc *from, UserProc *to);
+    void returnFrom(UserProc *from, UserProc *to);
+    int leave(UserProc *proc);
+    //! True if proc has been entered, but its component is not complete yet
+    bool isOpen(UserProc *proc) const { return Index.count(proc) != 0; }
+
+  private:
+    void addComponent(UserProc *root);
+
+    std::vector<std::vector<UserProc *>> Components; //!< In reverse topological order
+    std::unordered_map<UserProc *, int> ComponentOf;
+    std::unordered_map<UserProc *, std::vector<UserProc *>> Callees;
+
+    // Tarjan's algorithm
+    std::unordered_map<UserProc *, int> Index; //!< Order of first visit; entries are erased when a component is done
+    std::unordered_map<UserProc *, int> Low;
+    std::vector<UserProc *> Stack;
+    int NextIndex = 0;
+};
+
+#endif
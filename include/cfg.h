@@ -44,6 +44,7 @@ class XMLProgParser;
 class Global;
 class Parameter;
 class ConnectionGraph;
+class InterferenceGraph;
 class Instruction;
 enum class BBTYPE;
 #define BTHEN 0
@@ -83,6 +84,7 @@ class Cfg {
     void clear();
     size_t getNumBBs() { return m_listBB.size(); } //!<Get the number of BBs
     Cfg &operator=(const Cfg &other);        /* Copy constructor */
+    void deepCopyFrom(const Cfg &other);
 
     BasicBlock *newBB(std::list<RTL *> *pRtls, BBTYPE bbType, uint32_t iNumOutEdges) noexcept(false);
     BasicBlock *newIncompleteBB(ADDRESS addr);
@@ -124,7 +126,7 @@ class Cfg {
     void addCall(CallStatement *call);
     sCallStatement &getCalls();
     void searchAndReplace(const Exp &search, Exp *replace);
-    bool searchAll(const Exp &search, std::list<Exp *> &result);
+    bool searchAll(const Exp &search, ExpMatches &result);
     Exp *getReturnVal();
     void structure();
     void removeJunctionStatements();
@@ -191,6 +193,7 @@ class Cfg {
     bool implicitsDone() { return ImplicitsDone; }    //!<  True if implicits have been created
     void setImplicitsDone() { ImplicitsDone = true; } //!< Call when implicits have been created
     void findInterferences(ConnectionGraph &ig);
+    void findInterferences(InterferenceGraph &ig);
     void appendBBs(std::list<BasicBlock *> &worklist, std::set<BasicBlock *> &workset);
     void removeUsedGlobals(std::set<Global *> &unusedGlobals);
     void bbSearchAll(Exp *search, std::list<Exp *> &result, bool ch);
@@ -18,10 +18,12 @@
 #include "exphelp.h" // For lessExpStar, etc
 #include "managed.h" // For LocationSet
 
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <set>
 #include <stack>
+#include <unordered_map>
 
 class Cfg;
 class BasicBlock;
@@ -33,28 +35,40 @@ class PhiAssign;
 class Type;
 class QTextStream;
 
+//! Counters for DataFlow::placePhiFunctions, summed over the calls for one proc
+struct PhiStats {
+    uint64_t Placed = 0; //!< Phi functions inserted
+    uint64_t Pruned = 0; //!< Phi functions not inserted since the location was not live (see -pp)
+    uint64_t Nsecs = 0;  //!< Time spent placing them, including the liveness for pruning
+};
+
 class DataFlow {
     /******************** Dominance Frontier Data *******************/
 
     /* These first two are not from Appel; they map PBBs to indices */
-    std::vector<BasicBlock *> BBs;       // Pointers to BBs from indices
-    std::map<BasicBlock *, int> indices; // Indices from pointers to BBs
-                                         /*
-                                          * Calculating the dominance frontier
-                                          */
-    // If there is a path from a to b in the cfg, then a is an ancestor of b
-    // if dfnum[a] < denum[b]
-    std::vector<int> dfnum;            // Number set in depth first search
-    std::vector<int> semi;             // Semi dominators
-    std::vector<int> ancestor;         // Defines the forest that becomes the spanning tree
-    std::vector<int> idom;             // Immediate dominator
-    std::vector<int> samedom;          // ? To do with deferring
-    std::vector<int> vertex;           // ?
-    std::vector<int> parent;           // Parent in the dominator tree?
-    std::vector<int> best;             // Improves ancestorWithLowestSemi
-    std::vector<std::set<int>> bucket; // Deferred calculation?
-    int N;                             // Current node number in algorithm
-    std::vector<std::set<int>> DF;     // The dominance frontiers
+    std::vector<BasicBlock *> BBs;                 // Pointers to BBs from indices
+    std::unordered_map<BasicBlock *, int> indices; // Indices from pointers to BBs
+    /*
+     * Calculating the dominators (semi-NCA). Apart from dfnum, the work vectors are indexed by depth first number
+     */
+    std::vector<int> dfnum;     // Number set in depth first search, -1 if the node is unreachable
+    std::vector<int> vertex;    // Node with each depth first number
+    std::vector<int> parent;    // Parent in the depth first spanning tree
+    std::vector<int> ancestor;  // Path compressed parent in the forest of linked vertices
+    std::vector<int> label;     // Vertex with the lowest semi dominator on the compressed path
+    std::vector<int> evalStack; // Reused by ancestorWithLowestSemi
+    std::vector<int> semi;      // Semi dominators (by node once dominators() is done)
+    std::vector<int> idom;      // Immediate dominator
+    int N;                      // Number of reachable nodes
+    /*
+     * The dominator tree and the dominance frontiers, each stored as compressed rows: the children of node n are
+     * domChildren[domChildStart[n]] up to (not including) domChildren[domChildStart[n+1]], in node order; likewise DF
+     */
+    std::vector<int> domChildStart, domChildren;
+    std::vector<int> domPre;  // Preorder number in the dominator tree, -1 if unreachable
+    std::vector<int> domLast; // Highest preorder number in the subtree of each node
+    std::vector<int> domOrder; // The reachable nodes in dominator tree preorder
+    std::vector<int> DFStart, DFNodes;
 
     /*
      * Inserting phi-functions
@@ -77,27 +91,54 @@ class DataFlow {
     // A map from expression (Exp*) to a stack of (pointers to) Statements
     std::map<Exp *, std::deque<Instruction *>, lessExpStar> Stacks;
 
+    /*
+     * Updating the renaming (updateBlockVars): the definitions seen by the last renaming from the entry, in dominator
+     * tree order. A null expression stands for the define-all of a childless call
+     */
+    std::vector<std::pair<Instruction *, Exp *>> renamedDefs;
+    LocationSet renamedEscapedVars; // Which locals and parameters could not be renamed
+    bool renamedDefsValid;
+    bool renamedWithLocalsParams;
+
     // Initially false, meaning that locals and parameters are not renamed and hence not propagated.
     // When true, locals and parameters can be renamed if their address does not escape the local procedure.
     // See Mike's thesis for details.
     bool renameLocalsAndParams;
 
+    PhiStats phiStats;
+
   public:
-    DataFlow() : renameLocalsAndParams(false) {} // Constructor
-                                                 /*
-                                                   * Dominance frontier and SSA code
-                                                   */
+    DataFlow() : renamedDefsValid(false), renamedWithLocalsParams(false), renameLocalsAndParams(false) {}
+    /*
+     * Dominance frontier and SSA code
+     */
     ~DataFlow();
-    void DFS(int p, size_t n);
+
+    //! A read only view of one row of the dominator tree or dominance frontiers
+    class NodeRange {
+        const int *First, *Last;
+
+      public:
+        NodeRange(const int *first, const int *last) : First(first), Last(last) {}
+        const int *begin() const { return First; }
+        const int *end() const { return Last; }
+        size_t size() const { return Last - First; }
+        bool empty() const { return First == Last; }
+    };
+
+    void DFS(int r);
     void dominators(Cfg *cfg);
-    int ancestorWithLowestSemi(int v);
-    void Link(int p, int n);
-    void computeDF(int n);
+    int ancestorWithLowestSemi(int v, int lastLinked);
+    void buildDominatorTree();
+    void computeDF();
     // Place phi functions. Return true if any change
     bool placePhiFunctions(UserProc *proc);
     // Rename variables in basicblock n. Return true if any change made
     bool renameBlockVars(UserProc *proc, int n, bool clearStacks = false);
-    bool doesDominate(int n, int w);
+    // Subscript new uses without renaming everything again. Return false if a full renaming is needed instead
+    bool updateBlockVars(UserProc *proc, bool &changed);
+    bool doesDominate(int n, int w) const;
+    NodeRange getDomChildren(size_t node) const { return row(domChildStart, domChildren, node); }
     void setRenameLocalsParams(bool b) { renameLocalsAndParams = b; }
     bool canRenameLocalsParams() { return renameLocalsAndParams; }
     bool canRename(Exp *e, UserProc *proc);
@@ -107,10 +148,11 @@ class DataFlow {
                           std::map<Exp *, PhiAssign *, lessExpStar> &defdByPhi);
     void setDominanceNums(int n, int &currNum); // Set the dominance statement number
     void clearA_phi() { A_phi.clear(); }
+    const PhiStats &getPhiStats() const { return phiStats; }
 
     // For testing:
     int pbbToNode(BasicBlock *bb) { return indices[bb]; }
-    std::set<int> &getDF(size_t node) { return DF[node]; }
+    NodeRange getDF(size_t node) const { return row(DFStart, DFNodes, node); }
     BasicBlock *nodeToBB(size_t node) { return BBs[node]; }
     int getIdom(size_t node) { return idom[node]; }
     int getSemi(size_t node) { return semi[node]; }
@@ -121,6 +163,21 @@ class DataFlow {
     void dumpDefsites();
     void dumpA_orig();
     void dumpA_phi();
+
+  private:
+    bool renameBlock(UserProc *proc, int n, bool record);
+    void popBlockDefs(UserProc *proc, int n);
+    void getRenamableUses(Instruction *S, LocationSet &locs);
+    void updateUses(UserProc *proc, RefExp *x);
+    void subscriptUse(UserProc *proc, Instruction *S, Exp *x, Instruction *def);
+    void clearRenamedDefs();
+    bool renamedDefsUnchanged(UserProc *proc);
+    bool definesForRenaming(UserProc *proc, Instruction *S, Exp *x);
+    void findLiveIn(UserProc *proc, LocationNumbering &liveNums, std::vector<BitSet> &liveIn);
+
+    static NodeRange row(const std::vector<int> &start, const std::vector<int> &nodes, size_t n) {
+        return NodeRange(nodes.data() + start[n], nodes.data() + start[n + 1]);
+    }
 };
 
 /*    *    *    *    *    *    *\
@@ -81,6 +81,9 @@ struct DecodeResult {
      * At present, only used for the SPARC call/add caller prologue
      */
     ADDRESS forceOutEdge;
+
+    //! True if straight-line decoding can't simply continue with the next instruction (CTI, invalid, etc)
+    bool endsRun() const;
 };
 
 /***************************************************************************/ /**
@@ -97,6 +100,13 @@ public:
     //! Decodes the machine instruction at pc and returns an RTL instance for the instruction.
     virtual DecodeResult &decodeInstruction(ADDRESS pc, ptrdiff_t delta) = 0;
 
+    /**
+     * Decodes a straight-line run of at most maxCount instructions starting at pc into results. Decoding stops
+     * after the first instruction for which DecodeResult::endsRun() is true (e.g. a control transfer instruction).
+     * \returns the number of entries of results that were filled in
+     */
+    virtual int decodeInstructions(ADDRESS pc, ptrdiff_t delta, DecodeResult *results, int maxCount);
+
     /**
      * Disassembles the machine instruction at pc and returns the number of bytes disassembled.
      * Assembler output goes to global _assembly
@@ -110,6 +120,23 @@ public:
     Prog *getProg() { return prog; }
 
 protected:
+    /**
+     * The loop of decodeInstructions for a decoder class Decoder derived from this one (this must be a Decoder).
+     * Decoder::decodeInstruction is called qualified, so there is no virtual dispatch inside the run.
+     */
+    template <class Decoder> int decodeRun(ADDRESS pc, ptrdiff_t delta, DecodeResult *results, int maxCount) {
+        Decoder *decoder = static_cast<Decoder *>(this);
+        int count = 0;
+        while (count < maxCount) {
+            DecodeResult &res(results[count++]);
+            res = decoder->Decoder::decodeInstruction(pc, delta);
+            if (res.endsRun())
+                break;
+            pc += res.numBytes;
+        }
+        return count;
+    }
+
     std::list<Instruction *> *instantiate(ADDRESS pc, const char *name, ...);
 
     Exp *instantiateNamedParam(char *name, ...);
@@ -23,6 +23,7 @@
 #include "util.h"
 //#include "statement.h"    // For StmtSet etc
 #include "exphelp.h"
+#include "arena.h"
 //#include "memo.h"
 
 #include <QtCore/QString>
@@ -54,6 +55,32 @@ typedef std::shared_ptr<Exp> SharedExp;
 
 typedef std::shared_ptr<RTL> SharedRTL;
 
+/**
+  * \class SimplifyStats
+  * Counters for Exp::simplify. The calls made while a SimplifyStats is current (see SimplifyStats::Scope) are counted
+  * against it; every UserProc has one. Calls made from within another call are part of its work and not counted.
+  */
+class SimplifyStats {
+  public:
+    uint64_t Calls = 0;    //!< Outermost calls of Exp::simplify
+    uint64_t Skipped = 0;  //!< Calls for expressions that were already simplified
+    uint64_t Rewrites = 0; //!< polySimplify passes that changed something
+    uint64_t Nsecs = 0;    //!< Time spent in the calls that were not skipped
+
+    static thread_local SimplifyStats *Current;
+    //! Makes a SimplifyStats current for the lifetime of the scope
+    class Scope {
+      public:
+        explicit Scope(SimplifyStats *stats) : Saved(Current) { Current = stats; }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+        ~Scope() { Current = Saved; }
+
+      private:
+        SimplifyStats *Saved;
+    };
+};
+
 /**
   * \class Exp
   * An expression class, though it will probably be used to hold many other things (e.g. perhaps transformations).
@@ -68,18 +95,34 @@ class Exp : public Printable {
   protected:
     OPER op; // The operator (e.g. opPlus)
     mutable unsigned lexBegin = 0, lexEnd = 0;
+    //! Set by simplify() on every node of its result; cleared when the node is changed. Copies start out cleared
+    bool simplified = false;
     // Constructor, with ID
     constexpr Exp(OPER _op) : op(_op) {}
+    //! Store \a e in the subexpression \a slot; if that changes the subexpression, this node is no longer simplified
+    void replaceSubExp(Exp *&slot, Exp *e) {
+        if (slot != e) {
+            slot = e;
+            simplified = false;
+        }
+    }
 
   public:
     // Virtual destructor
     virtual ~Exp() {}
 
+    // Expressions are allocated from the current MemoryArena (see arena.h)
+    static void *operator new(size_t size) { return MemoryArena::allocate(size); }
+    static void operator delete(void *p) { MemoryArena::deallocate(p); }
+
     //! Return the operator. Note: I'd like to make this protected, but then subclasses don't seem to be able to use
     //! it (at least, for subexpressions)
     OPER getOper() const { return op; }
     const char *getOperName() const;
-    void setOper(OPER x) { op = x; } // A few simplifications use this
+    void setOper(OPER x) { // A few simplifications use this
+        op = x;
+        simplified = false;
+    }
 
     void setLexBegin(unsigned int n) const { lexBegin = n; }
     void setLexEnd(unsigned int n) const { lexEnd = n; }
@@ -229,18 +272,29 @@ class Exp : public Printable {
     // Search for Exp search in this Exp. For each found, add a ptr to the matching expression in result (useful
     // with wildcards).      Does NOT clear result on entry
     bool searchAll(const Exp &search, std::list<Exp *> &result);
+    bool searchAll(const Exp &search, ExpMatches &result);
+    //! Pass each match of search in this Exp to cb. Returns false if cb stopped the search
+    bool searchEach(const Exp &search, SearchCallback &cb);
 
     //! Search this Exp for *search; if found, replace with *replace
     Exp *searchReplace(const Exp &search, Exp *replace, bool &change);
 
     //! Search *pSrc for *search; for all occurrences, replace with *replace
     Exp *searchReplaceAll(const Exp &search, Exp *replace, bool &change, bool once = false);
+    //! As above, but persistent: this and replace are not changed or cloned. See substitute() in exp.cpp
+    Exp *substitute(const Exp &search, Exp *replace, bool &change);
 
     // Mostly not for public use. Search for subexpression matches.
+    static bool doSearch(const Exp &search, Exp *&pSrc, SearchCallback &cb);
     static void doSearch(const Exp &search, Exp *&pSrc, std::list<Exp **> &li, bool once);
 
     // As above.
-    virtual void doSearchChildren(const Exp &, std::list<Exp **> &, bool);
+    virtual bool doSearchChildren(const Exp &search, SearchCallback &cb);
+    //! Do the work of substitute(); returns this if there were no matches
+    Exp *doSubstitute(const Exp &search, Exp *replace);
+    virtual Exp *substituteChildren(const Exp & /*search*/, Exp * /*replace*/) { return this; }
+    //! Copy of the top node only, sharing the subexpressions of this one
+    virtual Exp *shallowCopy() const { return clone(); }
 
     /// Propagate all possible assignments to components of this expression.
     Exp *propagateAll();
@@ -286,6 +340,12 @@ class Exp : public Printable {
     static Exp *Accumulate(std::list<Exp *> exprs);
     // Simplify the expression
     Exp *simplify();
+    //! If set, simplify() uses this instead of polySimplify, e.g. ExpTransformer::applyAllTo for the rules in
+    //! transformations/ (see -tr)
+    static Exp *(*ruleSimplifier)(Exp *e, bool &bMod);
+    //! True if simplify() has been applied to all of this expression and nothing in it changed since
+    virtual bool isSimplifiedTree() const { return simplified; }
+    virtual void markSimplified() { simplified = true; }
     virtual Exp *polySimplify(bool &bMod) {
         bMod = false;
         return this;
@@ -412,11 +472,26 @@ class Const : public Exp {
     QString getFuncName() const;
 
     // Set the constant
-    void setInt(int i) { u.i = i; }
-    void setLong(QWord ll) { u.ll = ll; }
-    void setFlt(double d) { u.d = d; }
-    void setStr(const QString &p) { strin = p; }
-    void setAddr(ADDRESS a) { u.a = a; }
+    void setInt(int i) {
+        u.i = i;
+        simplified = false;
+    }
+    void setLong(QWord ll) {
+        u.ll = ll;
+        simplified = false;
+    }
+    void setFlt(double d) {
+        u.d = d;
+        simplified = false;
+    }
+    void setStr(const QString &p) {
+        strin = p;
+        simplified = false;
+    }
+    void setAddr(ADDRESS a) {
+        u.a = a;
+        simplified = false;
+    }
 
     // Get and set the type
     SharedType getType() { return type; }
@@ -437,7 +512,7 @@ class Const : public Exp {
 
     virtual bool match(const QString &pattern, std::map<QString, Exp *> &bindings);
 
-    int getConscript() { return conscript; }
+    int getConscript() const { return conscript; }
     void setConscript(int cs) { conscript = cs; }
 
     virtual SharedType ascendType();
@@ -520,7 +595,10 @@ class Unary : public Exp {
 
     // Set first subexpression
     void setSubExp1(Exp *e) override;
-    void setSubExp1ND(Exp *e) { subExp1 = e; }
+    void setSubExp1ND(Exp *e) {
+        subExp1 = e;
+        simplified = false;
+    }
     // Get first subexpression
     Exp *getSubExp1() override;
     const Exp *getSubExp1() const override;
@@ -531,10 +609,14 @@ class Unary : public Exp {
     virtual bool match(const QString &pattern, std::map<QString, Exp *> &bindings) override;
 
     // Search children
-    void doSearchChildren(const Exp &search, std::list<Exp **> &li, bool once) override;
+    bool doSearchChildren(const Exp &search, SearchCallback &cb) override;
+    Exp *substituteChildren(const Exp &search, Exp *replace) override;
+    Exp *shallowCopy() const override;
 
     // Do the work of simplifying this expression
     virtual Exp *polySimplify(bool &bMod) override;
+    bool isSimplifiedTree() const override;
+    void markSimplified() override;
     Exp *simplifyArith() override;
     Exp *simplifyAddr() override;
     virtual Exp *simplifyConstraint() override;
@@ -602,10 +684,14 @@ class Binary : public Unary {
     virtual bool match(const QString &pattern, std::map<QString, Exp *> &bindings) override;
 
     // Search children
-    void doSearchChildren(const Exp &search, std::list<Exp **> &li, bool once) override;
+    bool doSearchChildren(const Exp &search, SearchCallback &cb) override;
+    Exp *substituteChildren(const Exp &search, Exp *replace) override;
+    Exp *shallowCopy() const override;
 
     // Do the work of simplifying this expression
     virtual Exp *polySimplify(bool &bMod) override;
+    bool isSimplifiedTree() const override;
+    void markSimplified() override;
     Exp *simplifyArith() override;
     Exp *simplifyAddr() override;
     virtual Exp *simplifyConstraint() override;
@@ -671,9 +757,13 @@ class Ternary : public Binary {
     Exp *&refSubExp3() override;
 
     // Search children
-    void doSearchChildren(const Exp &search, std::list<Exp **> &li, bool once) override;
+    bool doSearchChildren(const Exp &search, SearchCallback &cb) override;
+    Exp *substituteChildren(const Exp &search, Exp *replace) override;
+    Exp *shallowCopy() const override;
 
     virtual Exp *polySimplify(bool &bMod) override;
+    bool isSimplifiedTree() const override;
+    void markSimplified() override;
     Exp *simplifyArith() override;
     Exp *simplifyAddr() override;
 
@@ -713,6 +803,7 @@ class TypedExp : public Unary {
 
     // Clone
     virtual Exp *clone() const override;
+    Exp *shallowCopy() const override;
 
     // Compare
     virtual bool operator==(const Exp &o) const override;
@@ -752,8 +843,9 @@ class FlagDef : public Unary {
   public:
     FlagDef(Exp *params, SharedRTL rtl); // Constructor
     virtual ~FlagDef();             // Destructor
+    Exp *shallowCopy() const override;
     virtual void appendDotFile(QTextStream &of);
-//    RTL *getRtl() { return rtl; }
+    const SharedRTL &getRtl() const { return rtl; }
 //    void setRtl(RTL *r) { rtl = r; }
 
     // Visitation
@@ -781,6 +873,7 @@ class RefExp : public Unary {
     //                    }
     static RefExp *get(Exp *e, Instruction *def) { return new RefExp(e, def); }
     virtual Exp *clone() const override;
+    Exp *shallowCopy() const override;
     virtual bool operator==(const Exp &o) const override;
     virtual bool operator<(const Exp &o) const override;
     virtual bool operator*=(Exp &o) override;
@@ -795,6 +888,7 @@ class RefExp : public Unary {
     }
     void setDef(Instruction *_def) { /*assert(_def);*/
         def = _def;
+        simplified = false;
     }
     virtual Exp *genConstraints(Exp *restrictTo) override;
     bool references(Instruction *s) { return def == s; }
@@ -872,6 +966,7 @@ class Location : public Unary {
     static Exp *param(const QString &nam, UserProc *p = nullptr) { return get(opParam, Const::get(nam), p); }
     // Clone
     virtual Exp *clone() const override;
+    Exp *shallowCopy() const override;
 
     void setProc(UserProc *p) { proc = p; }
     UserProc *getProc() { return proc; }
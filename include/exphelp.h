@@ -17,6 +17,9 @@
 
 #include <map>
 #include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "smallvector.h"
 class Exp;
 class Assign;
 class Assignment;
@@ -52,4 +55,73 @@ struct lessAssign : public std::binary_function<Assign *, Assign *, bool> {
     bool operator()(const Assign *x, const Assign *y) const;
 };
 
+/**
+ * Hash-consing of immutable expressions. Each distinct internable expression structure gets one canonical node, owned
+ * by the interner, with a cached structural hash. Canonical nodes are made of canonical subexpressions, so two
+ * canonical nodes of one interner are equal (operator==) exactly when they are the same node.
+ * Internable are integer, float and string constants (without conscripts), terminals other than wildcards, and unary,
+ * binary and ternary expressions (including locations) of internable subexpressions; e.g. r[28] and m[r[28] - 4], but
+ * not r[28]{5} or typed expressions.
+ * \note Canonical nodes are shared and must never be modified; clone one to get a copy that can be changed.
+ */
+class ExpInterner {
+  public:
+    ExpInterner() = default;
+    ExpInterner(const ExpInterner &) = delete;
+    ExpInterner &operator=(const ExpInterner &) = delete;
+    ~ExpInterner();
+
+    const Exp *intern(const Exp *e);
+    uint32_t hashOf(const Exp *canonical) const;
+    bool isCanonical(const Exp *e) const { return Hashes.count(e) != 0; }
+    size_t size() const { return Hashes.size(); }
+    void clear();
+
+    static bool isInternable(const Exp *e);
+
+  private:
+    const Exp *internSub(const Exp *e, uint32_t &hash);
+    std::unordered_multimap<uint32_t, const Exp *> Table; //!< Canonical nodes by structural hash
+    std::unordered_map<const Exp *, uint32_t> Hashes;      //!< Structural hash of each canonical node
+};
+
+/**
+ * A class for ordering canonical expressions of an ExpInterner: by structural hash, then by address. Much cheaper than
+ * lessExpStar, but a different order
+ */
+struct lessInterned : public std::binary_function<const Exp *, const Exp *, bool> {
+    const ExpInterner *interner;
+    explicit lessInterned(const ExpInterner *in) : interner(in) {}
+    bool operator()(const Exp *x, const Exp *y) const {
+        uint32_t hx = interner->hashOf(x), hy = interner->hashOf(y);
+        return hx != hy ? hx < hy : x < y;
+    }
+};
+
+/**
+ * Receives the matches of a search (Exp::searchEach, Instruction::searchEach) one at a time, so that they need not be
+ * collected in a list, and the search can stop early.
+ */
+class SearchCallback {
+  public:
+    virtual ~SearchCallback() {}
+    //! Called for each match, in the order searchAll would list them. \a pp points to the pointer to the match (for a
+    //! top level expression, to a temporary copy of it). Return false to stop the search.
+    virtual bool found(Exp **pp) = 0;
+};
+
+//! A SearchCallback that passes each match (an Exp *) to a function object returning false to stop the search
+template <class Func> class SearchFunction : public SearchCallback {
+  public:
+    explicit SearchFunction(Func f) : F(f) {}
+    bool found(Exp **pp) override { return F(*pp); }
+
+  private:
+    Func F;
+};
+//! E.g. auto cb = searchWith([&](Exp *e) { ...; return true; }); s->searchEach(pattern, cb);
+template <class Func> SearchFunction<Func> searchWith(Func f) { return SearchFunction<Func>(f); }
+
+typedef SmallVector<Exp *, 8> ExpMatches; //!< Results of searchAll; a few matches need no heap allocation
+
 #endif // __EXPHELP_H__
@@ -109,6 +109,11 @@ public:
     // virtual    int            getInst(int addr);
 
     virtual DecodeResult &decodeInstruction(ADDRESS pc);
+    // Decode a straight-line run of instructions (up to and including the first CTI)
+    virtual int decodeInstructions(ADDRESS pc, DecodeResult *results, int maxCount);
+    //! Maximum number of instructions processProc gets from the decoder in one go
+    static const int DECODE_RUN_SIZE = 16;
+    static void discardDecoded(DecodeResult *results, int count);
 
     virtual void extraProcessCall(CallStatement * /*call*/, std::list<RTL *> * /*BB_rtls*/) {}
 
@@ -196,11 +201,18 @@ public:
      * incomplete in these cases, and needs to be restarted from scratch
      */
     void addDecodedRtl(ADDRESS a, RTL *rtl) { previouslyDecoded[a] = rtl; }
+    /**
+     * Put the previously decoded RTLs back into the (restored, as decoded) CFG of \a pProc, and decode only the new
+     * targets they lead to, instead of restarting the decode from scratch. Returns false if the CFG has to be
+     * decoded from scratch instead, in which case the CFG has not been changed.
+     */
+    bool decodeNewTargets(UserProc *pProc);
     void preprocessProcGoto(std::list<Instruction *>::iterator ss, ADDRESS dest, const std::list<Instruction *> &sl,
                             RTL *pRtl);
     void checkEntryPoint(std::vector<ADDRESS> &entrypoints, ADDRESS addr, const char *type);
 private:
     bool refersToImportedFunction(Exp *pDest);
+    RTL *analysedReplacement(BasicBlock *pBB);
     SymTab * BinarySymbols;
 }; // class FrontEnd
 
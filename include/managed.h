@@ -16,15 +16,22 @@
   *                StatementVec
   *                LocationSet
   *                //LocationList
+  *                BitSet
+  *                LocationNumbering
+  *                DefUseIndex
   *                ConnectionGraph
+  *                InterferenceGraph
   *==============================================================================================*/
 
 #ifndef __MANAGED_H__
 #define __MANAGED_H__
 #include "exphelp.h" // For lessExpStar
 
+#include <cstdint>
 #include <list>
+#include <map>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 class Instruction;
@@ -33,7 +40,9 @@ class Exp;
 class RefExp;
 class Cfg;
 class LocationSet;
+class BitSet;
 class QTextStream;
+class UserProc;
 
 // A class to implement sets of statements
 class InstructionSet : public std::set<Instruction *> {
@@ -51,6 +60,8 @@ class InstructionSet : public std::set<Instruction *> {
     bool exists(Instruction *s);                   // Search; returns false if !found
     bool definesLoc(Exp *loc);                   // Search; returns true if any
                                                  // statement defines loc
+    bool toBits(BitSet &bits) const;             // As a BitSet of statement numbers; false if any is unnumbered
+    void fromBits(const BitSet &bits, const std::vector<Instruction *> &byNumber); // Insert statements by number
     bool operator<(const InstructionSet &o) const; // Compare if less
     void print(QTextStream &os) const;          // Print to os
     void printNums(QTextStream &os);            // Print statements as numbers
@@ -153,11 +164,12 @@ class LocationSet {
     LocationSet &operator=(const LocationSet &o); // Assignment
     void makeUnion(LocationSet &other);           // Set union
     void makeDiff(LocationSet &other);            // Set difference
+    bool isSubSetOf(const LocationSet &other) const; // Subset relation
     void clear() { lset.clear(); }                // Clear the set
     iterator begin() { return lset.begin(); }
     iterator end() { return lset.end(); }
     const_iterator begin() const { return lset.begin(); }
-    const_iterator end() const { return lset.begin(); }
+    const_iterator end() const { return lset.end(); }
     void insert(Exp *loc) { lset.insert(loc); }  // Insert the given location
     void remove(Exp *loc);                       // Remove the given location
     void remove(iterator ll) { lset.erase(ll); } // Remove location, given iterator
@@ -180,6 +192,114 @@ class LocationSet {
     void addSubscript(Instruction *def /* , Cfg* cfg */); // Add a subscript to all elements
 };                                                      // class LocationSet
 
+/***************************************************************************/ /**
+  * \class BitSet
+  * A set of small non-negative integers held as a bit vector. Statements are dense by number (see
+  * UserProc::numberStatements) and locations can be made so with a LocationNumbering, so this is a compact
+  * alternative to InstructionSet and LocationSet for analyses that do many unions, differences and subset tests: these
+  * work a 64 bit word at a time, in loops the compiler can vectorise, instead of walking trees.
+  ******************************************************************************/
+class BitSet {
+    std::vector<uint64_t> Words; //!< Bit i of the set is bit i%64 of Words[i/64]; may have trailing zero words
+
+  public:
+    BitSet() {}
+    explicit BitSet(size_t capacity) : Words((capacity + 63) / 64) {} //!< Empty, with room for 0..capacity-1
+
+    void insert(size_t i) {
+        if (i / 64 >= Words.size())
+            Words.resize(i / 64 + 1);
+        Words[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    void remove(size_t i) {
+        if (i / 64 < Words.size())
+            Words[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+    bool exists(size_t i) const { return i / 64 < Words.size() && (Words[i / 64] >> (i % 64)) & 1; }
+    void clear() { Words.clear(); }
+
+    // These return true if this set changed, so they can drive a fixed point iteration
+    bool makeUnion(const BitSet &other);
+    bool makeDiff(const BitSet &other);
+    bool makeIsect(const BitSet &other);
+    bool isSubSetOf(const BitSet &other) const;
+    size_t size() const; // Number of elements
+    bool empty() const;
+    bool operator==(const BitSet &other) const;
+    bool operator!=(const BitSet &other) const { return !(*this == other); }
+
+    //! Call f(i) for each element i, in increasing order
+    template <class F> void forEach(F f) const {
+        for (size_t w = 0; w < Words.size(); w++) {
+            size_t i = w * 64;
+            for (uint64_t bits = Words[w]; bits; bits >>= 1, i++) {
+                if (bits & 1)
+                    f(i);
+            }
+        }
+    }
+};
+
+/***************************************************************************/ /**
+  * \class LocationNumbering
+  * Gives each distinct location (compared by value, as in LocationSet) a dense number, so that sets of locations can
+  * be held as BitSets. Numbers are never reused; the numbering owns a copy of each location.
+  ******************************************************************************/
+class LocationNumbering {
+    std::map<Exp *, size_t, lessExpStar> Numbers;
+    std::vector<Exp *> Locations; //!< Indexed by number
+
+  public:
+    LocationNumbering() {}
+    LocationNumbering(const LocationNumbering &) = delete;
+    LocationNumbering &operator=(const LocationNumbering &) = delete;
+    ~LocationNumbering() { clear(); }
+
+    size_t number(Exp *loc); // The number of loc, giving it the next one if it has none
+    int find(Exp *loc) const; // The number of loc, or -1 if it has none
+    Exp *location(size_t n) const { return Locations[n]; }
+    size_t size() const { return Locations.size(); }
+    void clear();
+
+    //! Call f(n) for each number n, in the order of the locations (as a LocationSet would hold them)
+    template <class F> void forEachInOrder(F f) const {
+        for (const auto &nn : Numbers)
+            f(nn.second);
+    }
+
+    void toBits(const LocationSet &ls, BitSet &bits);
+    void toLocationSet(const BitSet &bits, LocationSet &ls) const; // Inserts this numbering's own copies
+};
+
+/***************************************************************************/ /**
+  * \class DefUseIndex
+  * For each definition, the statements that use it (through a RefExp, ignoring uses in collectors), and for each
+  * statement, the definitions it uses. Each pair is held once, however many refs there are between the two, so the
+  * number of users of a definition is a reference count in the sense of UserProc::countRefs.
+  *
+  * The index is empty and invalid until build(). It is a snapshot: whoever builds it must tell it about statements it
+  * removes (removeStatement) or changes (addUses), and must not use it after anything else has changed the statements
+  * (e.g. propagation or renaming). So it is built for one pass and thrown away, not kept with the UserProc.
+  ******************************************************************************/
+class DefUseIndex {
+    std::unordered_map<Instruction *, std::vector<Instruction *>> Users; //!< Definition to the statements using it
+    std::unordered_map<Instruction *, std::vector<Instruction *>> Defs;  //!< Statement to the definitions it uses
+    bool Valid = false;
+
+  public:
+    void build(UserProc *proc);
+    void clear();
+    bool isValid() const { return Valid; }
+
+    const std::vector<Instruction *> &getUsers(Instruction *def) const;
+    const std::vector<Instruction *> &getDefs(Instruction *s) const;
+    size_t numUsers(Instruction *def) const { return getUsers(def).size(); }
+
+    void addUses(Instruction *s);         // Index the uses of s, replacing any indexed before
+    void removeUses(Instruction *s);      // Forget the uses of s
+    void removeStatement(Instruction *s); // Forget s, as user and as definition
+};
+
 /// A class to store connections in a graph, e.g. for interferences of types or live ranges, or the phi_unite relation
 /// that phi statements imply
 /// If a is connected to b, then b is automatically connected to a
@@ -207,6 +327,49 @@ class ConnectionGraph {
 private:
     std::vector<Exp *> allConnected(Exp *a);
 };
+
+/***************************************************************************/ /**
+  * \class InterferenceGraph
+  * The same relation as a ConnectionGraph built with connect(), over names numbered with a LocationNumbering: each
+  * name has an array of the names it is connected to, in the order they were added, and a BitSet of the same for the
+  * membership test. Like ConnectionGraph::connect(), connect(a, b) also connects a to everything b was connected to,
+  * and everything a was connected to to b, in that direction only; so the relation is not quite symmetric, and each
+  * name needs a full row rather than half a triangular matrix.
+  *
+  * forEachEdge() visits the pairs in the order a ConnectionGraph would iterate them, giving back the expressions
+  * first passed in for each name, so that what is done with them (e.g. by UserProc::fromSSAform) is unchanged.
+  ******************************************************************************/
+class InterferenceGraph {
+    LocationNumbering Names;
+    std::vector<Exp *> Given;                //!< The expression first given for each name
+    std::vector<std::vector<size_t>> Adj;    //!< Names connected to each name, in the order connected
+    std::vector<BitSet> Rows;                //!< The same, as a set
+
+  public:
+    size_t number(Exp *e); // The number of name e, numbering it if new
+    int find(Exp *e) const { return Names.find(e); }
+    Exp *name(size_t n) const { return Given[n]; }
+    size_t size() const { return Given.size(); }
+    const LocationNumbering &getNames() const { return Names; }
+
+    void connect(Exp *a, Exp *b) { connect(number(a), number(b)); }
+    void connect(size_t a, size_t b);
+    bool isConnected(size_t a, size_t b) const { return a < Rows.size() && Rows[a].exists(b); }
+    bool isConnected(Exp *a, const Exp &b) const;
+    size_t count(size_t a) const { return Adj[a].size(); }
+    void clear();
+
+    //! Call f(a, b) for each a connected to b, by the expressions first given for them
+    template <class F> void forEachEdge(F f) const {
+        Names.forEachInOrder([&](size_t a) {
+            for (size_t b : Adj[a])
+                f(Given[a], Given[b]);
+        });
+    }
+
+  private:
+    void add(size_t a, size_t b);
+};
 QTextStream &operator<<(QTextStream &os, const AssignSet *as);
 QTextStream &operator<<(QTextStream &os, const InstructionSet *ss);
 QTextStream &operator<<(QTextStream &os, const LocationSet *ls);
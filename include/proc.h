@@ -22,6 +22,7 @@
 #include "cfg.h" // For cfg->simplify()
 //#include "hllcode.h"
 #include "memo.h"
+#include "proofcache.h"
 #include "dataflow.h"  // For class UseCollector
 #include "statement.h" // For embedded ReturnStatement pointer, etc
 
@@ -258,6 +259,7 @@ public:
     Cfg *getCFG() { return cfg; }
     //! Returns a pointer to the DataFlow object.
     DataFlow *getDataFlow() { return &df; }
+    void getStatementsByNumber(std::vector<Instruction *> &byNumber) const;
     void deleteCFG() override;
     virtual bool isNoReturn() override;
 
@@ -290,7 +292,9 @@ public:
     void dumpLocals(QTextStream &os, bool html = false) const;
     void dumpLocals();
     //! simplify the statements in this proc
-    void simplify() { cfg->simplify(); }
+    void simplify();
+    //! If set, simplify() first passes the whole proc to this, e.g. EGraph::simplifyProc (see -te)
+    static void (*procSimplifier)(UserProc *proc);
     std::shared_ptr<ProcSet> decompile(ProcList *path, int &indent);
     void initialiseDecompile();
     void earlyDecompile();
@@ -346,6 +350,7 @@ public:
     bool isLocalOrParamPattern(Exp *e);
     bool existsLocal(const QString &name);
     bool isAddressEscapedVar(Exp *e) { return addressEscapedVars.exists(e); }
+    const LocationSet &getAddressEscapedVars() const { return addressEscapedVars; }
     bool isPropagatable(Exp *e);
     void assignProcsToCalls();
     void finalSimplify();
@@ -359,10 +364,10 @@ public:
     bool removeNullStatements();
     bool removeDeadStatements();
     typedef std::map<Instruction *, int> RefCounter;
-    void countRefs(RefCounter &refCounts);
+    void countRefs(RefCounter &refCounts, DefUseIndex &defUses);
 
     void remUnusedStmtEtc();
-    void remUnusedStmtEtc(RefCounter &refCounts /* , int depth*/);
+    void remUnusedStmtEtc(RefCounter &refCounts, DefUseIndex &defUses);
     void removeUnusedLocals();
     void mapTempsToLocals();
     void removeCallLiveness();
@@ -404,6 +409,7 @@ public:
     bool checkForGainfulUse(Exp *e, ProcSet &Visited);
     void updateForUseChange(std::set<UserProc *> &removeRetSet);
     bool prove(Binary * query, bool conditional = false);
+    bool proveUncached(Binary *query, bool conditional);
 
     bool prover(Exp *query, std::set<PhiAssign *> &lastPhis, std::map<PhiAssign *, Exp *> &cache,
                 PhiAssign *lastPhi = nullptr);
@@ -411,7 +417,7 @@ public:
     void getStatements(StatementList &stmts) const;
     virtual void removeReturn(Exp *e) override;
     void removeStatement(Instruction *stmt);
-    bool searchAll(const Exp &search, std::list<Exp *> &result);
+    bool searchAll(const Exp &search, ExpMatches &result);
 
     void getDefinitions(LocationSet &defs);
     void addImplicitAssigns();
@@ -484,9 +490,18 @@ public:
     /// \note final parameters don't use this information; it's only for handling recursion.
     void useBeforeDefine(Exp *loc) { col.insert(loc); }
     void processDecodedICTs();
+    void saveDecodedCfg();
+    bool reDecodeIncrementally();
+    MemoryArena *getArena();
+    SimplifyStats &getSimplifyStats() { return simplifyStats; }
+    const ProofStats &getProofStats() const { return proofStats; }
 
 private:
     ReturnStatement *theReturnStatement;
+    Cfg *decodedCfg = nullptr; //!< Copy of the CFG as decoded, for incremental re-decoding (-ir)
+    MemoryArena *Arena = nullptr; //!< Region for the Exps and Statements of this proc; owned by the Prog
+    SimplifyStats simplifyStats;  //!< Counters for the simplifications done while decoding and decompiling this proc
+    ProofStats proofStats;        //!< Counters for prove()
     mutable int DFGcount; //!< used in dotty output
 public:
     ADDRESS getTheReturnAddr() { return theReturnStatement == nullptr ? NO_ADDRESS : theReturnStatement->getRetAddr(); }
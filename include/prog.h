@@ -22,6 +22,9 @@
 #include "type.h"
 #include "module.h"
 #include "util.h"
+#include "arena.h"
+#include "proofcache.h"
+#include "callgraph.h"
 // TODO: refactor Prog Global handling into separate class
 class RTLInstDict;
 class Function;
@@ -111,9 +114,12 @@ public:
     void decodeEverythingUndecoded();
     void decodeFragment(UserProc *proc, ADDRESS a);
     void reDecode(UserProc *proc);
+    bool decodeNewTargets(UserProc *proc);
     bool wellForm();
     void finishDecode();
     void decompile();
+    //! The search for recursion groups done by UserProc::decompile
+    CallGraphSCCs &getRecursionGroups() { return RecursionGroups; }
     void removeUnusedGlobals();
     void removeRestoreStmts(InstructionSet &rs);
     void globalTypeAnalysis();
@@ -202,6 +208,14 @@ public:
     std::list<UserProc *> entryProcs;
 
     Module *getOrInsertModule(const QString &name, const ModuleFactory &fact=DefaultModFactory(), FrontEnd *frontend=nullptr);
+    MemoryArena *createArena(const QString &name);
+    MemoryArena *getGlobalArena() { return GlobalArena; }
+    void printArenaStats(QTextStream &os) const;
+    void printSimplifyStats(QTextStream &os);
+    void printProofStats(QTextStream &os);
+    void printPhiStats(QTextStream &os);
+    //! The results of UserProc::prove for all procs; see ProofCache for when to invalidate it
+    ProofCache &getProofCache() { return proofCache; }
 
     const ModuleListType &  getModuleList() const { return ModuleList; }
     ModuleListType       &  getModuleList()       { return ModuleList; }
@@ -228,7 +242,11 @@ protected:
     std::set<Global *> globals; //!< globals to print at code generation time
     DataIntervalMap globalMap;  //!< Map from address to DataInterval (has size, name, type)
     int m_iNumberedProc;        //!< Next numbered proc will use this
+    CallGraphSCCs RecursionGroups; //!< See getRecursionGroups()
     Module *m_rootCluster;     //!< Root of the cluster tree
+    std::list<MemoryArena> Arenas; //!< Regions of all the procs, released after the Modules are deleted
+    MemoryArena *GlobalArena;      //!< Region for the program level phases
+    ProofCache proofCache;
 
     friend class XMLProgParser;
 }; // class Prog
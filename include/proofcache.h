@@ -0,0 +1,115 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/***************************************************************************/ /**
+  * \file       proofcache.h
+  * OVERVIEW:   The results of UserProc::prove that were not saved in provenTrue, and a limit on the work done for
+  *             each query.
+  ******************************************************************************/
+#ifndef PROOFCACHE_H
+#define PROOFCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+class Exp;
+class UserProc;
+
+//! Counters for UserProc::prove, per proc
+struct ProofStats {
+    uint64_t Queries = 0;   //!< Calls of prove() not answered by provenTrue
+    uint64_t CacheHits = 0; //!< Of those, the ones answered by the ProofCache
+    uint64_t Exhausted = 0; //!< Queries given up as not proven because the step budget ran out
+};
+
+/***************************************************************************/ /**
+  * \class ProofCache
+  * Remembers the result of each query to UserProc::prove, keyed by the proc, the equation with both sides simplified,
+  * whether the query is conditional, and the premises assumed at the time in the proc's recursion group. Results
+  * depend on the statements of the procs and on what has been proven about their callees, so the cache must be
+  * invalidated when either changes. Proven results go to provenTrue as before, so this mostly saves repeating failed
+  * proofs.
+  *
+  * A query made while another is active (e.g. of a callee, through a call) records that the outer proc depends on the
+  * inner one. Invalidating a proc then also forgets the results of the procs that depend on it, directly or not, and
+  * keeps those of unrelated procs.
+  *
+  * Each outermost query also gets a budget of steps (iterations of UserProc::prover, including those of the queries
+  * it makes of other procs). When it runs out, the query fails: not proving a preservation is always safe.
+  ******************************************************************************/
+class ProofCache {
+  public:
+    //! A premise x = y assumed by a proc while proving something else in its recursion group
+    struct Premise {
+        UserProc *Proc;
+        Exp *Left;
+        Exp *Right;
+    };
+
+    ProofCache() {}
+    ProofCache(const ProofCache &) = delete;
+    ProofCache &operator=(const ProofCache &) = delete;
+    ~ProofCache() { invalidate(); }
+
+    bool find(UserProc *proc, Exp *query, bool conditional, const std::vector<Premise> &premises, bool &result) const;
+    void insert(UserProc *proc, Exp *query, bool conditional, const std::vector<Premise> &premises, bool result);
+    void invalidate(UserProc *proc);
+    void invalidate();
+    size_t size() const { return Results.size(); }
+
+    //! Brackets one call of prove() for \a proc. The outermost one starts a new budget of at most \a budget steps
+    //! (0: no limit).
+    class Query {
+      public:
+        Query(ProofCache &cache, UserProc *proc, uint64_t budget) : Cache(cache) {
+            if (Cache.Active.empty()) {
+                Cache.Budget = budget;
+                Cache.Steps = 0;
+                Cache.Exhausted = false;
+            } else if (Cache.Active.back() != proc)
+                Cache.Dependents[proc].insert(Cache.Active.back());
+            Cache.Active.push_back(proc);
+        }
+        ~Query() { Cache.Active.pop_back(); }
+
+      private:
+        ProofCache &Cache;
+    };
+    //! Count a step of the current query; false once the budget has run out
+    bool step() {
+        if (Budget && ++Steps > Budget)
+            Exhausted = true;
+        return !Exhausted;
+    }
+    bool isExhausted() const { return Exhausted; }
+    bool isActive() const { return !Active.empty(); } //!< True while inside a query
+
+  private:
+    struct Key {
+        UserProc *Proc;
+        Exp *Query;
+        bool Conditional;
+        std::vector<Premise> Premises;
+    };
+    struct KeyLess {
+        bool operator()(const Key &a, const Key &b) const;
+    };
+    static void release(const Key &key);
+
+    std::map<Key, bool, KeyLess> Results; //!< The keys own their expressions
+    //! For each proc, the procs that queried it from their own queries, so their results may depend on its
+    std::map<UserProc *, std::set<UserProc *>> Dependents;
+    std::vector<UserProc *> Active; //!< The procs of the queries in progress, outermost first
+    uint64_t Budget = 0;
+    uint64_t Steps = 0;
+    bool Exhausted = false;
+};
+
+#endif
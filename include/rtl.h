@@ -35,6 +35,7 @@
 #include <utility>                      // for pair
 #include <vector>                       // for vector
 #include <QMap>
+#include <QByteArray>
 #include <memory>
 
 class Exp;  // lines 38-38
@@ -48,8 +49,11 @@ typedef std::shared_ptr<class RTL> SharedRTL;
   * Class RTL: describes low level register transfer lists (actually lists of statements).
   * \note when time permits, this class could be removed, replaced with new Statements that mark the current native
   * address
+  * \note The statements are kept in a vector: most RTLs hold one to three of them, so they are stored together
+  * rather than one heap node each. Inserting or erasing invalidates iterators at and after that point; use the
+  * iterator returned by insert() and erase().
   ******************************************************************************/
-class RTL : public std::list<Instruction *> {
+class RTL : public std::vector<Instruction *> {
     ADDRESS nativeAddr; // RTL's source program instruction address
   public:
     RTL();
@@ -67,7 +71,9 @@ class RTL : public std::list<Instruction *> {
 
     // Statement list editing methods
     void appendStmt(Instruction *s); // Add s to end of RTL.
-    void appendListStmt(std::list<Instruction *> &le);
+    void appendListStmt(const RTL &le);
+    void push_front(Instruction *s) { insert(begin(), s); }
+    void pop_front() { erase(begin()); }
     // Make a deep copy of the list of Exp*
     void deepCopyList(std::list<Instruction *> &dest) const;
 
@@ -136,6 +142,25 @@ class ParamEntry {
     SharedType m_type;
 };
 
+/***************************************************************************/ /**
+  * The NameIndex class is a perfect (collision free) hash of a fixed set of names to dense slot numbers
+  * 0 .. size-1, built once the set is known. Lookups by C string don't allocate.
+  ******************************************************************************/
+class NameIndex {
+  public:
+    void build(const std::vector<QString> &names);
+    void clear();
+    int find(const char *name) const;
+    size_t size() const { return Names.size(); }
+
+  private:
+    static uint32_t hash(const char *s, size_t len, uint32_t seed);
+    uint32_t Seed = 0;
+    uint32_t Mask = 0;
+    std::vector<int> Slots; //!< Index into Names, or -1 for an empty table entry
+    std::vector<QByteArray> Names;
+};
+
 /***************************************************************************/ /**
   * The RTLInstDict represents a dictionary that maps instruction names to the
   * parameters they take and a template for the Exp list describing their
@@ -164,6 +189,12 @@ class RTLInstDict {
     void addRegister(const QString &name, int id, int size, bool flt);
     bool partialType(Exp *exp, Type &ty);
     void fixupParams();
+    void buildIndices();
+
+    int getRegIdx(const char *name) const;
+    QString getRegName(int idx) const;
+    int getRegSize(int idx) const;
+    ParamEntry *getParam(const char *name) const;
 
   public:
     //! A map from the symbolic representation of a register (e.g. "%g0") to its index within an array of registers.
@@ -199,6 +230,16 @@ class RTLInstDict {
     SharedRTL fetchExecCycle;
 
     void fixupParamsSub(const QString &s, std::list<QString> &funcParams, bool &haveCount, int mark);
+
+  private:
+    //! Lookup tables built from the maps above by buildIndices(), since the registers and parameters don't change
+    //! after the SSL file has been read
+    NameIndex RegIndex;                //!< Perfect hash of the register names in RegMap
+    std::vector<int> RegIdxBySlot;     //!< Register index for each slot of RegIndex
+    std::vector<QString> RegNameByIdx; //!< Name of each register index (first one in RegMap if aliased)
+    std::vector<int> RegSizeByIdx;     //!< Size in bits of each register in DetRegMap, 0 if not defined
+    NameIndex ParamIndex;              //!< Perfect hash of the parameter names in DetParamMap
+    std::vector<ParamEntry *> ParamBySlot;
 };
 
 #endif /*__RTL_H__*/
@@ -0,0 +1,90 @@
+#ifndef __SMALLVECTOR_H__
+#define __SMALLVECTOR_H__
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/***************************************************************************/ /**
+  * \file        smallvector.h
+  * OVERVIEW:    A vector that keeps its first few elements inside the object.
+  ******************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+/***************************************************************************/ /**
+  \class  SmallVector
+   A vector of trivially copyable elements (e.g. pointers) whose first N elements are stored in the object itself, so
+   a short list of results on the stack costs no heap allocation. It moves to the heap when it grows past N.
+  ******************************************************************************/
+template <class T, size_t N> class SmallVector {
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVector only holds trivially copyable elements");
+
+  public:
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+
+    SmallVector() : Data(Inline), Size(0), Capacity(N) {}
+    SmallVector(const SmallVector &o) : SmallVector() { *this = o; }
+    SmallVector &operator=(const SmallVector &o) {
+        if (this != &o) {
+            clear();
+            for (const T &x : o)
+                push_back(x);
+        }
+        return *this;
+    }
+    ~SmallVector() {
+        if (Data != Inline)
+            delete[] Data;
+    }
+
+    void push_back(const T &x) {
+        if (Size == Capacity)
+            grow();
+        Data[Size++] = x;
+    }
+    void clear() { Size = 0; } //!< Keeps the heap storage, if any, for reuse
+    size_t size() const { return Size; }
+    bool empty() const { return Size == 0; }
+    bool isInline() const { return Data == Inline; } //!< True if no heap storage has been needed
+
+    T &operator[](size_t i) {
+        assert(i < Size);
+        return Data[i];
+    }
+    const T &operator[](size_t i) const {
+        assert(i < Size);
+        return Data[i];
+    }
+    T &front() { return (*this)[0]; }
+    T &back() { return (*this)[Size - 1]; }
+    iterator begin() { return Data; }
+    iterator end() { return Data + Size; }
+    const_iterator begin() const { return Data; }
+    const_iterator end() const { return Data + Size; }
+
+  private:
+    void grow() {
+        size_t capacity = Capacity * 2;
+        T *data = new T[capacity];
+        std::copy(Data, Data + Size, data);
+        if (Data != Inline)
+            delete[] Data;
+        Data = data;
+        Capacity = capacity;
+    }
+
+    T Inline[N];
+    T *Data; //!< Inline, or heap storage once there were more than N elements
+    size_t Size;
+    size_t Capacity;
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include "config.h"
 
 #include "memo.h"
+#include "arena.h"
 #include "exphelp.h" // For lessExpStar, lessAssignment etc
 #include "types.h"
 #include "managed.h"
@@ -139,6 +140,12 @@ public:
     Instruction() : Parent(nullptr), proc(nullptr), Number(0) {} //, parent(nullptr)
     virtual ~Instruction() {}
 
+    // Statements are allocated from the current MemoryArena (see arena.h)
+    static void *operator new(size_t size) { return MemoryArena::allocate(size); }
+    static void operator delete(void *p) { MemoryArena::deallocate(p); }
+    static void *operator new(size_t, void *where) { return where; } // For construction in place
+    static void operator delete(void *, void *) {}
+
     // get/set the enclosing BB, etc
     BasicBlock *getBB() { return Parent; }
     const BasicBlock *getBB() const { return Parent; }
@@ -230,7 +237,10 @@ public:
 
     // general search
     virtual bool search(const Exp &search, Exp *&result) = 0;
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result) = 0;
+    // Pass each match of search in this statement's expressions to cb; returns false if cb stopped the search
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) = 0;
+    bool searchAll(const Exp &search, std::list<Exp *> &result);
+    bool searchAll(const Exp &search, ExpMatches &result);
 
     // general search and replace. Set cc true to change collectors as well. Return true if any change
     virtual bool searchAndReplace(const Exp &search, Exp *replace, bool cc = false) = 0; // TODO: consider constness
@@ -393,7 +403,6 @@ public:
 
     // general search
     virtual bool search(const Exp &search, Exp *&result) = 0;
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result) = 0;
 
     // general search and replace
     virtual bool searchAndReplace(const Exp &search, Exp *replace, bool cc = false) = 0;
@@ -461,7 +470,7 @@ public:
 
     // general search
     virtual bool search(const Exp &search, Exp *&result) override;
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result) override;
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
 
     // general search and replace
     virtual bool searchAndReplace(const Exp &search, Exp *replace, bool cc = false) override;
@@ -549,7 +558,7 @@ public:
 
     // general search
     virtual bool search(const Exp &search, Exp *&result);
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result);
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
 
     // general search and replace
     virtual bool searchAndReplace(const Exp &search, Exp *replace, bool cc = false);
@@ -614,7 +623,7 @@ public:
 
     // general search
     virtual bool search(const Exp &search, Exp *&result);
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result);
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
 
     // general search and replace
     virtual bool searchAndReplace(const Exp &search, Exp *replace, bool cc = false);
@@ -681,7 +690,7 @@ public:
     virtual Exp *getRight() { return getCondExpr(); }
     virtual bool usesExp(const Exp &e);
     virtual bool search(const Exp &search, Exp *&result);
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result);
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
     virtual bool searchAndReplace(const Exp &search, Exp *replace, bool cc = false);
     // a hack for the SETS macro
     void setLeftFromList(std::list<Instruction *> *stmts);
@@ -712,7 +721,7 @@ public:
     virtual bool isDefinition()  override { return false; }
     virtual bool usesExp(const Exp &)  override { return false; }
     virtual bool search(const Exp &, Exp *&) override;
-    virtual bool searchAll(const Exp &, std::list<Exp *, std::allocator<Exp *>> &) override;
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
     virtual bool searchAndReplace(const Exp &, Exp *, bool cc = false) override;
     virtual void generateCode(HLLCode *, BasicBlock *, int)  override {}
     virtual void simplify() override;
@@ -777,7 +786,7 @@ public:
 
     // Searches for all instances of a given subexpression within this
     // expression and adds them to a given list in reverse nesting order.
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result) override;
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
 
     // code generation
     virtual void generateCode(HLLCode *, BasicBlock *, int) override;
@@ -813,7 +822,7 @@ public:
 
     // general search
     bool search(const Exp & /*search*/, Exp *& /*result*/)  override { return false; }
-    bool searchAll(const Exp & /*search*/, std::list<Exp *> & /*result*/)  override { return false; }
+    bool searchEach(const Exp & /*search*/, SearchCallback & /*cb*/) override { return true; }
 
     //! general search and replace. Set cc true to change collectors as well. Return true if any change
     bool searchAndReplace(const Exp & /*search*/, Exp * /*replace*/, bool /*cc*/ = false)  override { return false; }
@@ -880,7 +889,7 @@ public:
 
     // Searches for all instances of a given subexpression within this
     // expression and adds them to a given list in reverse nesting order.
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result) override;
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
 
     // code generation
     virtual void generateCode(HLLCode *, BasicBlock *, int) override;
@@ -941,7 +950,7 @@ public:
 
     // Searches for all instances of a given subexpression within this
     // expression and adds them to a given list in reverse nesting order.
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result);
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
 
     // code generation
     virtual void generateCode(HLLCode *, BasicBlock *, int);
@@ -1029,7 +1038,7 @@ public:
     Signature *getSignature() { return signature; }
     void setSignature(Signature *sig) { signature = sig;} ///< Only used by range analysis
     // Localise the various components of expression e with reaching definitions to this call
-    // Note: can change e so usually need to clone the argument
+    // Note: e is not changed, but may be returned as is (before data flow), so clone the result before changing it
     // Was called substituteParams
     Exp *localiseExp(Exp *e);
     void localiseComp(Exp *e); // Localise only xxx of m[xxx]
@@ -1060,7 +1069,7 @@ public:
 
     // Searches for all instances of a given subexpression within this
     // expression and adds them to a given list in reverse nesting order.
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result) override;
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
 
     // Set and return whether the call is effectively followed by a return.
     // E.g. on Sparc, whether there is a restore in the delay slot.
@@ -1193,7 +1202,7 @@ public:
     virtual bool searchAndReplace(const Exp &search, Exp *replace, bool cc = false) override;
 
     // Searches for all instances of a given subexpression within this statement and adds them to a given list
-    virtual bool searchAll(const Exp &search, std::list<Exp *> &result) override;
+    virtual bool searchEach(const Exp &search, SearchCallback &cb) override;
 
     // returns true if this statement uses the given expression
     virtual bool usesExp(const Exp &e) override;
@@ -9,16 +9,25 @@
 #pragma once
 #include <list>
 class Exp;
+class RuleIndex;
 class ExpTransformer {
   protected:
     static std::list<ExpTransformer *> transformers;
+    static RuleIndex *ruleIndex; //!< Built from transformers on first use; see compileRules()
 
   public:
     ExpTransformer();
     virtual ~ExpTransformer() {} // Prevent gcc4 warning
 
     static void loadAll();
+    static void compileRules();
+    static void clearCache();
+    static const std::list<ExpTransformer *> &getTransformers() { return transformers; }
+    static bool useRuleIndex; //!< If false, applyAllTo tries every transformer on every node (for benchmarking)
 
+    //! The expression this transformer applies to (pattern variables match anything), or nullptr if it has to be
+    //! tried on every expression
+    virtual const Exp *getPattern() const { return nullptr; }
     virtual Exp *applyTo(Exp *e, bool &bMod) = 0;
     static Exp *applyAllTo(Exp *e, bool &bMod);
 };
@@ -56,6 +56,7 @@ class XMLProgParser {
     XMLProgParser() {}
     Prog *parse(const QString &filename);
     void persistToXML(Prog *prog);
+    void persistToXML(QXmlStreamWriter &out, const RTL *rtl);
     void handleElementStart(QXmlStreamReader &strm);
     void handleElementEnd(const QXmlStreamReader &el);
 
@@ -146,7 +147,6 @@ class XMLProgParser {
     void persistToXML(QXmlStreamWriter &out, const Exp *e);
     void persistToXML(QXmlStreamWriter &out, Cfg *cfg);
     void persistToXML(QXmlStreamWriter &out, const BasicBlock *bb);
-    void persistToXML(QXmlStreamWriter &out, const RTL *rtl);
     void persistToXML(QXmlStreamWriter &out, const Instruction *stmt);
 
     static _tag tags[];
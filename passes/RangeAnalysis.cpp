@@ -187,8 +187,8 @@ struct RangeVisitor : public StmtVisitor {
     }
 
     bool visit(Assign *insn) {
-        static Unary search_term(opTemp, Terminal::get(opWild));
-        static Unary search_regof(opRegOf, Terminal::get(opWild));
+        static Unary &search_term = *onHeap([] { return new Unary(opTemp, Terminal::get(opWild)); });
+        static Unary &search_regof = *onHeap([] { return new Unary(opRegOf, Terminal::get(opWild)); });
         RangeMap output = getInputRanges(insn);
         Exp *a_lhs = insn->getLeft()->clone();
         if (a_lhs->isFlags()) {
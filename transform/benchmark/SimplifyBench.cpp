@@ -0,0 +1,220 @@
+/***************************************************************************/ /**
+  * \file       SimplifyBench.cpp
+  * OVERVIEW:   Simplifier benchmark. A fixed, pseudo random set of integer, logical and memory expressions is
+  *             simplified with the built in polySimplify, and with the rules of the .t files in transformations/,
+  *             both trying every rule on every node and using the rule index, and with the e-graph simplifier,
+  *             with one graph for all of them. The time taken, the number of
+  *             expressions changed, and a checksum of the results are reported for each. The two rule based runs
+  *             must give the same checksum.
+  *
+  *             usage: SimplifyBench [-b base_dir] [-n count] [-s seed] [-r repeat_count]
+  ******************************************************************************/
+#include "types.h"
+#include "exp.h"
+#include "transformer.h"
+#include "transform/egraph.h"
+#include "boomerang.h"
+#include "log.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QProcessEnvironment>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <vector>
+
+//! Small deterministic generator, so every run simplifies the same expressions
+class ExpGenerator {
+  public:
+    explicit ExpGenerator(uint32_t seed) : State(seed ? seed : 1) {}
+    Exp *generate(int depth);
+
+  private:
+    uint32_t next() {
+        State ^= State << 13;
+        State ^= State >> 17;
+        State ^= State << 5;
+        return State;
+    }
+    Exp *leaf();
+    uint32_t State;
+};
+
+Exp *ExpGenerator::leaf() {
+    switch (next() % 4) {
+    case 0:
+        return Location::regOf(24 + next() % 8);
+    case 1:
+        return Location::memOf(Location::regOf(24 + next() % 8));
+    case 2:
+        return new Const(int(next() % 5)); // Small constants, so that x + 0, x * 1 etc. are common
+    default:
+        return new Const(int(next() % 256) - 128);
+    }
+}
+
+Exp *ExpGenerator::generate(int depth) {
+    if (depth == 0 || next() % 4 == 0)
+        return leaf();
+    static const OPER binOps[] = {opPlus, opPlus, opMinus, opMinus, opMult, opBitAnd, opBitXor, opEquals, opNotEqual};
+    switch (next() % 8) {
+    case 0:
+        return new Unary(opNeg, generate(depth - 1));
+    case 1:
+        return new Unary(opLNot, new Binary(next() % 2 ? opEquals : opNotEqual, generate(depth - 1),
+                                            generate(depth - 1)));
+    case 2:
+        return Location::memOf(generate(depth - 1));
+    case 3:
+        return new Unary(opAddrOf, Location::memOf(generate(depth - 1)));
+    default: {
+        OPER op = binOps[next() % (sizeof(binOps) / sizeof(binOps[0]))];
+        Exp *e1 = generate(depth - 1);
+        // Repeat the left operand now and then, for x - x, x & x, (x * k) - x and so on
+        Exp *e2 = next() % 4 == 0 ? e1->clone() : generate(depth - 1);
+        return Binary::get(op, e1, e2);
+    }
+    }
+}
+
+struct BenchStats {
+    uint64_t numChanged = 0;
+    qint64 nsecs = 0;
+    uint32_t checksum = 2166136261u; //!< FNV-1a of the printed results
+};
+
+static void addToChecksum(uint32_t &checksum, const QByteArray &data) {
+    for (char c : data)
+        checksum = (checksum ^ (uint8_t)c) * 16777619u;
+}
+
+/***************************************************************************/ /**
+  * \brief Simplify a copy of each input with the current setting of Exp::ruleSimplifier
+  * \param withChecksum - if true, add the text of the results to the checksum (only done for the first pass, so
+  *        the checksum does not depend on the repeat count)
+  ******************************************************************************/
+static void simplifyAll(const std::vector<Exp *> &inputs, BenchStats &stats, bool withChecksum) {
+    QElapsedTimer timer;
+    QString text;
+    for (Exp *input : inputs) {
+        Exp *e = input->clone();
+        timer.start();
+        e = e->simplify();
+        stats.nsecs += timer.nsecsElapsed();
+        if (withChecksum) {
+            if (!(*e == *input))
+                stats.numChanged++;
+            text.clear();
+            QTextStream os(&text);
+            os << e << "\n";
+            os.flush();
+            addToChecksum(stats.checksum, text.toUtf8());
+        }
+    }
+}
+
+/***************************************************************************/ /**
+  * \brief Simplify copies of all the inputs together in one e-graph, as EGraph::simplifyProc does for the statements
+  * of a procedure
+  ******************************************************************************/
+static void simplifyBatch(const std::vector<Exp *> &inputs, BenchStats &stats, bool withChecksum) {
+    std::vector<Exp *> exps;
+    for (Exp *input : inputs)
+        exps.push_back(input->clone());
+    QElapsedTimer timer;
+    timer.start();
+    EGraph::Budget budget;
+    budget.MaxNodes = 50 * inputs.size();
+    budget.MaxSteps = 50 * budget.MaxNodes;
+    EGraph graph(budget);
+    for (Exp *e : exps)
+        graph.add(e);
+    graph.saturate();
+    for (Exp *&e : exps)
+        e = graph.extract(e);
+    stats.nsecs += timer.nsecsElapsed();
+    if (!withChecksum)
+        return;
+    QString text;
+    for (size_t i = 0; i < exps.size(); i++) {
+        if (!(*exps[i] == *inputs[i]))
+            stats.numChanged++;
+        text.clear();
+        QTextStream os(&text);
+        os << exps[i] << "\n";
+        os.flush();
+        addToChecksum(stats.checksum, text.toUtf8());
+    }
+}
+
+static void report(QTextStream &out, const QString &name, int count, int repeat, const BenchStats &stats) {
+    double secs = stats.nsecs / 1e9;
+    out << qSetFieldWidth(24) << left << name << qSetFieldWidth(0) << right;
+    out << " exps/s " << (secs > 0 ? qint64(double(count) * repeat / secs) : 0);
+    out << " changed " << stats.numChanged << "/" << count;
+    out << " checksum " << QString::number(stats.checksum, 16).rightJustified(8, '0') << "\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QString base = QProcessEnvironment::systemEnvironment().value("BOOMERANG_TEST_BASE", "..");
+    int count = 20000;
+    int repeat = 1;
+    uint32_t seed = 1;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        if (args[i] == "-b" && i + 1 < args.size())
+            base = args[++i];
+        else if (args[i] == "-n" && i + 1 < args.size())
+            count = std::max(1, args[++i].toInt());
+        else if (args[i] == "-s" && i + 1 < args.size())
+            seed = args[++i].toUInt();
+        else if (args[i] == "-r" && i + 1 < args.size())
+            repeat = std::max(1, args[++i].toInt());
+        else {
+            out << "usage: " << args[0] << " [-b base_dir] [-n count] [-s seed] [-r repeat_count]\n";
+            return 1;
+        }
+    }
+    QDir baseDir(base);
+    Boomerang::get()->setProgPath(baseDir.absolutePath());
+    Boomerang::get()->setLogger(new NullLogger());
+    ExpTransformer::loadAll();
+
+    ExpGenerator gen(seed);
+    std::vector<Exp *> inputs;
+    for (int i = 0; i < count; i++)
+        inputs.push_back(gen.generate(4));
+
+    BenchStats poly, linear, indexed, batched;
+    for (int i = 0; i < repeat; i++) {
+        Exp::ruleSimplifier = nullptr;
+        simplifyAll(inputs, poly, i == 0);
+
+        Exp::ruleSimplifier = ExpTransformer::applyAllTo;
+        ExpTransformer::useRuleIndex = false;
+        ExpTransformer::clearCache();
+        simplifyAll(inputs, linear, i == 0);
+
+        ExpTransformer::useRuleIndex = true;
+        ExpTransformer::clearCache();
+        simplifyAll(inputs, indexed, i == 0);
+
+        Exp::ruleSimplifier = nullptr;
+        simplifyBatch(inputs, batched, i == 0);
+    }
+    Exp::ruleSimplifier = nullptr;
+    report(out, "polySimplify", count, repeat, poly);
+    report(out, "rules, every rule", count, repeat, linear);
+    report(out, "rules, indexed", count, repeat, indexed);
+    report(out, "e-graph, one graph", count, repeat, batched);
+    if (linear.checksum != indexed.checksum) {
+        out << "error: the indexed rules give different results\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,766 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ */
+/***************************************************************************/ /**
+  * \file       egraph.cpp
+  * OVERVIEW:   Implementation of the EGraph class.
+  ******************************************************************************/
+
+#include "egraph.h"
+
+#include "exp.h"
+#include "generic.h"
+#include "transformer.h"
+#include "statement.h"
+#include "managed.h"
+#include "proc.h"
+#include "visitor.h"
+#include "boomerang.h"
+#include "log.h"
+
+#include <cassert>
+#include <climits>
+
+extern const char *operStrings[];
+
+EGraph::Budget EGraph::DefaultBudget;
+
+namespace {
+const unsigned INFINITE_COST = UINT_MAX;
+
+bool isCommutative(int op) {
+    switch (op) {
+    case opPlus:
+    case opMult:
+    case opMults:
+    case opBitAnd:
+    case opBitOr:
+    case opBitXor:
+    case opEquals:
+    case opNotEqual:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//! Operators for which (x op a) op b == x op (a op b)
+bool isAssociative(int op) { return isCommutative(op) && op != opEquals && op != opNotEqual; }
+
+//! Evaluate a binary operator on 32 bit integer constants, as the generated code would
+bool foldBinary(int op, int a, int b, int &res) {
+    uint32_t ua = (uint32_t)a, ub = (uint32_t)b;
+    switch (op) {
+    case opPlus:
+        res = (int)(ua + ub);
+        return true;
+    case opMinus:
+        res = (int)(ua - ub);
+        return true;
+    case opMult:
+    case opMults:
+        res = (int)(ua * ub);
+        return true;
+    case opBitAnd:
+        res = (int)(ua & ub);
+        return true;
+    case opBitOr:
+        res = (int)(ua | ub);
+        return true;
+    case opBitXor:
+        res = (int)(ua ^ ub);
+        return true;
+    case opShiftL:
+        if (ub >= 32)
+            return false;
+        res = (int)(ua << ub);
+        return true;
+    case opShiftR:
+        if (ub >= 32)
+            return false;
+        res = (int)(ua >> ub);
+        return true;
+    case opShiftRA:
+        if (ub >= 32)
+            return false;
+        res = a < 0 ? (int)~(~ua >> ub) : (int)(ua >> ub);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool foldUnary(int op, int a, int &res) {
+    switch (op) {
+    case opNeg:
+        res = (int)(0u - (uint32_t)a);
+        return true;
+    case opNot:
+        res = ~a;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool usesTypes(const Exp *e) {
+    if (e == nullptr)
+        return false;
+    if (e->getOper() == opTypeOf || e->getOper() == opTypeVal)
+        return true;
+    int arity = e->getArity();
+    return (arity >= 1 && usesTypes(e->getSubExp1())) || (arity >= 2 && usesTypes(e->getSubExp2())) ||
+           (arity >= 3 && usesTypes(e->getSubExp3()));
+}
+
+QString varName(const Exp *pat) { return ((const Const *)pat->getSubExp1())->getStr(); }
+
+/***************************************************************************/ /**
+  * \brief Adds the top level expressions of the statements it is used on to an EGraph, and later replaces them with
+  * what the graph extracts for them. The subexpressions are handled by the graph, so the visit never recurses.
+  ******************************************************************************/
+class EGraphModifier : public ExpModifier {
+  public:
+    explicit EGraphModifier(EGraph &graph) : Graph(graph) {}
+    bool Extracting = false;
+
+    Exp *preVisit(Unary *e, bool &recur) override { return stop(e, recur); }
+    Exp *preVisit(Binary *e, bool &recur) override { return stop(e, recur); }
+    Exp *preVisit(Ternary *e, bool &recur) override { return stop(e, recur); }
+    Exp *preVisit(TypedExp *e, bool &recur) override { return stop(e, recur); }
+    Exp *preVisit(FlagDef *e, bool &recur) override { return stop(e, recur); }
+    Exp *preVisit(RefExp *e, bool &recur) override { return stop(e, recur); }
+    Exp *preVisit(Location *e, bool &recur) override { return stop(e, recur); }
+
+    Exp *postVisit(Unary *e) override { return visit(e); }
+    Exp *postVisit(Binary *e) override { return visit(e); }
+    Exp *postVisit(Ternary *e) override { return visit(e); }
+    Exp *postVisit(TypedExp *e) override { return visit(e); }
+    Exp *postVisit(FlagDef *e) override { return visit(e); }
+    Exp *postVisit(RefExp *e) override { return visit(e); }
+    Exp *postVisit(Location *e) override { return visit(e); }
+
+  private:
+    Exp *stop(Exp *e, bool &recur) {
+        recur = false;
+        return e;
+    }
+    Exp *visit(Exp *e) {
+        if (!Extracting) {
+            Graph.add(e);
+            return e;
+        }
+        Exp *res = Graph.extract(e);
+        if (res != e)
+            mod = true;
+        return res;
+    }
+    EGraph &Graph;
+};
+}
+
+EGraph::EGraph(const Budget &budget) : Limits(budget) {
+    for (ExpTransformer *t : ExpTransformer::getTransformers()) {
+        const GenericExpTransformer *rule = dynamic_cast<const GenericExpTransformer *>(t);
+        // Rules about types need the type of a subexpression, which the graph does not know
+        if (rule && rule->getPattern() && rule->getBecome() && !usesTypes(rule->getWhere()))
+            Rules.push_back(rule);
+    }
+}
+
+EGraph::~EGraph() {
+    for (Exp *e : Owned)
+        delete e;
+}
+
+size_t EGraph::NodeKeyHash::operator()(const NodeKey &k) const {
+    size_t h = std::hash<const void *>()(k.Payload) ^ ((size_t)k.Op * 0x9e3779b97f4a7c15ull);
+    for (ClassId c : k.Kids)
+        h = (h ^ c) * 0x100000001b3ull;
+    return h;
+}
+
+EGraph::ClassId EGraph::find(ClassId c) const {
+    while (Parent[c] != c) {
+        Parent[c] = Parent[Parent[c]]; // Path halving
+        c = Parent[c];
+    }
+    return c;
+}
+
+/***************************************************************************/ /**
+  * \brief Record that two classes are equal. The congruences this implies are found by the next rebuild()
+  * \returns the root of the merged class
+  ******************************************************************************/
+EGraph::ClassId EGraph::unite(ClassId a, ClassId b) {
+    a = find(a);
+    b = find(b);
+    if (a == b)
+        return a;
+    if (Classes[a].Nodes.size() < Classes[b].Nodes.size())
+        std::swap(a, b);
+    Parent[b] = a;
+    NumClasses--;
+    EClass &ca = Classes[a], &cb = Classes[b];
+    ca.Nodes.insert(ca.Nodes.end(), cb.Nodes.begin(), cb.Nodes.end());
+    cb.Nodes.clear();
+    if (!ca.HasConst && cb.HasConst) {
+        ca.HasConst = true;
+        ca.Value = cb.Value;
+    }
+    CostsValid = false;
+    return a;
+}
+
+EGraph::NodeKey EGraph::keyOf(const Node &n) const {
+    NodeKey k;
+    k.Op = n.Op;
+    k.Payload = n.Payload;
+    for (int i = 0; i < 3; i++)
+        k.Kids[i] = i < n.NumKids ? find(n.Kids[i]) : 0;
+    return k;
+}
+
+//! Set the operator, kind, payload and arity of a node for \a e
+void EGraph::classify(const Exp *e, Node &n) {
+    n.Op = e->getOper();
+    n.Proto = e;
+    n.Payload = nullptr;
+    n.NumKids = 0;
+    n.Kids[0] = n.Kids[1] = n.Kids[2] = 0;
+    if (dynamic_cast<const FlagDef *>(e)) {
+        n.Kind = OPAQUE; // Its RTL is not part of the expression; only equal to itself
+        n.Payload = e;
+        return;
+    }
+    if (e->getArity() == 0) {
+        n.Kind = LEAF;
+        return;
+    }
+    n.NumKids = e->getArity();
+    if (const RefExp *r = dynamic_cast<const RefExp *>(e)) {
+        n.Kind = REF;
+        n.Payload = const_cast<RefExp *>(r)->getDef();
+    } else if (const TypedExp *t = dynamic_cast<const TypedExp *>(e)) {
+        n.Kind = TYPED;
+        n.Payload = t->getType().get();
+    } else if (const Location *l = dynamic_cast<const Location *>(e)) {
+        n.Kind = LOCATION;
+        n.Payload = const_cast<Location *>(l)->getProc();
+    } else if (dynamic_cast<const Ternary *>(e))
+        n.Kind = TERNARY;
+    else if (dynamic_cast<const Binary *>(e))
+        n.Kind = BINARY;
+    else
+        n.Kind = UNARY;
+}
+
+/***************************************************************************/ /**
+  * \brief Add a node, unless an equal one exists
+  * \param n - the node; its children must already be in the graph. For a leaf, the payload is set to the first leaf
+  * added that is equal to it
+  * \returns the node, or the equal node that was there already
+  ******************************************************************************/
+EGraph::NodeId EGraph::addNode(Node &n) {
+    if (n.Kind == LEAF) {
+        auto it = Leaves.find(n.Proto);
+        if (it != Leaves.end())
+            return it->second;
+        n.Payload = n.Proto;
+    }
+    NodeKey key = keyOf(n);
+    auto it = Memo.find(key);
+    if (it != Memo.end())
+        return it->second;
+    for (int i = 0; i < n.NumKids; i++)
+        n.Kids[i] = key.Kids[i];
+    NodeId id = (NodeId)Nodes.size();
+    ClassId c = (ClassId)Classes.size();
+    Nodes.push_back(n);
+    NodeClass.push_back(c);
+    Dead.push_back(false);
+    Parent.push_back(c);
+    Classes.emplace_back();
+    Classes[c].Nodes.push_back(id);
+    NumClasses++;
+    if (n.Kind == LEAF) {
+        Leaves[n.Proto] = id;
+        if (n.Op == opIntConst) {
+            Classes[c].HasConst = true;
+            Classes[c].Value = ((const Const *)n.Proto)->getInt();
+        }
+    }
+    Memo[key] = id;
+    CostsValid = false;
+    return id;
+}
+
+EGraph::ClassId EGraph::addConst(int value) {
+    Const probe(value);
+    auto it = Leaves.find(&probe);
+    if (it != Leaves.end())
+        return find(NodeClass[it->second]);
+    Exp *c = new Const(value);
+    Owned.push_back(c);
+    Node n;
+    classify(c, n);
+    return find(NodeClass[addNode(n)]);
+}
+
+/***************************************************************************/ /**
+  * \brief Add an expression and all its subexpressions to the graph. The expression is not copied; it must not be
+  * changed or deleted before extract() has been called for it.
+  * \returns the class of \a e
+  ******************************************************************************/
+EGraph::ClassId EGraph::add(Exp *e) {
+    Node n;
+    classify(e, n);
+    if (n.NumKids >= 1)
+        n.Kids[0] = add(e->getSubExp1());
+    if (n.NumKids >= 2)
+        n.Kids[1] = add(e->getSubExp2());
+    if (n.NumKids >= 3)
+        n.Kids[2] = add(e->getSubExp3());
+    NodeId id = addNode(n);
+    Added[e] = id;
+    return find(NodeClass[id]);
+}
+
+//! Add the right hand side of a rule, with its variables replaced by the classes they are bound to
+EGraph::ClassId EGraph::addPattern(const Exp *pat, Subst &s) {
+    if (pat->getOper() == opVar) {
+        const ClassId *c = lookup(s, varName(pat));
+        assert(c);
+        return *c;
+    }
+    Node n;
+    classify(pat, n);
+    if (n.NumKids >= 1)
+        n.Kids[0] = addPattern(pat->getSubExp1(), s);
+    if (n.NumKids >= 2)
+        n.Kids[1] = addPattern(pat->getSubExp2(), s);
+    if (n.NumKids >= 3)
+        n.Kids[2] = addPattern(pat->getSubExp3(), s);
+    return find(NodeClass[addNode(n)]);
+}
+
+/***************************************************************************/ /**
+  * \brief Restore the invariants after classes were merged: nodes whose children are now the same classes are equal
+  * (congruence), so their classes are merged too, until there is nothing left to merge. Then the node lists of the
+  * classes are rebuilt without the duplicates.
+  ******************************************************************************/
+void EGraph::rebuild() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        Memo.clear();
+        for (NodeId n = 0; n < Nodes.size(); n++) {
+            NodeKey key = keyOf(Nodes[n]);
+            auto it = Memo.find(key);
+            if (it == Memo.end()) {
+                Memo[key] = n;
+                Dead[n] = false;
+                continue;
+            }
+            Dead[n] = true;
+            if (find(NodeClass[it->second]) != find(NodeClass[n])) {
+                unite(NodeClass[it->second], NodeClass[n]);
+                changed = true;
+            }
+        }
+    }
+    for (EClass &c : Classes)
+        c.Nodes.clear();
+    for (NodeId n = 0; n < Nodes.size(); n++) {
+        if (Dead[n])
+            continue;
+        Node &node = Nodes[n];
+        for (int i = 0; i < node.NumKids; i++)
+            node.Kids[i] = find(node.Kids[i]);
+        Classes[find(NodeClass[n])].Nodes.push_back(n);
+    }
+}
+
+bool EGraph::overBudget() const {
+    return Nodes.size() >= Limits.MaxNodes || Steps >= Limits.MaxSteps;
+}
+
+/***************************************************************************/ /**
+  * \brief Apply the built in facts to the first \a numNodes nodes: constant folding, the identities of 0, 1 and -1,
+  * commutativity, and regrouping (x op a) op b as x op (a op b) when a and b are constants
+  ******************************************************************************/
+void EGraph::applyBuiltins(size_t numNodes) {
+    for (NodeId id = 0; id < numNodes && !overBudget(); id++) {
+        Steps++;
+        if (Dead[id])
+            continue;
+        Node n = Nodes[id]; // A copy; adding nodes may move the vector
+        if (n.Kind != UNARY && n.Kind != BINARY)
+            continue;
+        ClassId c = find(NodeClass[id]);
+        ClassId x = find(n.Kids[0]);
+        const EClass &cx = Classes[x];
+        int res;
+        if (n.Kind == UNARY) {
+            if (cx.HasConst && !Classes[c].HasConst && foldUnary(n.Op, cx.Value, res))
+                unite(c, addConst(res));
+            continue;
+        }
+        ClassId y = find(n.Kids[1]);
+        bool kx = cx.HasConst, ky = Classes[y].HasConst;
+        int vx = cx.Value, vy = Classes[y].Value;
+        if (kx && ky) {
+            if (!Classes[c].HasConst && foldBinary(n.Op, vx, vy, res))
+                unite(c, addConst(res));
+            continue;
+        }
+        switch (n.Op) {
+        case opPlus:
+        case opBitOr:
+        case opBitXor:
+            if (kx && vx == 0)
+                unite(c, y);
+        // fall through
+        case opMinus:
+        case opShiftL:
+        case opShiftR:
+        case opShiftRA:
+            if (ky && vy == 0)
+                unite(c, x);
+            break;
+        case opMult:
+        case opMults:
+            if ((kx && vx == 0) || (ky && vy == 0))
+                unite(c, addConst(0));
+            else if (kx && vx == 1)
+                unite(c, y);
+            else if (ky && vy == 1)
+                unite(c, x);
+            break;
+        case opBitAnd:
+            if ((kx && vx == 0) || (ky && vy == 0))
+                unite(c, addConst(0));
+            else if (kx && vx == -1)
+                unite(c, y);
+            else if (ky && vy == -1)
+                unite(c, x);
+            break;
+        }
+        if (n.Op == opMinus && ky) {
+            // x - k == x + -k, so constants only have to be regrouped for opPlus
+            Node sum = n;
+            sum.Op = opPlus;
+            sum.Kids[1] = addConst((int)(0u - (uint32_t)vy));
+            unite(c, NodeClass[addNode(sum)]);
+        }
+        if (isCommutative(n.Op)) {
+            Node swapped = n;
+            std::swap(swapped.Kids[0], swapped.Kids[1]);
+            unite(c, NodeClass[addNode(swapped)]);
+        }
+        if (isAssociative(n.Op) && ky) {
+            std::vector<NodeId> inner = Classes[find(x)].Nodes; // A copy, for the same reason
+            for (NodeId i : inner) {
+                const Node &in = Nodes[i];
+                if (in.Op != n.Op || in.Kind != BINARY || !Classes[find(in.Kids[1])].HasConst)
+                    continue;
+                Node regrouped = in;
+                if (!foldBinary(n.Op, Classes[find(in.Kids[1])].Value, vy, res))
+                    continue;
+                regrouped.Kids[1] = addConst(res);
+                unite(c, NodeClass[addNode(regrouped)]);
+            }
+        }
+    }
+}
+
+const EGraph::ClassId *EGraph::lookup(const Subst &s, const QString &name) {
+    for (const auto &b : s)
+        if (b.first == name)
+            return &b.second;
+    return nullptr;
+}
+
+/***************************************************************************/ /**
+  * \brief Find the ways a pattern matches some node of a class
+  * \param pat - the pattern; opVar nodes are variables
+  * \param c - the class
+  * \param s - the bindings so far
+  * \param out - each binding that makes the pattern match is appended to this
+  ******************************************************************************/
+void EGraph::matchClass(const Exp *pat, ClassId c, Subst &s, std::vector<Subst> &out) const {
+    c = find(c);
+    if (pat->getOper() == opVar) {
+        const ClassId *bound = lookup(s, varName(pat));
+        if (bound == nullptr) {
+            out.push_back(s);
+            out.back().emplace_back(varName(pat), c);
+        } else if (find(*bound) == c)
+            out.push_back(s);
+        return;
+    }
+    int arity = pat->getArity();
+    for (NodeId id : Classes[c].Nodes) {
+        const Node &n = Nodes[id];
+        if (n.Op != pat->getOper() || n.NumKids != arity)
+            continue;
+        if (arity == 0) {
+            if (n.Kind == LEAF && *n.Proto == *pat)
+                out.push_back(s);
+            continue;
+        }
+        // Match the children left to right, each against every binding the previous ones allowed
+        std::vector<Subst> partial(1, s), next;
+        for (int i = 0; i < arity && !partial.empty(); i++) {
+            const Exp *sub = i == 0 ? pat->getSubExp1() : i == 1 ? pat->getSubExp2() : pat->getSubExp3();
+            next.clear();
+            for (Subst &p : partial)
+                matchClass(sub, n.Kids[i], p, next);
+            partial.swap(next);
+        }
+        out.insert(out.end(), partial.begin(), partial.end());
+    }
+}
+
+/***************************************************************************/ /**
+  * \brief Value of an integer expression of a rule condition: a constant, a variable bound to a class with a known
+  * constant value, or a call of plus() or neg()
+  ******************************************************************************/
+bool EGraph::evalInt(const Exp *e, const Subst &s, int &value) const {
+    switch (e->getOper()) {
+    case opIntConst:
+        value = ((const Const *)e)->getInt();
+        return true;
+    case opVar: {
+        const ClassId *c = lookup(s, varName(e));
+        if (c == nullptr || !Classes[find(*c)].HasConst)
+            return false;
+        value = Classes[find(*c)].Value;
+        return true;
+    }
+    case opFlagCall: {
+        QString func = ((const Const *)e->getSubExp1())->getStr();
+        const Exp *args = e->getSubExp2();
+        int a, b;
+        if (func == "neg")
+            return evalInt(args, s, a) && foldUnary(opNeg, a, value);
+        if (func == "plus" && args->getOper() == opList && args->getSubExp2()->getOper() == opList)
+            return evalInt(args->getSubExp1(), s, a) && evalInt(args->getSubExp2()->getSubExp1(), s, b) &&
+                   foldBinary(opPlus, a, b, value);
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+/***************************************************************************/ /**
+  * \brief Check the where clause of a rule. Supported are conjunctions of kind(x) == opXxx, and v == f(...) where v
+  * is not yet bound and f(...) is an integer function understood by evalInt(); v is then bound to the result.
+  ******************************************************************************/
+bool EGraph::checkCond(const Exp *cond, Subst &s) {
+    if (cond->getOper() == opAnd)
+        return checkCond(cond->getSubExp1(), s) && checkCond(cond->getSubExp2(), s);
+    if (cond->getOper() != opEquals)
+        return false;
+    const Exp *lhs = cond->getSubExp1(), *rhs = cond->getSubExp2();
+    if (lhs->getOper() == opKindOf && lhs->getSubExp1()->getOper() == opVar && rhs->getOper() == opStrConst) {
+        const ClassId *c = lookup(s, varName(lhs->getSubExp1()));
+        if (c == nullptr)
+            return false;
+        QString kind = ((const Const *)rhs)->getStr();
+        if (kind == "opIntConst")
+            return Classes[find(*c)].HasConst;
+        for (NodeId id : Classes[find(*c)].Nodes)
+            if (kind == operStrings[Nodes[id].Op])
+                return true;
+        return false;
+    }
+    if (lhs->getOper() == opVar && lookup(s, varName(lhs)) == nullptr) {
+        int value;
+        if (!evalInt(rhs, s, value))
+            return false;
+        s.emplace_back(varName(lhs), addConst(value));
+        return true;
+    }
+    return false;
+}
+
+//! Apply every rule to every class. All the matches are found before any is applied, so the order does not matter.
+//! The budget is checked while matching too, since finding the matches of many rules in a big graph takes a while
+void EGraph::applyRules() {
+    struct Match {
+        const GenericExpTransformer *Rule;
+        ClassId Class;
+        Subst Bindings;
+    };
+    std::vector<Match> matches;
+    std::vector<Subst> found;
+    Subst none;
+    for (const GenericExpTransformer *rule : Rules) {
+        for (ClassId c = 0; c < Classes.size(); c++) {
+            if (Parent[c] != c)
+                continue;
+            if (overBudget())
+                return;
+            Steps++;
+            found.clear();
+            matchClass(rule->getPattern(), c, none, found);
+            for (Subst &s : found)
+                matches.push_back({rule, c, std::move(s)});
+        }
+    }
+    for (Match &m : matches) {
+        if (overBudget())
+            break;
+        Steps++;
+        if (m.Rule->getWhere() && !checkCond(m.Rule->getWhere(), m.Bindings))
+            continue;
+        unite(m.Class, addPattern(m.Rule->getBecome(), m.Bindings));
+    }
+}
+
+/***************************************************************************/ /**
+  * \brief Apply the rules until nothing changes or the budget runs out
+  ******************************************************************************/
+void EGraph::saturate() {
+    Steps = 0;
+    Saturated = false;
+    rebuild();
+    for (Iterations = 0; Iterations < Limits.MaxIterations; Iterations++) {
+        size_t numNodes = Nodes.size(), numClasses = NumClasses;
+        applyBuiltins(numNodes);
+        applyRules();
+        rebuild();
+        if (overBudget())
+            break; // Even if nothing changed, since the rules may not all have been tried
+        if (Nodes.size() == numNodes && NumClasses == numClasses) {
+            Saturated = true;
+            break;
+        }
+    }
+    CostsValid = false;
+}
+
+/***************************************************************************/ /**
+  * \brief The size of the smallest expression for a node, given the best costs found so far for its children. A
+  * constant on the left of a commutative operator costs a little more, so x + 4 is preferred to 4 + x.
+  ******************************************************************************/
+unsigned EGraph::nodeCost(NodeId id) const {
+    const Node &n = Nodes[id];
+    unsigned cost = 2;
+    for (int i = 0; i < n.NumKids; i++) {
+        unsigned kid = Cost[find(n.Kids[i])];
+        if (kid == INFINITE_COST)
+            return INFINITE_COST;
+        cost += kid;
+    }
+    if (n.NumKids == 2 && isCommutative(n.Op) && Classes[find(n.Kids[0])].HasConst &&
+        !Classes[find(n.Kids[1])].HasConst)
+        cost++;
+    return cost;
+}
+
+void EGraph::computeCosts() {
+    Cost.assign(Classes.size(), INFINITE_COST);
+    BestNode.assign(Classes.size(), 0);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (NodeId id = 0; id < Nodes.size(); id++) {
+            if (Dead[id])
+                continue;
+            ClassId c = find(NodeClass[id]);
+            unsigned cost = nodeCost(id);
+            if (cost < Cost[c]) { // Ties go to the earlier node, i.e. the original expression
+                Cost[c] = cost;
+                BestNode[c] = id;
+                changed = true;
+            }
+        }
+    }
+    CostsValid = true;
+}
+
+Exp *EGraph::extractClass(ClassId c, Exp *hint) {
+    c = find(c);
+    if (hint) {
+        auto it = Added.find(hint);
+        if (it != Added.end() && find(NodeClass[it->second]) == c && nodeCost(it->second) == Cost[c]) {
+            // Nothing equal is smaller, so keep the expression; its subexpressions may still be replaced
+            const Node &n = Nodes[it->second];
+            for (int i = 0; i < n.NumKids; i++) {
+                Exp *sub = i == 0 ? hint->getSubExp1() : i == 1 ? hint->getSubExp2() : hint->getSubExp3();
+                Exp *res = extractClass(n.Kids[i], sub);
+                if (res == sub)
+                    continue;
+                if (i == 0)
+                    hint->setSubExp1(res);
+                else if (i == 1)
+                    hint->setSubExp2(res);
+                else
+                    hint->setSubExp3(res);
+            }
+            return hint;
+        }
+    }
+    Changed = true;
+    const Node &n = Nodes[BestNode[c]];
+    assert(Cost[c] != INFINITE_COST);
+    Exp *kids[3] = {nullptr, nullptr, nullptr};
+    for (int i = 0; i < n.NumKids; i++)
+        kids[i] = extractClass(n.Kids[i], nullptr);
+    OPER op = (OPER)n.Op;
+    switch (n.Kind) {
+    case UNARY:
+        return Unary::get(op, kids[0]);
+    case BINARY:
+        return Binary::get(op, kids[0], kids[1]);
+    case TERNARY:
+        return new Ternary(op, kids[0], kids[1], kids[2]);
+    case LOCATION:
+        return Location::get(op, kids[0], (UserProc *)n.Payload);
+    case REF:
+        return RefExp::get(kids[0], (Instruction *)n.Payload);
+    case TYPED:
+        return new TypedExp(((const TypedExp *)n.Proto)->getType(), kids[0]);
+    default:
+        return n.Proto->clone();
+    }
+}
+
+/***************************************************************************/ /**
+  * \brief Get the smallest expression equal to one that was added. Parts of \a e that are already smallest are kept
+  * (and \a e itself may be changed in place); the rest is built from new expressions.
+  ******************************************************************************/
+Exp *EGraph::extract(Exp *e) {
+    if (!CostsValid)
+        computeCosts();
+    auto it = Added.find(e);
+    assert(it != Added.end());
+    return extractClass(NodeClass[it->second], e);
+}
+
+/***************************************************************************/ /**
+  * \brief Simplify all the expressions of the statements of a procedure in one graph, so that the subexpressions
+  * they have in common are only simplified once. The left hand side of an assignment is left alone, except for the
+  * address of a memory location.
+  ******************************************************************************/
+void EGraph::simplifyProc(UserProc *proc) {
+    StatementList stmts;
+    proc->getStatements(stmts);
+    EGraph graph(DefaultBudget);
+    EGraphModifier em(graph);
+    StmtPartModifier sm(&em, true); // Not the collectors; they only hold subscripted locations
+    for (Instruction *s : stmts)
+        s->accept(&sm);
+    graph.saturate();
+    em.Extracting = true;
+    for (Instruction *s : stmts)
+        s->accept(&sm);
+    LOG_VERBOSE(1) << "e-graph for " << proc->getName() << ": " << (int)graph.getNumNodes() << " nodes, "
+                   << (int)graph.getNumClasses() << " classes, " << graph.getNumIterations() << " iterations"
+                   << (graph.isSaturated() ? "" : " (budget reached)") << "\n";
+}
@@ -0,0 +1,140 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ */
+/***************************************************************************/ /**
+  * \file       egraph.h
+  * \brief   Provides the definition for the equality saturation simplifier.
+  ******************************************************************************/
+
+#ifndef EGRAPH_H
+#define EGRAPH_H
+
+#include "exphelp.h"
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Exp;
+class UserProc;
+class GenericExpTransformer;
+
+/***************************************************************************/ /**
+  * \class EGraph
+  * An e-graph: a set of equivalence classes of expression nodes, where the children of a node are classes rather than
+  * expressions. Expressions are added, then the graph is saturated: the rules of the loaded GenericExpTransformers
+  * and a few built in arithmetic facts (constant folding, identities, commutativity, regrouping of constants) are
+  * applied to every class at once, and each rule only adds equalities, so the result does not depend on the order
+  * the rules are tried in. Saturation stops when nothing new is found or the budget runs out. Finally the smallest
+  * equivalent of each added expression is extracted.
+  *
+  * All the expressions of a procedure can be added to one graph (see simplifyProc), so a subterm that occurs in
+  * several statements is only simplified once.
+  ******************************************************************************/
+class EGraph {
+  public:
+    //! Limits on the work done by saturate()
+    struct Budget {
+        size_t MaxNodes = 20000;   //!< Stop adding nodes after this many
+        int MaxIterations = 8;     //!< Rounds of rule application
+        size_t MaxSteps = 1000000; //!< Nodes visited by the built in facts, plus rule match attempts and applications
+    };
+    typedef uint32_t ClassId;
+
+    explicit EGraph(const Budget &budget);
+    EGraph(const EGraph &) = delete;
+    EGraph &operator=(const EGraph &) = delete;
+    ~EGraph();
+
+    ClassId add(Exp *e);
+    void saturate();
+    Exp *extract(Exp *e);
+
+    size_t getNumNodes() const { return Nodes.size(); }
+    size_t getNumClasses() const { return NumClasses; }
+    int getNumIterations() const { return Iterations; }
+    bool isSaturated() const { return Saturated; } //!< False if saturate() stopped because of the budget
+
+    static void simplifyProc(UserProc *proc);
+    static Budget DefaultBudget; //!< Used by simplifyProc()
+
+  private:
+    typedef uint32_t NodeId;
+    typedef std::vector<std::pair<QString, ClassId>> Subst; //!< Pattern variable bindings
+    //! How a node is turned back into an expression
+    enum NodeKind { LEAF, OPAQUE, UNARY, BINARY, TERNARY, LOCATION, REF, TYPED };
+    struct Node {
+        int Op;
+        NodeKind Kind;
+        int NumKids;
+        ClassId Kids[3];
+        const Exp *Proto;    //!< Expression the node was made from: the whole leaf, or the source of the payload
+        const void *Payload; //!< Proc of a Location, def of a RefExp, type of a TypedExp, canonical leaf
+    };
+    struct NodeKey {
+        int Op;
+        const void *Payload;
+        ClassId Kids[3];
+        bool operator==(const NodeKey &o) const {
+            return Op == o.Op && Payload == o.Payload && Kids[0] == o.Kids[0] && Kids[1] == o.Kids[1] &&
+                   Kids[2] == o.Kids[2];
+        }
+    };
+    struct NodeKeyHash {
+        size_t operator()(const NodeKey &k) const;
+    };
+    struct EClass {
+        std::vector<NodeId> Nodes; //!< Distinct nodes of the class; only valid for a root, after rebuild()
+        bool HasConst = false;     //!< True if the class is known to equal an integer constant
+        int Value = 0;
+    };
+
+    ClassId find(ClassId c) const;
+    ClassId unite(ClassId a, ClassId b);
+    NodeKey keyOf(const Node &n) const;
+    NodeId addNode(Node &n);
+    ClassId addConst(int value);
+    ClassId addPattern(const Exp *pat, Subst &s);
+    void rebuild();
+    bool overBudget() const;
+
+    void applyBuiltins(size_t numNodes);
+    void applyRules();
+    void matchClass(const Exp *pat, ClassId c, Subst &s, std::vector<Subst> &out) const;
+    bool checkCond(const Exp *cond, Subst &s);
+    bool evalInt(const Exp *e, const Subst &s, int &value) const;
+    static const ClassId *lookup(const Subst &s, const QString &name);
+    static void classify(const Exp *e, Node &n);
+
+    unsigned nodeCost(NodeId n) const;
+    void computeCosts();
+    Exp *extractClass(ClassId c, Exp *hint);
+
+    Budget Limits;
+    std::vector<Node> Nodes;
+    std::vector<ClassId> NodeClass; //!< Class each node was added to (not necessarily a root)
+    std::vector<bool> Dead;         //!< Node found to be a duplicate of an earlier one by rebuild()
+    mutable std::vector<ClassId> Parent;
+    std::vector<EClass> Classes;
+    size_t NumClasses = 0;
+    std::unordered_map<NodeKey, NodeId, NodeKeyHash> Memo; //!< Distinct node with each key
+    std::map<const Exp *, NodeId, lessExpStar> Leaves; //!< Leaf expressions, compared by value
+    std::unordered_map<const Exp *, NodeId> Added;     //!< Node of each added expression and its subexpressions
+    std::vector<Exp *> Owned;                          //!< Constants created by constant folding
+    std::vector<const GenericExpTransformer *> Rules;
+    std::vector<unsigned> Cost;
+    std::vector<NodeId> BestNode;
+    int Iterations = 0;
+    bool Saturated = false;
+    bool CostsValid = false;
+    bool Changed = false; //!< Set by extract() when an expression was replaced
+    size_t Steps = 0; //!< Work done by this saturate(), counted against Limits.MaxSteps
+};
+
+#endif
@@ -221,18 +221,21 @@ Exp *GenericExpTransformer::applyTo(Exp *e, bool &bMod) {
             return e;
     }
 
-    LOG << "applying generic exp transformer match: " << match;
-    if (where)
-        LOG << " where: " << where;
-    LOG << " become: " << become;
-    LOG << " to: " << e;
-    LOG << " bindings: " << bindings << "\n";
+    if (VERBOSE) {
+        LOG << "applying generic exp transformer match: " << match;
+        if (where)
+            LOG << " where: " << where;
+        LOG << " become: " << become;
+        LOG << " to: " << e;
+        LOG << " bindings: " << bindings << "\n";
+    }
 
     e = become->clone();
     for (Exp *l = bindings; l->getOper() != opNil; l = l->getSubExp2())
         e = e->searchReplaceAll(*l->getSubExp1()->getSubExp1(), l->getSubExp1()->getSubExp2(), change);
 
-    LOG << "calculated result: " << e << "\n";
+    if (VERBOSE)
+        LOG << "calculated result: " << e << "\n";
     bMod = true;
 
     Exp *r;
@@ -20,6 +20,9 @@ class GenericExpTransformer : public ExpTransformer {
 
   public:
     GenericExpTransformer(Exp *_match, Exp *_where, Exp *_become) : match(_match), where(_where), become(_become) {}
+    const Exp *getPattern() const override { return match; }
+    const Exp *getWhere() const { return where; } //!< Condition of the rule, or nullptr
+    const Exp *getBecome() const { return become; }
     virtual Exp *applyTo(Exp *e, bool &bMod);
 };
 
@@ -0,0 +1,129 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ */
+/***************************************************************************/ /**
+  * \file       ruleindex.cpp
+  * OVERVIEW:   Implementation of the RuleIndex class.
+  ******************************************************************************/
+
+#include "ruleindex.h"
+
+#include "exp.h"
+#include "transformer.h"
+
+#include <algorithm>
+#include <cassert>
+
+const RuleIndex::Key RuleIndex::STAR;
+
+RuleIndex::RuleIndex() : Nodes(1) {}
+
+/***************************************************************************/ /**
+  * \brief The key of one node of a pattern or expression: its operator and arity, and for integer constants the
+  * value (a pattern constant only matches an equal constant). Other constants are only distinguished by operator;
+  * the full match done by the rule sorts them out.
+  ******************************************************************************/
+RuleIndex::Key RuleIndex::keyOf(const Exp *e) {
+    Key key = ((Key)e->getOper() << 40) | ((Key)e->getArity() << 36);
+    if (e->getOper() == opIntConst)
+        key |= ((Key)1 << 32) | (uint32_t)((const Const *)e)->getInt();
+    return key;
+}
+
+void RuleIndex::flattenPattern(const Exp *e, std::vector<Key> &keys) {
+    if (e->getOper() == opVar) {
+        keys.push_back(STAR); // Matches any subexpression
+        return;
+    }
+    keys.push_back(keyOf(e));
+    int arity = e->getArity();
+    if (arity >= 1)
+        flattenPattern(e->getSubExp1(), keys);
+    if (arity >= 2)
+        flattenPattern(e->getSubExp2(), keys);
+    if (arity >= 3)
+        flattenPattern(e->getSubExp3(), keys);
+}
+
+/***************************************************************************/ /**
+  * \brief Add a rule to the index. Rules are numbered in the order they are added
+  ******************************************************************************/
+void RuleIndex::add(ExpTransformer *rule) {
+    size_t n = Rules.size();
+    Rules.push_back(rule);
+    const Exp *pattern = rule->getPattern();
+    if (pattern == nullptr) {
+        AnyRules.push_back(n);
+        return;
+    }
+    std::vector<Key> keys;
+    flattenPattern(pattern, keys);
+    int node = 0;
+    for (Key key : keys) {
+        int next;
+        if (key == STAR) {
+            next = Nodes[node].Star;
+            if (next < 0) {
+                next = (int)Nodes.size();
+                Nodes[node].Star = next;
+                Nodes.emplace_back();
+            }
+        } else {
+            auto it = Nodes[node].Children.find(key);
+            if (it != Nodes[node].Children.end())
+                next = it->second;
+            else {
+                next = (int)Nodes.size();
+                Nodes[node].Children[key] = next;
+                Nodes.emplace_back(); // Invalidates references into Nodes, hence the indices
+            }
+        }
+        node = next;
+    }
+    Nodes[node].Rules.push_back(n);
+}
+
+void RuleIndex::flattenQuery(const Exp *e) const {
+    size_t pos = QueryKeys.size();
+    QueryKeys.push_back(keyOf(e));
+    QueryEnd.push_back(0);
+    int arity = e->getArity();
+    if (arity >= 1)
+        flattenQuery(e->getSubExp1());
+    if (arity >= 2)
+        flattenQuery(e->getSubExp2());
+    if (arity >= 3)
+        flattenQuery(e->getSubExp3());
+    QueryEnd[pos] = QueryKeys.size();
+}
+
+void RuleIndex::collect(int node, size_t pos, std::vector<size_t> &result) const {
+    const Node &n = Nodes[node];
+    if (pos == QueryKeys.size()) {
+        result.insert(result.end(), n.Rules.begin(), n.Rules.end());
+        return;
+    }
+    if (n.Star >= 0)
+        collect(n.Star, QueryEnd[pos], result);
+    auto it = n.Children.find(QueryKeys[pos]);
+    if (it != n.Children.end())
+        collect(it->second, pos + 1, result);
+}
+
+/***************************************************************************/ /**
+  * \brief Find the rules that may match an expression
+  * \param e - the expression
+  * \param result - set to the numbers of the candidate rules, in increasing order. Every rule that matches \a e is
+  * included; some of the others may not match.
+  ******************************************************************************/
+void RuleIndex::candidates(const Exp *e, std::vector<size_t> &result) const {
+    result = AnyRules;
+    QueryKeys.clear();
+    QueryEnd.clear();
+    flattenQuery(e);
+    collect(0, 0, result);
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
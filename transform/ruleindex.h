@@ -0,0 +1,61 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ */
+/***************************************************************************/ /**
+  * \file       ruleindex.h
+  * \brief   Provides the definition for the index of the transformation rules.
+  ******************************************************************************/
+
+#ifndef RULE_INDEX_H
+#define RULE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class Exp;
+class ExpTransformer;
+
+/***************************************************************************/ /**
+  * \class RuleIndex
+  * A discrimination tree over the match patterns of the loaded transformers. The patterns are flattened to the
+  * preorder sequence of their operators (pattern variables become wildcards that stand for a whole subexpression),
+  * and these sequences are merged into a tree. For a given expression only the rules whose sequence can match the
+  * operators of the expression are returned, so applyAllTo does not have to try every rule on every node.
+  * Transformers without a pattern are returned for every expression.
+  ******************************************************************************/
+class RuleIndex {
+  public:
+    RuleIndex();
+
+    void add(ExpTransformer *rule);
+    void candidates(const Exp *e, std::vector<size_t> &result) const;
+    ExpTransformer *getRule(size_t n) const { return Rules[n]; }
+    size_t size() const { return Rules.size(); }
+    size_t getNumNodes() const { return Nodes.size(); }
+
+  private:
+    typedef uint64_t Key;
+    struct Node {
+        std::map<Key, int> Children; //!< Node index for each operator key
+        int Star = -1;               //!< Node index after a wildcard, if any
+        std::vector<size_t> Rules;   //!< Rules whose pattern ends here
+    };
+    static const Key STAR = ~(Key)0; //!< Stands for a pattern variable
+    static Key keyOf(const Exp *e);
+    static void flattenPattern(const Exp *e, std::vector<Key> &keys);
+    void flattenQuery(const Exp *e) const;
+    void collect(int node, size_t pos, std::vector<size_t> &result) const;
+
+    std::vector<Node> Nodes; //!< Nodes[0] is the root
+    std::vector<ExpTransformer *> Rules;
+    std::vector<size_t> AnyRules; //!< Rules without a pattern
+    // The expression being looked up, in preorder; reused to avoid allocating for every lookup
+    mutable std::vector<Key> QueryKeys;
+    mutable std::vector<size_t> QueryEnd; //!< Index just past the subexpression starting at each position
+};
+
+#endif
@@ -17,6 +17,8 @@
 #include "proc.h"
 #include "boomerang.h"
 #include "rdi.h"
+#include "ruleindex.h"
+#include "arena.h"
 #include "log.h"
 #include "transformation-parser.h"
 
@@ -30,15 +32,51 @@
 #include <sstream>   // Need gcc 3.0 or better
 
 std::list<ExpTransformer *> ExpTransformer::transformers;
+RuleIndex *ExpTransformer::ruleIndex = nullptr;
+bool ExpTransformer::useRuleIndex = true;
 
-ExpTransformer::ExpTransformer() { transformers.push_back(this); }
+ExpTransformer::ExpTransformer() {
+    transformers.push_back(this);
+    // The index no longer covers all the transformers
+    delete ruleIndex;
+    ruleIndex = nullptr;
+}
 
-std::list<Exp *> cache;
+//! Results of applyAllTo, by argument. Owns its keys and values, which are on the heap since they outlive the procs.
+static std::map<Exp *, Exp *, lessExpStar> cache;
+//! The cache is emptied when it gets this big, so a long decompilation doesn't keep every expression it ever saw
+static const size_t MAX_CACHED = 10000;
 
+/***************************************************************************/ /**
+  * \brief Build the index of the transformers, so applyAllTo only tries the ones that can match
+  ******************************************************************************/
+void ExpTransformer::compileRules() {
+    delete ruleIndex;
+    ruleIndex = new RuleIndex;
+    for (ExpTransformer *t : transformers)
+        ruleIndex->add(t);
+}
+
+//! Forget the results of earlier calls of applyAllTo
+void ExpTransformer::clearCache() {
+    for (auto &cc : cache) {
+        delete cc.first;
+        delete cc.second;
+    }
+    cache.clear();
+}
+
+/***************************************************************************/ /**
+  * \brief Apply the transformers to the subexpressions of an expression, then to the expression itself, in the
+  * order they were loaded
+  * \param p - the expression; not changed
+  * \param bMod - set to true if any transformer changed something
+  * \returns the transformed copy of \a p
+  ******************************************************************************/
 Exp *ExpTransformer::applyAllTo(Exp *p, bool &bMod) {
-    for (auto &elem : cache)
-        if (*(elem)->getSubExp1() == *p)
-            return (elem)->getSubExp2()->clone();
+    auto cached = cache.find(p);
+    if (cached != cache.end())
+        return cached->second->clone();
 
     Exp *e = p->clone();
     Exp *subs[3];
@@ -66,13 +104,40 @@ Exp *ExpTransformer::applyAllTo(Exp *p, bool &bMod) {
     bool mod;
     // do {
     mod = false;
-    for (auto &transformer : transformers) {
-        e = (transformer)->applyTo(e, mod);
+    if (useRuleIndex) {
+        if (ruleIndex == nullptr)
+            compileRules();
+        // Same as the loop below, but only trying the transformers that can match the current expression. When one
+        // changes it, the candidates after that one are looked up again for the new expression
+        std::vector<size_t> candidates;
+        size_t next = 0;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            ruleIndex->candidates(e, candidates);
+            for (auto it = std::lower_bound(candidates.begin(), candidates.end(), next); it != candidates.end();
+                 ++it) {
+                bool m = false;
+                e = ruleIndex->getRule(*it)->applyTo(e, m);
+                if (m) {
+                    mod = changed = true;
+                    next = *it + 1;
+                    break;
+                }
+            }
+        }
         bMod |= mod;
+    } else {
+        for (auto &transformer : transformers) {
+            e = (transformer)->applyTo(e, mod);
+            bMod |= mod;
+        }
     }
     //} while (mod);
 
-    cache.push_back(Binary::get(opEquals, p->clone(), e->clone()));
+    if (cache.size() >= MAX_CACHED)
+        clearCache();
+    cache[onHeap([p] { return p->clone(); })] = onHeap([e] { return e->clone(); });
     return e;
 }
 
@@ -110,4 +175,5 @@ void ExpTransformer::loadAll() {
         p->yyparse();
         ifs1.close();
     }
+    compileRules();
 }
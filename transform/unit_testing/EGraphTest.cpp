@@ -0,0 +1,141 @@
+/***************************************************************************/ /**
+  * \file       EGraphTest.cpp
+  * OVERVIEW:   Provides the implementation for the EGraphTest class, which tests the equality saturation simplifier
+  ******************************************************************************/
+
+#include "EGraphTest.h"
+
+#include "egraph.h"
+#include "generic.h"
+#include "exp.h"
+
+
+/***************************************************************************/ /**
+  * \fn        EGraphTest::testConstantFolding
+  * OVERVIEW:  (3 + 4) * 2 is folded to 14
+  ******************************************************************************/
+void EGraphTest::testConstantFolding() {
+    Exp *e = Binary::get(opMult, Binary::get(opPlus, new Const(3), new Const(4)), new Const(2));
+    EGraph::Budget budget;
+    EGraph graph(budget);
+    graph.add(e);
+    graph.saturate();
+    QVERIFY(graph.isSaturated());
+    Exp *res = graph.extract(e);
+    QVERIFY(res->isIntConst());
+    QCOMPARE(((Const *)res)->getInt(), 14);
+}
+
+/***************************************************************************/ /**
+  * \fn        EGraphTest::testIdentities
+  * OVERVIEW:  r24 + 0, 1 * r25 and r26 & -1 are their register; r27 * 0 is 0
+  ******************************************************************************/
+void EGraphTest::testIdentities() {
+    Exp *plus = Binary::get(opPlus, Location::regOf(24), new Const(0));
+    Exp *mult = Binary::get(opMult, new Const(1), Location::regOf(25));
+    Exp *bitAnd = Binary::get(opBitAnd, Location::regOf(26), new Const(-1));
+    Exp *zero = Binary::get(opMult, Location::regOf(27), new Const(0));
+    EGraph::Budget budget;
+    EGraph graph(budget);
+    graph.add(plus);
+    graph.add(mult);
+    graph.add(bitAnd);
+    graph.add(zero);
+    graph.saturate();
+    QVERIFY(*graph.extract(plus) == *Location::regOf(24));
+    QVERIFY(*graph.extract(mult) == *Location::regOf(25));
+    QVERIFY(*graph.extract(bitAnd) == *Location::regOf(26));
+    Exp *res = graph.extract(zero);
+    QVERIFY(res->isIntConst());
+    QCOMPARE(((Const *)res)->getInt(), 0);
+}
+
+/***************************************************************************/ /**
+  * \fn        EGraphTest::testKeepOriginal
+  * OVERVIEW:  r24 + r25 is equal to r25 + r24, which is no smaller, so the original expression is kept
+  ******************************************************************************/
+void EGraphTest::testKeepOriginal() {
+    Exp *e = Binary::get(opPlus, Location::regOf(24), Location::regOf(25));
+    Exp *orig = e->clone();
+    EGraph::Budget budget;
+    EGraph graph(budget);
+    graph.add(e);
+    graph.saturate();
+    QVERIFY(graph.getNumNodes() > 5); // r25 + r24 was added
+    Exp *res = graph.extract(e);
+    QCOMPARE(res, e);
+    QVERIFY(*res == *orig);
+}
+
+/***************************************************************************/ /**
+  * \fn        EGraphTest::testIterationBudget
+  * OVERVIEW:  Regrouping ((r24 + 1) + 2) + 3 takes more than one round, so one round does not saturate
+  ******************************************************************************/
+void EGraphTest::testIterationBudget() {
+    Exp *e = Binary::get(opPlus, Binary::get(opPlus, Binary::get(opPlus, Location::regOf(24), new Const(1)),
+                                             new Const(2)),
+                         new Const(3));
+    EGraph::Budget budget;
+    budget.MaxIterations = 1;
+    EGraph graph(budget);
+    graph.add(e);
+    graph.saturate();
+    QCOMPARE(graph.getNumIterations(), 1);
+    QVERIFY(!graph.isSaturated());
+}
+
+/***************************************************************************/ /**
+  * \fn        EGraphTest::testNodeBudget
+  * OVERVIEW:  With no room for more nodes, saturate() adds none and says it was stopped by the budget
+  ******************************************************************************/
+void EGraphTest::testNodeBudget() {
+    Exp *e = Binary::get(opPlus, Binary::get(opPlus, Location::regOf(24), new Const(1)), new Const(2));
+    EGraph::Budget budget;
+    budget.MaxNodes = 6; // 24, r24, 1, r24 + 1, 2 and the whole sum
+    EGraph graph(budget);
+    graph.add(e);
+    size_t numNodes = graph.getNumNodes();
+    QVERIFY(numNodes >= budget.MaxNodes);
+    graph.saturate();
+    QCOMPARE(graph.getNumNodes(), numNodes);
+    QVERIFY(!graph.isSaturated());
+    QCOMPARE(graph.extract(e), e);
+}
+
+/***************************************************************************/ /**
+  * \fn        EGraphTest::testStepBudget
+  * OVERVIEW:  With a budget of one step, saturate() folds nothing and says it was stopped by the budget
+  ******************************************************************************/
+void EGraphTest::testStepBudget() {
+    Exp *e = Binary::get(opPlus, new Const(3), new Const(4));
+    EGraph::Budget budget;
+    budget.MaxSteps = 1; // Only the first node, the constant 3, is looked at
+    EGraph graph(budget);
+    graph.add(e);
+    graph.saturate();
+    QCOMPARE(graph.getNumIterations(), 0);
+    QVERIFY(!graph.isSaturated());
+    QCOMPARE(graph.extract(e), e);
+}
+
+/***************************************************************************/ /**
+  * \fn        EGraphTest::testRuleSaturation
+  * OVERVIEW:  The rule x - x -> 0 is applied, after which nothing changes and the graph is saturated. This test
+  *            comes last, since the rule stays loaded
+  ******************************************************************************/
+void EGraphTest::testRuleSaturation() {
+    Exp *x = new Unary(opVar, new Const(QString("x")));
+    new GenericExpTransformer(Binary::get(opMinus, x, x->clone()), nullptr, new Const(0));
+    Exp *e = Binary::get(opMinus, Location::memOf(Location::regOf(28)), Location::memOf(Location::regOf(28)));
+    EGraph::Budget budget;
+    EGraph graph(budget);
+    graph.add(e);
+    graph.saturate();
+    QVERIFY(graph.isSaturated());
+    QVERIFY(graph.getNumIterations() < budget.MaxIterations);
+    Exp *res = graph.extract(e);
+    QVERIFY(res->isIntConst());
+    QCOMPARE(((Const *)res)->getInt(), 0);
+}
+
+QTEST_MAIN(EGraphTest)
@@ -0,0 +1,13 @@
+#include <QtTest/QTest>
+
+class EGraphTest : public QObject {
+    Q_OBJECT
+  private slots:
+    void testConstantFolding();
+    void testIdentities();
+    void testKeepOriginal();
+    void testIterationBudget();
+    void testNodeBudget();
+    void testStepBudget();
+    void testRuleSaturation();
+};
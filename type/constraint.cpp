@@ -105,7 +105,8 @@ void ConstraintMap::substitute(ConstraintMap &other) {
     for (oo = other.cmap.begin(); oo != other.cmap.end(); oo++) {
         bool ch;
         for (cc = cmap.begin(); cc != cmap.end(); cc++) {
-            Exp *newVal = cc->second->searchReplaceAll(*oo->first, oo->second, ch);
+            // substitute() leaves the old key and value unchanged, so the map stays ordered
+            Exp *newVal = cc->second->substitute(*oo->first, oo->second, ch);
             if (ch) {
                 if (*cc->first == *newVal)
                     // e.g. was <char*> = <alpha6> now <char*> = <char*>
@@ -115,7 +116,7 @@ void ConstraintMap::substitute(ConstraintMap &other) {
             } else
                 // The existing value
                 newVal = cc->second;
-            Exp *newKey = cc->first->searchReplaceAll(*oo->first, oo->second, ch);
+            Exp *newKey = cc->first->substitute(*oo->first, oo->second, ch);
             if (ch) {
                 cmap.erase(cc->first);
                 // Often end up with <char*> = <char*>
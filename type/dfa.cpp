@@ -194,7 +194,7 @@ void UserProc::dfaTypeAnalysis() {
                 } else if (baseType->resolvesToArray()) {
                     // We have found a constant in s which has type pointer to array of alpha. We can't get the parent
                     // of con, but we can find it with the pattern unscaledArrayPat.
-                    std::list<Exp *> result;
+                    ExpMatches result;
                     s->searchAll(unscaledArrayPat, result);
                     for (auto &elem : result) {
                         // idx + K
@@ -4,6 +4,10 @@
 #include "config.h"
 #include "boomerang.h"
 #include "commandlinedriver.h"
+#include "exp.h"
+#include "proc.h"
+#include "transformer.h"
+#include "transform/egraph.h"
 
 #ifdef HAVE_LIBGC
 #include "gc.h"
@@ -29,13 +33,19 @@ static void help() {
     q_cout << "  -E <addr>        : Decode the procedure at addr, no callees\n";
     q_cout << "                     Use -e and -E repeatedly for multiple entry points\n";
     q_cout << "  -ic              : Decode through type 0 Indirect Calls\n";
+    q_cout << "  -ir              : Incremental re-decode: only decode the new targets of analysed indirect jumps\n";
+    q_cout << "  -pp              : Pruned SSA: only place phi functions where the location is live\n";
+    q_cout << "  -pb <steps>      : Give up a preservation proof after steps steps (default 100000; 0 for no limit)\n";
     q_cout << "  -S <min>         : Stop decompilation after specified number of minutes\n";
     q_cout << "  -t               : Trace (print address of) every instruction decoded\n";
+    q_cout << "  -tr              : Simplify with the rules in transformations/ instead of the built in simplifier\n";
+    q_cout << "  -te              : Simplify each procedure with an e-graph of its expressions (equality saturation)\n";
     q_cout << "  -Tc              : Use old constraint-based type analysis\n";
     q_cout << "  -Td              : Use data-flow-based type analysis\n";
     q_cout << "  -LD              : Load before decompile (<program> becomes xml input file)\n";
     q_cout << "  -SD              : Save before decompile\n";
     q_cout << "  -a               : Assume ABI compliance\n";
+    q_cout << "  -A               : Allocate expressions and statements from per procedure arenas\n";
     q_cout << "  -W               : Windows specific decompilation mode (requires pdb information)\n";
     //    q_cout << "  -pa              : only propagate if can propagate to all\n";
     q_cout << "Output\n";
@@ -82,6 +92,7 @@ static void help() {
     q_cout << "  -nr              : No removal of unneeded labels\n";
     q_cout << "  -nR              : No removal of unused Returns\n";
     q_cout << "  -l <depth>       : Limit multi-propagations to expressions with depth <depth>\n";
+    q_cout << "  -lm              : Find out of SSA interferences with LocationSets and a multimap, not bit vectors\n";
     q_cout << "  -p <num>         : Only do num propagations\n";
     q_cout << "  -m <num>         : Max memory depth\n";
 }
@@ -152,7 +163,12 @@ int CommandlineDriver::applyCommandline(const QStringList &args) {
             boom.printRtl = true;
             break;
         case 't':
-            boom.traceDecoder = true;
+            if (arg[2] == 'r')
+                boom.ruleSimplify = true; // -tr
+            else if (arg[2] == 'e')
+                boom.egraphSimplify = true; // -te
+            else
+                boom.traceDecoder = true;
             break;
         case 'T':
             if (arg[2] == 'c') {
@@ -181,6 +197,8 @@ int CommandlineDriver::applyCommandline(const QStringList &args) {
         case 'i':
             if (arg[2] == 'c')
                 boom.decodeThruIndCall = true; // -ic;
+            else if (arg[2] == 'r')
+                boom.incrementalRedecode = true; // -ir
             break;
         case '-':
             break; // No effect: ignored
@@ -246,6 +264,14 @@ int CommandlineDriver::applyCommandline(const QStringList &args) {
             if (arg[2] == 'a') {
                 boom.propOnlyToAll = true;
                 LOG_STREAM() << " * * Warning! -pa is not implemented yet!\n";
+            } else if (arg[2] == 'p') {
+                boom.prunedPhis = true; // -pp
+            } else if (arg[2] == 'b') {
+                if (++i == args.size()) { // -pb <steps>
+                    usage();
+                    return 1;
+                }
+                boom.proofBudget = args[i].toInt();
             } else {
                 if (++i == args.size()) {
                     usage();
@@ -316,7 +342,14 @@ int CommandlineDriver::applyCommandline(const QStringList &args) {
         case 'a':
             boom.assumeABI = true;
             break;
+        case 'A':
+            boom.arenaAlloc = true;
+            break;
         case 'l':
+            if (arg[2] == 'm') {
+                boom.mapLiveness = true; // -lm
+                break;
+            }
             if (++i == args.size()) {
                 usage();
                 return 1;
@@ -381,6 +414,14 @@ void CommandlineDriver::onCompilationTimeout() {
 
 void DecompilationThread::run() {
     Boomerang &boom(*Boomerang::get());
+    if (boom.ruleSimplify || boom.egraphSimplify) {
+        LOG_STREAM() << "setting up transformers...\n";
+        ExpTransformer::loadAll();
+    }
+    if (boom.ruleSimplify)
+        Exp::ruleSimplifier = ExpTransformer::applyAllTo;
+    if (boom.egraphSimplify)
+        UserProc::procSimplifier = EGraph::simplifyProc;
     Result = boom.decompile(m_decompiled);
     boom.getLogStream().flush();
     boom.getLogStream(LL_Error).flush();